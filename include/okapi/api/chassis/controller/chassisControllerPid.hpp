@@ -9,11 +9,13 @@
 
 #include "okapi/api/chassis/controller/chassisController.hpp"
 #include "okapi/api/control/iterative/iterativePosPidController.hpp"
+#include "okapi/api/control/util/controlLoopExecutor.hpp"
 #include "okapi/api/util/abstractRate.hpp"
 #include "okapi/api/util/logging.hpp"
 #include "okapi/api/util/timeUtil.hpp"
 #include <atomic>
 #include <memory>
+#include <valarray>
 
 namespace okapi {
 class ChassisControllerPID : public virtual ChassisController {
@@ -112,6 +114,14 @@ class ChassisControllerPID : public virtual ChassisController {
    */
   void startThread();
 
+  /**
+   * Runs the control loop on an executor instead of in its own task. The loop period must be a
+   * multiple of the executor's base period. Do not also call startThread().
+   *
+   * @param iexecutor The executor to run on.
+   */
+  void runOn(const std::shared_ptr<ControlLoopExecutor> &iexecutor);
+
   /**
    * Get the ChassisScales.
    */
@@ -133,17 +143,46 @@ class ChassisControllerPID : public virtual ChassisController {
   std::atomic_bool doneLooping{true};
   std::atomic_bool newMovement{false};
   std::atomic_bool dtorCalled{false};
+  // Whether the PID controllers of the current mode settled, as of the last step. Checking them
+  // changes their state, so only step() checks them.
+  std::atomic_bool movementSettled{false};
+
+  static constexpr QTime loopPeriod = 10_ms;
 
   static void trampoline(void *context);
   void loop();
 
+  /**
+   * Runs one iteration of the control loop.
+   */
+  void step();
+
   bool waitForDistanceSettled();
   bool waitForAngleSettled();
   void stopAfterSettled();
 
+  /**
+   * Records whether the current movement settled and wakes the waiting tasks if it did. Only call
+   * this from step().
+   *
+   * @param isettled Whether the PID controllers of the current mode settled.
+   */
+  void updateSettled(bool isettled);
+
+  /**
+   * Wakes the tasks waiting in waitUntilSettled() so they check whether the controller settled.
+   */
+  void notifySettled();
+
   typedef enum { distance, angle, none } modeType;
   modeType mode{none};
+  modeType pastMode{none};
+  std::valarray<std::int32_t> encStartVals{};
 
   CrossplatformThread *task{nullptr};
+  std::shared_ptr<ControlLoopExecutor> executor{nullptr};
+  std::uint32_t executorId{0};
+  CrossplatformMutex settledMutex;
+  CrossplatformConditionVariable settledCondition;
 };
 } // namespace okapi
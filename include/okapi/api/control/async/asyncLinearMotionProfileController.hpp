@@ -8,10 +8,16 @@
 #pragma once
 
 #include "okapi/api/control/async/asyncPositionController.hpp"
+#include "okapi/api/control/util/compactTrajectory.hpp"
+#include "okapi/api/control/util/pathRegistry.hpp"
+#include "okapi/api/control/util/trajectoryCache.hpp"
+#include "okapi/api/control/util/trajectoryPlayback.hpp"
 #include "okapi/api/control/controllerOutput.hpp"
 #include "okapi/api/units/QAngle.hpp"
 #include "okapi/api/units/QLength.hpp"
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/parallelFor.hpp"
+#include "okapi/api/util/ringBuffer.hpp"
 #include "okapi/api/util/timeUtil.hpp"
 #include <atomic>
 #include <map>
@@ -30,12 +36,21 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
    * @param imaxAccel The maximum possible acceleration.
    * @param imaxJerk The maximum possible jerk.
    * @param ioutput The output to write velocity targets to.
+   * @param iformat The fields and precision to store generated paths with. Position and velocity
+   * are needed to follow a path.
+   * @param ioutputPeriod The time between writes to the output while following a path. Zero writes
+   * once per segment of the path. Set it to motorUpdateRate milliseconds to write only as often as
+   * motors take a new setpoint; paths are then sampled at this period instead.
    */
-  AsyncLinearMotionProfileController(const TimeUtil &itimeUtil,
-                                     double imaxVel,
-                                     double imaxAccel,
-                                     double imaxJerk,
-                                     const std::shared_ptr<ControllerOutput<double>> &ioutput);
+  AsyncLinearMotionProfileController(
+    const TimeUtil &itimeUtil,
+    double imaxVel,
+    double imaxAccel,
+    double imaxJerk,
+    const std::shared_ptr<ControllerOutput<double>> &ioutput,
+    const CompactTrajectory::Format &iformat = {CompactTrajectory::mask(
+      {CompactTrajectory::Field::position, CompactTrajectory::Field::velocity})},
+    QTime ioutputPeriod = 0_ms);
 
   AsyncLinearMotionProfileController(AsyncLinearMotionProfileController &&other) noexcept;
 
@@ -51,8 +66,33 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
    *
    * @param iwaypoints The waypoints to hit on the path.
    * @param ipathId A unique identifier to save the path with.
+   * @return A handle to the path, or an invalid handle if no path was generated.
    */
-  void generatePath(std::initializer_list<double> iwaypoints, const std::string &ipathId);
+  PathHandle generatePath(std::initializer_list<double> iwaypoints, const std::string &ipathId);
+
+  /**
+   * Generates a path like generatePath(), but without a name. The path can only be referred to by
+   * the returned handle, which becomes invalid once the path is removed.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @return A handle to the path, or an invalid handle if no path was generated.
+   */
+  PathHandle generatePath(std::initializer_list<double> iwaypoints);
+
+  /**
+   * Generates several paths at once, each on its own thread, and saves them with their keys. The
+   * saved paths are identical to the ones generatePath() would make.
+   *
+   * If a path is impossible, the paths before it are saved and an instance of std::runtime_error
+   * is thrown (and an error is logged) which describes its waypoints. Paths with no waypoints are
+   * skipped.
+   *
+   * @param ipaths Pairs of a unique identifier and the waypoints to hit on that path.
+   * @param ithreads The maximum number of threads to use.
+   */
+  void generatePaths(
+    std::initializer_list<std::pair<std::string, std::initializer_list<double>>> ipaths,
+    std::size_t ithreads = defaultThreadCount());
 
   /**
    * Removes a path and frees the memory it used.
@@ -61,6 +101,22 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
    */
   void removePath(const std::string &ipathId);
 
+  /**
+   * Removes a path and frees the memory it used.
+   *
+   * @param ipath A handle to the path.
+   */
+  void removePath(PathHandle ipath);
+
+  /**
+   * Returns the handle for a path name. Setting the target to a handle skips looking up the name.
+   * The handle stays valid if the path is generated again or removed.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to generatePath().
+   * @return A handle to the path, or an invalid handle if no path was generated with the name.
+   */
+  PathHandle getPathHandle(const std::string &ipathId);
+
   /**
    * Gets the identifiers of all paths saved in this AsyncMotionProfileController.
    *
@@ -68,6 +124,23 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
    */
   std::vector<std::string> getPaths();
 
+  /**
+   * Returns the number of bytes used to store a path.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to generatePath()
+   * @return The number of bytes used by the path, or zero if there is no path with the given ID
+   */
+  std::size_t getPathMemoryUsage(const std::string &ipathId) const;
+
+  /**
+   * Sets the cache generated paths are saved to and loaded from. generatePath() loads a path from
+   * the cache instead of generating it if a path with the same waypoints was generated with the
+   * same limits and format. Pass nullptr to stop using a cache.
+   *
+   * @param icache The cache to use.
+   */
+  void setCache(const std::shared_ptr<TrajectoryCache> &icache);
+
   /**
    * Executes a path with the given ID. If there is no path matching the ID, the method will
    * return. Any targets set while a path is being followed will be ignored.
@@ -76,6 +149,58 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
    */
   void setTarget(std::string ipathId) override;
 
+  /**
+   * Executes a path. If there is no path for the handle, the method will return. Any targets set
+   * while a path is being followed will be ignored.
+   *
+   * @param ipath A handle to the path.
+   */
+  void setTarget(PathHandle ipath);
+
+  /**
+   * Queues a path to follow after the current path and any paths queued before it. The controller
+   * moves into the next path on the same tick the current one ends instead of stopping, so a
+   * sequence of paths can be followed without a pause between each. If no path is being followed,
+   * the path is followed as if it was passed to setTarget(). Queued paths are dropped when the
+   * controller is disabled.
+   *
+   * Paths should only be queued from one task at a time.
+   *
+   * @param ipath A handle to the path.
+   * @return Whether the path was queued. Returns false if the queue is full.
+   */
+  bool queuePath(PathHandle ipath);
+
+  /**
+   * Queues a path to follow after the current path and any paths queued before it. See
+   * queuePath(PathHandle).
+   *
+   * @param ipathId A unique identifier for the path, previously passed to generatePath().
+   * @return Whether the path was queued. Returns false if there is no path with that name or
+   * the queue is full.
+   */
+  bool queuePath(const std::string &ipathId);
+
+  /**
+   * Sets whether queued paths are blended together. When blending, the next path starts while the
+   * current one is still slowing down, so the output carries its speed through the transition
+   * instead of slowing to a stop. Paths are only blended when they move in the same direction.
+   *
+   * @param iblend Whether to blend queued paths.
+   */
+  void setPathBlending(bool iblend);
+
+  /**
+   * Sets how precisely the length of each spline is measured when paths are generated. A positive
+   * count integrates with that many samples per spline. PATHFINDER_SAMPLES_ADAPTIVE(digits) or
+   * PATHFINDER_SAMPLES_GAUSS integrates adaptively to a tolerance instead, which is usually faster
+   * and more accurate. The default is PATHFINDER_SAMPLES_FAST. Paths which were already generated
+   * are not changed, and cached paths are only loaded if they used the same sample count.
+   *
+   * @param isamples The sample count. Must not be zero.
+   */
+  void setSampleCount(int isamples);
+
   /**
    * Writes the value of the controller output. This method might be automatically called in another
    * thread by the controller. This just calls setTarget().
@@ -156,6 +281,13 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
    */
   bool isDisabled() const override;
 
+  /**
+   * Returns how late the loop which follows paths runs. Deadline misses are logged as warnings.
+   *
+   * @return The timing stats.
+   */
+  std::shared_ptr<LoopTimingStats> getTimingStats() const;
+
   /**
    * Starts the internal thread. This should not be called by normal users. This method is called
    * by the AsyncControllerFactory when making a new instance of this class.
@@ -164,31 +296,117 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
 
   protected:
   struct TrajectoryPair {
-    Segment *segment;
+    CompactTrajectory segment;
     int length;
   };
 
+  /**
+   * A path in the sequence of paths being followed back to back. Times are in seconds since the
+   * first path started.
+   */
+  struct ChainedPath {
+    const TrajectoryPair *path;
+    // Keeps queued paths alive while they are followed. The first path is kept alive by loop().
+    std::shared_ptr<TrajectoryPair> hold;
+    PathHandle handle;
+    double start;
+    double end;
+    bool started{false};
+  };
+
+  static constexpr std::size_t minParallelSplines = 16;
+  static constexpr std::size_t maxQueuedPaths = 16;
+
   Logger *logger;
-  std::map<std::string, TrajectoryPair> paths{};
+  PathRegistry<TrajectoryPair> paths{};
   double maxVel{0};
   double maxAccel{0};
   double maxJerk{0};
   std::shared_ptr<ControllerOutput<double>> output;
+  CompactTrajectory::Format format;
+  QTime outputPeriod;
   double currentProfilePosition{0};
   TimeUtil timeUtil;
+  std::shared_ptr<LoopTimingStats> timingStats;
+  std::shared_ptr<TrajectoryCache> cache{nullptr};
 
-  std::string currentPath{""};
+  std::atomic<PathHandle> currentPath{PathHandle()};
   std::atomic_bool isRunning{false};
+  RingBuffer<PathHandle, maxQueuedPaths> pathQueue{};
+  std::atomic_bool blending{false};
+  std::atomic_int sampleCount{PATHFINDER_SAMPLES_FAST};
   std::atomic_bool disabled{false};
   std::atomic_bool dtorCalled{false};
   CrossplatformThread *task{nullptr};
+  CrossplatformMutex settledMutex;
+  CrossplatformConditionVariable settledCondition;
+  // Guards missingPathId, the name passed to setTarget() when no path had it
+  mutable CrossplatformMutex targetMutex;
+  std::string missingPathId{};
 
   static void trampoline(void *context);
   void loop();
 
   /**
-   * Follow the supplied path. Must follow the disabled lifecycle.
+   * Makes a rate to follow a path with which records into timingStats.
+   */
+  std::unique_ptr<AbstractRate> makeFollowingRate() const;
+
+  /**
+   * Wakes the tasks waiting in waitUntilSettled() so they check whether the controller settled.
+   */
+  void notifySettled();
+
+  /**
+   * Sets the path to follow. imissingPathId is the name getTarget() reports if ipath is invalid.
+   */
+  void followPath(PathHandle ipath, const std::string &imissingPathId);
+
+  /**
+   * Follow the supplied path, then move into any paths queued behind it. Must follow the disabled
+   * lifecycle.
    */
   virtual void executeSinglePath(const TrajectoryPair &path, std::unique_ptr<AbstractRate> rate);
+
+  /**
+   * Pops the next path from the queue and appends it to ichain, starting no earlier than itime.
+   */
+  void chainQueuedPath(std::vector<ChainedPath> &ichain, double itime);
+
+  /**
+   * Returns when a path appended to ichain should start, overlapping the end of the last path in
+   * ichain if blending is on and the paths are compatible.
+   */
+  double getChainStart(const std::vector<ChainedPath> &ichain, const TrajectoryPair &inext) const;
+
+  /**
+   * Drops every queued path. Must only be called from loop().
+   */
+  void clearQueue();
+
+  /**
+   * Computes the cache key for a path. The key covers everything the generated path depends on.
+   *
+   * @param iwaypoints The waypoints of the path.
+   * @param isamples The sample count the path is generated with.
+   * @return The cache key.
+   */
+  std::uint64_t getCacheKey(const std::vector<Waypoint> &iwaypoints, int isamples) const;
+
+  /**
+   * Converts waypoints to the form pathfinder uses.
+   */
+  static std::vector<Waypoint> toWaypoints(std::initializer_list<double> iwaypoints);
+
+  /**
+   * Loads a path from the cache or generates it, splitting long paths between up to ithreads
+   * threads. Throws a std::runtime_error if the path is impossible.
+   */
+  TrajectoryPair generateTrajectory(std::vector<Waypoint> points, std::size_t ithreads);
+
+  /**
+   * Saves a path, replacing any path with the same ID.
+   */
+  void storePath(PathHandle ipath, TrajectoryPair &&itrajectory);
 };
 } // namespace okapi
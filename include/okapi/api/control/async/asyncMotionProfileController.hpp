@@ -10,13 +10,23 @@
 #include "okapi/api/chassis/controller/chassisScales.hpp"
 #include "okapi/api/chassis/model/skidSteerModel.hpp"
 #include "okapi/api/control/async/asyncPositionController.hpp"
+#include "okapi/api/control/util/compactTrajectory.hpp"
+#include "okapi/api/control/util/pathFuture.hpp"
+#include "okapi/api/control/util/pathRegistry.hpp"
+#include "okapi/api/control/util/trajectoryCache.hpp"
+#include "okapi/api/control/util/trajectoryPlayback.hpp"
 #include "okapi/api/units/QAngle.hpp"
 #include "okapi/api/units/QAngularSpeed.hpp"
 #include "okapi/api/units/QLength.hpp"
 #include "okapi/api/units/QSpeed.hpp"
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/parallelFor.hpp"
+#include "okapi/api/util/ringBuffer.hpp"
 #include "okapi/api/util/timeUtil.hpp"
+#include <array>
 #include <atomic>
+#include <deque>
+#include <functional>
 #include <map>
 
 extern "C" {
@@ -32,6 +42,17 @@ struct Point {
 
 class AsyncMotionProfileController : public AsyncPositionController<std::string, Point> {
   public:
+  /**
+   * Gains for following paths closed-loop. Each term is a wheel velocity in m/s which is added to
+   * the velocity of the profile.
+   */
+  struct FollowerGains {
+    double kP{0};    // Per meter of position error
+    double kD{0};    // Per m/s of change in position error
+    double kA{0};    // Per m/s/s of profile acceleration
+    double kTurn{0}; // Per radian of heading error, added to the right side and taken from the left
+  };
+
   /**
    * An Async Controller which generates and follows 2D motion profiles. Throws a
    * std::invalid_argument exception if the gear ratio is zero.
@@ -41,14 +62,23 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    * @param imaxJerk The maximum possible jerk in m/s/s/s.
    * @param imodel The chassis model to control.
    * @param iwidth The chassis wheelbase width.
+   * @param iformat The fields and precision to store generated paths with. Only velocity is
+   * needed to follow a path.
+   * @param ioutputPeriod The time between motor commands while following a path. Zero commands
+   * the motors once per segment of the path. Set it to motorUpdateRate milliseconds to command
+   * them only as often as they take a new setpoint; paths are then sampled at this period instead.
    */
-  AsyncMotionProfileController(const TimeUtil &itimeUtil,
-                               double imaxVel,
-                               double imaxAccel,
-                               double imaxJerk,
-                               const std::shared_ptr<ChassisModel> &imodel,
-                               const ChassisScales &iscales,
-                               AbstractMotor::GearsetRatioPair ipair);
+  AsyncMotionProfileController(
+    const TimeUtil &itimeUtil,
+    double imaxVel,
+    double imaxAccel,
+    double imaxJerk,
+    const std::shared_ptr<ChassisModel> &imodel,
+    const ChassisScales &iscales,
+    AbstractMotor::GearsetRatioPair ipair,
+    const CompactTrajectory::Format &iformat = {
+      CompactTrajectory::mask({CompactTrajectory::Field::velocity})},
+    QTime ioutputPeriod = 0_ms);
 
   AsyncMotionProfileController(AsyncMotionProfileController &&other) noexcept;
 
@@ -64,8 +94,48 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    *
    * @param iwaypoints The waypoints to hit on the path.
    * @param ipathId A unique identifier to save the path with.
+   * @return A handle to the path, or an invalid handle if no path was generated.
+   */
+  PathHandle generatePath(std::initializer_list<Point> iwaypoints, const std::string &ipathId);
+
+  /**
+   * Generates a path like generatePath(), but without a name. The path can only be referred to by
+   * the returned handle, which becomes invalid once the path is removed.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @return A handle to the path, or an invalid handle if no path was generated.
+   */
+  PathHandle generatePath(std::initializer_list<Point> iwaypoints);
+
+  /**
+   * Generates a path like generatePath(), but in a background thread so the calling task can keep
+   * working. Paths are generated one at a time, in the order they were requested. If setTarget()
+   * is called with the pathId before the path is done, the controller starts following it as soon
+   * as it is ready.
+   *
+   * If the path is impossible, no path is saved and calling get() on the returned PathFuture
+   * throws a std::runtime_error which describes the waypoints.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ipathId A unique identifier to save the path with.
+   * @return A PathFuture which can be used to wait for the path.
    */
-  void generatePath(std::initializer_list<Point> iwaypoints, const std::string &ipathId);
+  PathFuture generatePathAsync(std::initializer_list<Point> iwaypoints, const std::string &ipathId);
+
+  /**
+   * Generates several paths at once, each on its own thread, and saves them with their keys. The
+   * saved paths are identical to the ones generatePath() would make.
+   *
+   * If a path is impossible, the paths before it are saved and an instance of std::runtime_error
+   * is thrown (and an error is logged) which describes its waypoints. Paths with no waypoints are
+   * skipped.
+   *
+   * @param ipaths Pairs of a unique identifier and the waypoints to hit on that path.
+   * @param ithreads The maximum number of threads to use.
+   */
+  void generatePaths(
+    std::initializer_list<std::pair<std::string, std::initializer_list<Point>>> ipaths,
+    std::size_t ithreads = defaultThreadCount());
 
   /**
    * Removes a path and frees the memory it used.
@@ -74,6 +144,22 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    */
   void removePath(const std::string &ipathId);
 
+  /**
+   * Removes a path and frees the memory it used.
+   *
+   * @param ipath A handle to the path.
+   */
+  void removePath(PathHandle ipath);
+
+  /**
+   * Returns the handle for a path name. Setting the target to a handle skips looking up the name.
+   * The handle stays valid if the path is generated again or removed.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to generatePath().
+   * @return A handle to the path, or an invalid handle if no path was generated with the name.
+   */
+  PathHandle getPathHandle(const std::string &ipathId);
+
   /**
    * Gets the identifiers of all paths saved in this AsyncMotionProfileController.
    *
@@ -81,6 +167,43 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    */
   std::vector<std::string> getPaths();
 
+  /**
+   * Returns the number of bytes used to store a path.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to generatePath()
+   * @return The number of bytes used by the path, or zero if there is no path with the given ID
+   */
+  std::size_t getPathMemoryUsage(const std::string &ipathId) const;
+
+  /**
+   * Sets the cache generated paths are saved to and loaded from. generatePath() loads a path from
+   * the cache instead of generating it if a path with the same waypoints was generated with the
+   * same limits, chassis scales, and format. Pass nullptr to stop using a cache.
+   *
+   * @param icache The cache to use.
+   */
+  void setCache(const std::shared_ptr<TrajectoryCache> &icache);
+
+  /**
+   * Follows paths closed-loop using the model's sensors, which must read each side in motor
+   * degrees (like the integrated encoders). Every output period, the distance each side has
+   * travelled is compared to the profile with pathfinder_follow_encoder2(), and the heading
+   * computed from the encoders is compared to the heading of the profile. Call this before
+   * following a path.
+   *
+   * Paths must be generated with position and heading stored (and acceleration, if kA is not
+   * zero). Throws a std::invalid_argument exception if they are not, or if the model does not have
+   * a sensor for each side.
+   *
+   * @param igains The gains to follow paths with.
+   */
+  void setFollowerGains(const FollowerGains &igains);
+
+  /**
+   * Follows paths open-loop by driving the velocities of the profile. This is the default.
+   */
+  void disableFollowerGains();
+
   /**
    * Executes a path with the given ID. If there is no path matching the ID, the method will
    * return. Any targets set while a path is being followed will be ignored.
@@ -98,6 +221,64 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    */
   void setTarget(std::string ipathId, bool ibackwards);
 
+  /**
+   * Executes a path. If there is no path for the handle, the method will return. Any targets set
+   * while a path is being followed will be ignored.
+   *
+   * @param ipath A handle to the path.
+   * @param ibackwards Whether to follow the profile backwards.
+   */
+  void setTarget(PathHandle ipath, bool ibackwards = false);
+
+  /**
+   * Queues a path to follow after the current path and any paths queued before it. The controller
+   * moves into the next path on the same tick the current one ends instead of stopping, so a
+   * sequence of paths can be followed without a pause between each. If no path is being followed,
+   * the path is followed as if it was passed to setTarget(). Queued paths are dropped when the
+   * controller is disabled.
+   *
+   * Paths should only be queued from one task at a time.
+   *
+   * @param ipath A handle to the path.
+   * @param ibackwards Whether to follow the profile backwards.
+   * @return Whether the path was queued. Returns false if the queue is full.
+   */
+  bool queuePath(PathHandle ipath, bool ibackwards = false);
+
+  /**
+   * Queues a path to follow after the current path and any paths queued before it. See
+   * queuePath(PathHandle, bool).
+   *
+   * @param ipathId A unique identifier for the path, previously passed to generatePath().
+   * @param ibackwards Whether to follow the profile backwards.
+   * @return Whether the path was queued. Returns false if there is no path with that name or
+   * the queue is full.
+   */
+  bool queuePath(const std::string &ipathId, bool ibackwards = false);
+
+  /**
+   * Sets whether queued paths are blended together. When blending, the next path starts while the
+   * current one is still slowing down, so the robot carries its speed through the transition
+   * instead of slowing to a stop. Paths are only blended when they are followed in the same
+   * direction and the next path starts at the heading the current one ends at. Checking the
+   * heading needs paths stored with CompactTrajectory::Field::heading, so paths stored without it
+   * are never blended.
+   *
+   * @param iblend Whether to blend queued paths.
+   */
+  void setPathBlending(bool iblend);
+
+  /**
+   * Sets how precisely the length of each spline is measured when paths are generated. A positive
+   * count integrates with that many samples per spline. PATHFINDER_SAMPLES_ADAPTIVE(digits) or
+   * PATHFINDER_SAMPLES_GAUSS integrates adaptively to a tolerance instead, which is usually faster
+   * and more accurate. The default is PATHFINDER_SAMPLES_FAST. Paths which were already generated
+   * are not changed, and cached paths are only loaded if they used the same sample count.
+   *
+   * @param isamples The sample count. Must not be zero.
+   */
+  void setSampleCount(int isamples);
+
   /**
    * Writes the value of the controller output. This method might be automatically called in another
    * thread by the controller. This just calls setTarget().
@@ -121,14 +302,24 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    * Generates a new path from the position (typically the current position) to the target and
    * blocks until the controller has settled. Does not save the path which was generated.
    *
+   * The path is streamed: the robot starts moving as soon as the first segments are generated and
+   * the rest of the path is generated while it is followed. If a path is already being followed,
+   * it is finished first. If a cache is set, the path is generated in full (or loaded) instead so
+   * it can be cached.
+   *
+   * If the waypoints form a path which is impossible to achieve, an instance of std::runtime_error
+   * is thrown (and an error is logged) which describes the waypoints.
+   *
    * @param iwaypoints The waypoints to hit on the path.
    */
   void moveTo(std::initializer_list<Point> iwaypoints);
 
   /**
-   * Returns the last error of the controller. This implementation always returns zero since the
-   * robot is assumed to perfectly follow the path. Subclasses can override this to be more
-   * accurate using odometry information.
+   * Returns the last error of the controller. When following paths closed-loop, x is how far the
+   * robot is behind the profile along the path (the average of both sides) and theta is how far
+   * the robot is turned clockwise from the heading of the profile. y is always zero because the
+   * encoders can not measure how far the robot drifted sideways. When following paths open-loop,
+   * the robot is assumed to perfectly follow the path and the error is always zero.
    *
    * @return the last error
    */
@@ -171,6 +362,13 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    */
   bool isDisabled() const override;
 
+  /**
+   * Returns how late the loop which follows paths runs. Deadline misses are logged as warnings.
+   *
+   * @return The timing stats.
+   */
+  std::shared_ptr<LoopTimingStats> getTimingStats() const;
+
   /**
    * Starts the internal thread. This should not be called by normal users. This method is called
    * by the AsyncControllerFactory when making a new instance of this class.
@@ -179,36 +377,279 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
 
   protected:
   struct TrajectoryPair {
-    Segment *left;
-    Segment *right;
+    CompactTrajectory left;
+    CompactTrajectory right;
     int length;
   };
 
+  /**
+   * Where one side of the chassis should be at a point in a path.
+   */
+  struct SideTarget {
+    double position;     // m
+    double velocity;     // m/s
+    double acceleration; // m/s/s
+  };
+
+  /**
+   * Where the chassis should be at a point in a path.
+   */
+  struct PathTarget {
+    SideTarget left;
+    SideTarget right;
+    double heading; // rad
+  };
+
+  /**
+   * The closed-loop state of the path being followed.
+   */
+  struct FollowerState {
+    bool started{false};
+    std::int32_t initialLeft{0};
+    std::int32_t initialRight{0};
+    PathTarget initialTarget{};
+    // Expected time between calls to followTarget() in seconds, used until one has been measured
+    double dt{0};
+    // Playback time of the last closed-loop call to followTarget() in seconds
+    double lastTime{0};
+    EncoderFollower left{};
+    EncoderFollower right{};
+  };
+
+  /**
+   * Segments passed from moveTo(), which generates them, to loop(), which follows them.
+   */
+  struct TrajectoryStream {
+    RingBuffer<PathTarget, 256> segments{};
+    // Time between segments in seconds, set before the stream is published
+    double dt{0};
+    // Set by the producer after it pushes the last segment
+    std::atomic_bool done{false};
+    // Set by the consumer when it stops following the stream
+    std::atomic_bool cancelled{false};
+  };
+
+  /**
+   * A path waiting in the queue.
+   */
+  struct QueuedPath {
+    PathHandle path{};
+    int direction{1};
+  };
+
+  /**
+   * A path in the sequence of paths being followed back to back. Times are in seconds since the
+   * first path started.
+   */
+  struct ChainedPath {
+    const TrajectoryPair *path;
+    // Keeps queued paths alive while they are followed. The first path is kept alive by loop().
+    std::shared_ptr<TrajectoryPair> hold;
+    PathHandle handle;
+    int direction;
+    double start;
+    double end;
+    PathTarget origin;
+    bool started{false};
+  };
+
+  struct GenerationJob {
+    std::vector<Waypoint> waypoints;
+    PathHandle path;
+    std::shared_ptr<PathFuture::State> state;
+  };
+
+  static constexpr std::size_t minParallelSplines = 16;
+  static constexpr std::size_t maxQueuedPaths = 16;
+  // How far apart the headings at the end of one path and the start of the next can be for the
+  // paths to be blended together
+  static constexpr double blendHeadingTolerance = 1e-3; // rad
+
   Logger *logger;
-  std::map<std::string, TrajectoryPair> paths{};
+  PathRegistry<TrajectoryPair> paths{};
   double maxVel{0};
   double maxAccel{0};
   double maxJerk{0};
   std::shared_ptr<ChassisModel> model;
   ChassisScales scales;
   AbstractMotor::GearsetRatioPair pair;
+  CompactTrajectory::Format format;
+  QTime outputPeriod;
   TimeUtil timeUtil;
+  std::shared_ptr<LoopTimingStats> timingStats;
+  std::shared_ptr<TrajectoryCache> cache{nullptr};
+  // Guards gains and closedLoop, which are set by the user and read by loop()
+  CrossplatformMutex gainsMutex;
+  FollowerGains gains{};
+  bool closedLoop{false};
+  std::atomic<double> positionError{0};
+  std::atomic<double> headingError{0};
 
-  std::string currentPath{""};
+  std::atomic<PathHandle> currentPath{PathHandle()};
   std::atomic_bool isRunning{false};
   std::atomic_int direction{1};
+  RingBuffer<QueuedPath, maxQueuedPaths> pathQueue{};
+  std::atomic_bool blending{false};
+  std::atomic_int sampleCount{PATHFINDER_SAMPLES_FAST};
   std::atomic_bool disabled{false};
   std::atomic_bool dtorCalled{false};
   CrossplatformThread *task{nullptr};
+  CrossplatformMutex settledMutex;
+  CrossplatformConditionVariable settledCondition;
+
+  // Guards generationQueue, pendingPaths, currentStream, and missingPathId
+  mutable CrossplatformMutex pathsMutex;
+  std::deque<GenerationJob> generationQueue{};
+  std::map<PathHandle, std::size_t> pendingPaths{};
+  CrossplatformThread *generationTask{nullptr};
+  std::atomic_bool stopGeneration{false};
+  std::shared_ptr<TrajectoryStream> currentStream{nullptr};
+  // The name passed to setTarget() when no path had it, so getTarget() can still report it
+  std::string missingPathId{};
 
   static void trampoline(void *context);
   void loop();
 
   /**
-   * Follow the supplied path. Must follow the disabled lifecycle.
+   * Makes a rate to follow a path with which records into timingStats.
+   */
+  std::unique_ptr<AbstractRate> makeFollowingRate() const;
+
+  /**
+   * Wakes the tasks waiting in waitUntilSettled() so they check whether the controller settled.
+   */
+  void notifySettled();
+
+  /**
+   * Sets the path to follow. imissingPathId is the name getTarget() reports if ipath is invalid.
+   */
+  void followPath(PathHandle ipath, bool ibackwards, const std::string &imissingPathId);
+
+  static void generationTrampoline(void *context);
+  void generationLoop();
+
+  /**
+   * Stops the generation task of a controller which is being moved from, without failing its
+   * queued paths. The move constructor calls this before moving anything so the task does not
+   * save a path into a moved-from registry.
+   *
+   * @param iother The controller being moved from.
+   * @return The other controller's logger.
+   */
+  static Logger *stopGenerationTask(AsyncMotionProfileController &iother);
+
+  /**
+   * Converts waypoints to the units pathfinder uses.
+   */
+  static std::vector<Waypoint> toWaypoints(std::initializer_list<Point> iwaypoints);
+
+  /**
+   * Loads a path from the cache or generates it, splitting long paths between up to ithreads
+   * threads. Throws a std::runtime_error if the path is impossible.
+   */
+  TrajectoryPair generateTrajectory(std::vector<Waypoint> points, std::size_t ithreads);
+
+  /**
+   * Prepares a path and starts a generator for it. The generator points to icandidate, so it must
+   * outlive the generator. Throws a std::runtime_error if the path is impossible.
+   */
+  void startGenerator(std::vector<Waypoint> &points,
+                      std::size_t ithreads,
+                      int isamples,
+                      TrajectoryCandidate &icandidate,
+                      TrajectoryGenerator &igenerator);
+
+  /**
+   * Generates the segments of each side of the tank drive one at a time and passes them to
+   * iconsumer along with their index. Stops early if iconsumer returns false. Frees the generator.
+   *
+   * @return Whether every segment was generated.
+   */
+  bool generateTankSegments(
+    TrajectoryGenerator &igenerator,
+    const std::function<bool(int, const Segment &, const Segment &)> &iconsumer);
+
+  /**
+   * Generates a path into a stream for loop() to follow, then waits for it to be followed.
+   */
+  void streamPath(std::vector<Waypoint> points);
+
+  /**
+   * Saves a path, replacing any path with the same ID.
+   */
+  void storePath(PathHandle ipath, TrajectoryPair &&itrajectory);
+
+  /**
+   * Finds a path, waiting for it if it is still being generated. Returns nullptr if there is no
+   * path for the handle or if the controller was disabled while waiting.
+   */
+  std::shared_ptr<TrajectoryPair> waitForPath(PathHandle ipath);
+
+  /**
+   * Follow the supplied path, then move into any paths queued behind it. Must follow the disabled
+   * lifecycle.
    */
   virtual void executeSinglePath(const TrajectoryPair &path, std::unique_ptr<AbstractRate> rate);
 
+  /**
+   * Pops the next path from the queue once it has been generated and appends it to ichain,
+   * starting no earlier than itime. iwaiting holds a popped path which is still being generated.
+   */
+  void chainQueuedPath(std::vector<ChainedPath> &ichain, QueuedPath &iwaiting, double itime);
+
+  /**
+   * Returns when a path appended to ichain should start, overlapping the end of the last path in
+   * ichain if blending is on and the paths are compatible.
+   */
+  double getChainStart(const std::vector<ChainedPath> &ichain,
+                       const TrajectoryPair &inext,
+                       int idirection) const;
+
+  /**
+   * Drops every queued path. Must only be called from loop().
+   */
+  void clearQueue();
+
+  /**
+   * Follow the supplied stream as its segments are generated. Must follow the disabled lifecycle.
+   */
+  virtual void executeStream(TrajectoryStream &stream, std::unique_ptr<AbstractRate> rate);
+
+  /**
+   * Reads where the chassis should be at a fractional segment index of a path.
+   */
+  static PathTarget samplePath(const TrajectoryPair &ipath, double iindex);
+
+  /**
+   * Drives the chassis towards a target, open-loop or closed-loop depending on whether follower
+   * gains were set.
+   *
+   * @param itarget Where the chassis should be.
+   * @param idirection 1 to drive forwards or -1 to drive backwards.
+   * @param itime The time since playback started in seconds. The derivative term uses the time
+   * since the last call, so it does not spike when playback skips a late tick.
+   * @param istate The closed-loop state of the path, which starts default constructed.
+   */
+  void followTarget(const PathTarget &itarget, int idirection, double itime, FollowerState &istate);
+
+  /**
+   * Drives each side of the chassis at a linear velocity.
+   *
+   * @param ileftVel The left side velocity in m/s.
+   * @param irightVel The right side velocity in m/s.
+   * @param idirection 1 to drive forwards or -1 to drive backwards.
+   */
+  void driveAtVelocities(double ileftVel, double irightVel, int idirection);
+
+  /**
+   * Computes the cache key for a path. The key covers everything the generated path depends on.
+   *
+   * @param iwaypoints The waypoints of the path.
+   * @param isamples The sample count the path is generated with.
+   * @return The cache key.
+   */
+  std::uint64_t getCacheKey(const std::vector<Waypoint> &iwaypoints, int isamples) const;
+
   /**
    * Converts linear chassis speed to rotational motor speed.
    *
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "okapi/api/control/async/asyncPositionController.hpp"
+#include "okapi/api/coreProsAPI.hpp"
 #include "okapi/api/device/motor/abstractMotor.hpp"
 #include "okapi/api/util/logging.hpp"
 #include "okapi/api/util/timeUtil.hpp"
@@ -136,6 +137,8 @@ class AsyncPosIntegratedController : public AsyncPositionController<double, doub
   bool hasFirstTarget = false;
   std::unique_ptr<SettledUtil> settledUtil;
   std::unique_ptr<AbstractRate> rate;
+  CrossplatformMutex settledMutex;
+  CrossplatformConditionVariable settledCondition;
 
   /**
    * Resumes moving after the controller is reset. Should not cause movement if the controller is
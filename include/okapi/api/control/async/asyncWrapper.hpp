@@ -10,13 +10,16 @@
 #include "okapi/api/control/async/asyncController.hpp"
 #include "okapi/api/control/controllerInput.hpp"
 #include "okapi/api/control/iterative/iterativeController.hpp"
+#include "okapi/api/control/util/controlLoopExecutor.hpp"
 #include "okapi/api/control/util/settledUtil.hpp"
+#include "okapi/api/control/util/telemetryRecorder.hpp"
 #include "okapi/api/coreProsAPI.hpp"
 #include "okapi/api/util/abstractRate.hpp"
 #include "okapi/api/util/logging.hpp"
 #include "okapi/api/util/mathUtil.hpp"
 #include "okapi/api/util/supplier.hpp"
 #include <atomic>
+#include <limits>
 #include <memory>
 
 namespace okapi {
@@ -43,7 +46,9 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
       output(ioutput),
       controller(std::move(icontroller)),
       loopRate(irateSupplier.get()),
-      settledRate(irateSupplier.get()) {
+      settledRate(irateSupplier.get()),
+      timingStats(LoopTimingStats::withMissWarning("AsyncWrapper")) {
+    loopRate->trackDeadlines(timingStats);
   }
 
   AsyncWrapper(AsyncWrapper<Input, Output> &&other) noexcept
@@ -53,12 +58,23 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
       controller(std::move(other.controller)),
       loopRate(std::move(other.loopRate)),
       settledRate(std::move(other.settledRate)),
+      timingStats(std::move(other.timingStats)),
       dtorCalled(other.dtorCalled.load(std::memory_order_acquire)),
+      settled(other.settled.load(std::memory_order_acquire)),
       task(other.task) {
+    // The executor calls the old object, so register this one in its place
+    if (other.executor) {
+      runOn(other.executor);
+      other.executor->remove(other.executorId);
+      other.executor = nullptr;
+    }
   }
 
   ~AsyncWrapper() override {
     dtorCalled.store(true, std::memory_order_release);
+    if (executor) {
+      executor->remove(executorId);
+    }
     delete task;
   }
 
@@ -66,8 +82,9 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
    * Sets the target for the controller.
    */
   void setTarget(Input itarget) override {
-    logger->info("AsyncWrapper: Set target to " + std::to_string(itarget));
+    logger->info("AsyncWrapper: Set target to %s", [&]() { return std::to_string(itarget); });
     hasFirstTarget = true;
+    settled.store(false, std::memory_order_release);
     controller->setTarget(itarget);
     lastTarget = itarget;
   }
@@ -79,6 +96,7 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
    * @param ivalue the controller's output
    */
   void controllerSet(Input ivalue) override {
+    settled.store(false, std::memory_order_release);
     controller->controllerSet(ivalue);
   }
 
@@ -111,18 +129,27 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
    *
    * If the controller is disabled, this method must return true.
    *
+   * Checking whether the controller settled changes its state, so only the control loop checks it.
+   * This returns what the loop found on its last step since the target was set.
+   *
    * @return whether the controller is settled
    */
   bool isSettled() override {
-    return isDisabled() || controller->isSettled();
+    return isDisabled() || settled.load(std::memory_order_acquire);
   }
 
   /**
-   * Set time between loops.
+   * Set time between loops. If the controller runs on an executor, the sample time must be a
+   * multiple of the executor's base period, or an instance of std::invalid_argument is thrown and
+   * the sample time is not changed.
    *
    * @param isampleTime time between loops
    */
   void setSampleTime(QTime isampleTime) {
+    // The executor checks the period, so change it first to leave both unchanged if it throws
+    if (executor) {
+      executor->setPeriod(executorId, isampleTime);
+    }
     controller->setSampleTime(isampleTime);
   }
 
@@ -160,6 +187,7 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
    */
   void reset() override {
     logger->info("AsyncWrapper: Reset");
+    settled.store(false, std::memory_order_release);
     controller->reset();
     hasFirstTarget = false;
   }
@@ -169,9 +197,10 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
    * cause the controller to move to its last set target, unless it was reset in that time.
    */
   void flipDisable() override {
-    logger->info("AsyncWrapper: flipDisable " + std::to_string(!controller->isDisabled()));
+    logger->info("AsyncWrapper: flipDisable %d", !controller->isDisabled());
     controller->flipDisable();
     resumeMovement();
+    notifySettled();
   }
 
   /**
@@ -181,9 +210,10 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
    * @param iisDisabled whether the controller is disabled
    */
   void flipDisable(bool iisDisabled) override {
-    logger->info("AsyncWrapper: flipDisable " + std::to_string(iisDisabled));
+    logger->info("AsyncWrapper: flipDisable %d", iisDisabled);
     controller->flipDisable(iisDisabled);
     resumeMovement();
+    notifySettled();
   }
 
   /**
@@ -202,13 +232,34 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
   void waitUntilSettled() override {
     logger->info("AsyncWrapper: Waiting to settle");
 
-    while (!isSettled()) {
-      loopRate->delayUntil(motorUpdateRate);
-    }
+    // loop() wakes this task up once the controller settles
+    std::unique_lock<CrossplatformMutex> lock(settledMutex);
+    settledCondition.wait(lock, [&]() { return isSettled(); });
 
     logger->info("AsyncWrapper: Done waiting to settle");
   }
 
+  /**
+   * Returns how late the controller's task runs. Deadline misses are logged as warnings. When the
+   * controller runs on an executor, the executor's stats apply instead.
+   *
+   * @return The timing stats.
+   */
+  std::shared_ptr<LoopTimingStats> getTimingStats() const {
+    return timingStats;
+  }
+
+  /**
+   * Records every loop into a recorder, or stops recording if the recorder is nullptr. The wrapper
+   * does not know the terms of the controller it wraps, so they are recorded as NaN; give a PID
+   * controller its own recorder to record its terms.
+   *
+   * @param irecorder The recorder.
+   */
+  void setTelemetryRecorder(std::shared_ptr<TelemetryRecorder> irecorder) {
+    telemetry = std::move(irecorder);
+  }
+
   /**
    * Starts the internal thread. This should not be called by normal users. This method is called
    * by the AsyncControllerFactory when making a new instance of this class.
@@ -219,6 +270,20 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
     }
   }
 
+  /**
+   * Runs the controller on an executor instead of in its own task. The controller steps every
+   * sample time, which must be a multiple of the executor's base period. Do not also call
+   * startThread().
+   *
+   * @param iexecutor The executor to run on.
+   */
+  void runOn(const std::shared_ptr<ControlLoopExecutor> &iexecutor) {
+    if (!task && !executor) {
+      executorId = iexecutor->add(controller->getSampleTime(), [this]() { step(); });
+      executor = iexecutor;
+    }
+  }
+
   protected:
   Logger *logger;
   std::shared_ptr<ControllerInput<Input>> input;
@@ -228,8 +293,16 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
   Input lastTarget;
   std::unique_ptr<AbstractRate> loopRate;
   std::unique_ptr<AbstractRate> settledRate;
+  std::shared_ptr<LoopTimingStats> timingStats;
+  std::shared_ptr<TelemetryRecorder> telemetry{nullptr};
   std::atomic_bool dtorCalled{false};
+  // Whether the controller settled, as of the last step. Only step() checks the controller.
+  std::atomic_bool settled{false};
   CrossplatformThread *task{nullptr};
+  std::shared_ptr<ControlLoopExecutor> executor{nullptr};
+  std::uint32_t executorId{0};
+  CrossplatformMutex settledMutex;
+  CrossplatformConditionVariable settledCondition;
 
   static void trampoline(void *context) {
     if (context) {
@@ -239,14 +312,47 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
 
   void loop() {
     while (!dtorCalled.load(std::memory_order_acquire)) {
-      if (!isDisabled()) {
-        output->controllerSet(controller->step(input->controllerGet()));
+      step();
+      loopRate->delayUntil(controller->getSampleTime());
+    }
+  }
+
+  /**
+   * Runs one iteration of the control loop.
+   */
+  void step() {
+    if (!isDisabled()) {
+      const Input reading = input->controllerGet();
+      const Output out = controller->step(reading);
+      output->controllerSet(out);
+
+      if (telemetry) {
+        constexpr double none = std::numeric_limits<double>::quiet_NaN();
+        telemetry->record(static_cast<double>(controller->getTarget()),
+                          static_cast<double>(reading),
+                          static_cast<double>(controller->getError()),
+                          none,
+                          none,
+                          none,
+                          static_cast<double>(out));
       }
 
-      loopRate->delayUntil(controller->getSampleTime());
+      const bool isControllerSettled = controller->isSettled();
+      settled.store(isControllerSettled, std::memory_order_release);
+      if (isControllerSettled && settledCondition.hasWaiters()) {
+        notifySettled();
+      }
     }
   }
 
+  /**
+   * Wakes the tasks waiting in waitUntilSettled() so they check whether the controller settled.
+   */
+  void notifySettled() {
+    std::lock_guard<CrossplatformMutex> lock(settledMutex);
+    settledCondition.notifyAll();
+  }
+
   /**
    * Resumes moving after the controller is reset. Should not cause movement if the controller is
    * turned off, reset, and turned back on.
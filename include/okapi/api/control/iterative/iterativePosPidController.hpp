@@ -11,6 +11,7 @@
 
 #include "okapi/api/control/iterative/iterativePositionController.hpp"
 #include "okapi/api/control/util/settledUtil.hpp"
+#include "okapi/api/control/util/telemetryRecorder.hpp"
 #include "okapi/api/filter/filter.hpp"
 #include "okapi/api/filter/passthroughFilter.hpp"
 #include "okapi/api/util/logging.hpp"
@@ -208,6 +209,13 @@ class IterativePosPIDController : public IterativePositionController<double, dou
    */
   QTime getSampleTime() const override;
 
+  /**
+   * Records every control step into a recorder, or stops recording if the recorder is nullptr.
+   *
+   * @param irecorder The recorder.
+   */
+  void setTelemetryRecorder(std::shared_ptr<TelemetryRecorder> irecorder);
+
   protected:
   Logger *logger;
   double kP, kI, kD, kBias;
@@ -241,5 +249,6 @@ class IterativePosPIDController : public IterativePositionController<double, dou
 
   std::unique_ptr<AbstractTimer> loopDtTimer;
   std::unique_ptr<SettledUtil> settledUtil;
+  std::shared_ptr<TelemetryRecorder> telemetry{nullptr};
 };
 } // namespace okapi
@@ -9,6 +9,7 @@
 
 #include "okapi/api/control/iterative/iterativeVelocityController.hpp"
 #include "okapi/api/control/util/settledUtil.hpp"
+#include "okapi/api/control/util/telemetryRecorder.hpp"
 #include "okapi/api/filter/passthroughFilter.hpp"
 #include "okapi/api/filter/velMath.hpp"
 #include "okapi/api/util/logging.hpp"
@@ -180,6 +181,14 @@ class IterativeVelPIDController : public IterativeVelocityController<double, dou
    */
   virtual QAngularSpeed getVel() const;
 
+  /**
+   * Records every control step into a recorder, or stops recording if the recorder is nullptr. The
+   * integral term is the accumulated output sum, and the feed-forward only shows up in the output.
+   *
+   * @param irecorder The recorder.
+   */
+  void setTelemetryRecorder(std::shared_ptr<TelemetryRecorder> irecorder);
+
   protected:
   Logger *logger;
   double kP, kD, kF, kSF;
@@ -197,5 +206,6 @@ class IterativeVelPIDController : public IterativeVelocityController<double, dou
   std::unique_ptr<Filter> derivativeFilter;
   std::unique_ptr<AbstractTimer> loopDtTimer;
   std::unique_ptr<SettledUtil> settledUtil;
+  std::shared_ptr<TelemetryRecorder> telemetry{nullptr};
 };
 } // namespace okapi
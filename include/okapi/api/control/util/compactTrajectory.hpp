@@ -0,0 +1,214 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+extern "C" {
+#include "okapi/pathfinder/include/pathfinder.h"
+}
+
+namespace okapi {
+class CompactTrajectory {
+  public:
+  /**
+   * The fields of a Segment which can be stored. dt is the same for every segment so it is always
+   * stored once per trajectory.
+   */
+  enum class Field : std::uint8_t {
+    x = 1 << 0,
+    y = 1 << 1,
+    position = 1 << 2,
+    velocity = 1 << 3,
+    acceleration = 1 << 4,
+    jerk = 1 << 5,
+    heading = 1 << 6
+  };
+
+  enum class Precision { float64, float32 };
+
+  static constexpr std::uint8_t allFields = 0x7F;
+  static constexpr std::size_t numFields = 7;
+
+  struct Format {
+    std::uint8_t fields{allFields};
+    Precision precision{Precision::float64};
+  };
+
+  /**
+   * Combines fields into a mask for Format::fields.
+   *
+   * @param ifields The fields.
+   * @return The field mask.
+   */
+  static constexpr std::uint8_t mask(std::initializer_list<Field> ifields) {
+    std::uint8_t out = 0;
+    for (const auto field : ifields) {
+      out |= static_cast<std::uint8_t>(field);
+    }
+    return out;
+  }
+
+  /**
+   * A trajectory which stores each field of its segments in a separate array, optionally as
+   * floats and optionally dropping fields which are not needed. Segments are written with set().
+   *
+   * @param ilength The number of segments.
+   * @param idt The time between segments.
+   * @param iformat The fields to store and their precision.
+   */
+  CompactTrajectory(std::size_t ilength, double idt, const Format &iformat);
+
+  /**
+   * A trajectory which stores each field of its segments in a separate array, optionally as
+   * floats and optionally dropping fields which are not needed.
+   *
+   * @param isegments The segments to copy.
+   * @param ilength The number of segments.
+   * @param iformat The fields to store and their precision.
+   */
+  CompactTrajectory(const Segment *isegments, std::size_t ilength, const Format &iformat);
+
+  /**
+   * A trajectory which uses segments that are already stored in the layout returned by getData(),
+   * for example in a memory mapped file, without copying them.
+   *
+   * @param istorage The stored segments. The trajectory shares ownership of them.
+   * @param ilength The number of segments.
+   * @param idt The time between segments.
+   * @param iformat The fields stored and their precision.
+   */
+  CompactTrajectory(std::shared_ptr<std::uint8_t> istorage,
+                    std::size_t ilength,
+                    double idt,
+                    const Format &iformat);
+
+  CompactTrajectory(CompactTrajectory &&other) noexcept;
+
+  CompactTrajectory &operator=(CompactTrajectory &&other) noexcept;
+
+  /**
+   * Writes the stored fields of a segment.
+   *
+   * @param i The segment index.
+   * @param isegment The segment.
+   */
+  void set(std::size_t i, const Segment &isegment);
+
+  /**
+   * Reads one field of a segment. Returns zero if the field is not stored.
+   *
+   * @param ifield The field to read.
+   * @param i The segment index.
+   * @return The value of the field.
+   */
+  double get(Field ifield, std::size_t i) const;
+
+  /**
+   * Reads a segment. Fields which are not stored are zero.
+   *
+   * @param i The segment index.
+   * @return The segment.
+   */
+  Segment getSegment(std::size_t i) const;
+
+  /**
+   * Reads one field at a fractional segment index, linearly interpolating between the segments on
+   * either side. The index is clamped to the trajectory. Returns zero if the field is not stored or
+   * there are no segments. Headings are interpolated the short way around, so a heading between
+   * segments which cross zero may be slightly below zero or above 2 pi.
+   *
+   * @param ifield The field to read.
+   * @param iindex The fractional segment index.
+   * @return The value of the field.
+   */
+  double interpolate(Field ifield, double iindex) const;
+
+  /**
+   * Finds the first and last segments where the magnitude of a field is largest, give or take a
+   * small tolerance. For the velocity field, the segments before the first one are where the
+   * profile speeds up and the segments after the last one are where it slows down. Returns zero for
+   * both if the field is not stored or there are no segments.
+   *
+   * @param ifield The field to search.
+   * @return The indices of the first and last segments at the peak.
+   */
+  std::pair<std::size_t, std::size_t> findPeak(Field ifield) const;
+
+  /**
+   * Returns whether a field is stored.
+   *
+   * @param ifield The field.
+   * @return Whether the field is stored.
+   */
+  bool hasField(Field ifield) const;
+
+  /**
+   * Returns the number of segments.
+   *
+   * @return The number of segments.
+   */
+  std::size_t size() const;
+
+  /**
+   * Returns the time between segments.
+   *
+   * @return The time between segments.
+   */
+  double getDt() const;
+
+  /**
+   * Returns the fields stored and their precision.
+   *
+   * @return The fields stored and their precision.
+   */
+  const Format &getFormat() const;
+
+  /**
+   * Returns the stored segments. Each stored field is an array of size() elements, in field order
+   * and with no padding between them. The data is getMemoryUsage() bytes long.
+   *
+   * @return The stored segments.
+   */
+  const std::uint8_t *getData() const;
+
+  /**
+   * Returns the number of bytes used to store the segments.
+   *
+   * @return The number of bytes used to store the segments.
+   */
+  std::size_t getMemoryUsage() const;
+
+  /**
+   * Computes the number of bytes needed to store a trajectory.
+   *
+   * @param ilength The number of segments.
+   * @param iformat The fields to store and their precision.
+   * @return The number of bytes needed to store the segments.
+   */
+  static std::size_t getMemoryUsage(std::size_t ilength, const Format &iformat);
+
+  protected:
+  std::size_t length;
+  double dt;
+  Format format;
+  std::shared_ptr<std::uint8_t> storage;
+  std::array<void *, numFields> columns{};
+
+  void assignColumns();
+
+  static std::size_t fieldIndex(Field ifield);
+  static std::size_t elementSize(Precision iprecision);
+  static std::size_t fieldCount(std::uint8_t ifields);
+};
+} // namespace okapi
@@ -0,0 +1,129 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/coreProsAPI.hpp"
+#include "okapi/api/units/QTime.hpp"
+#include "okapi/api/util/abstractRate.hpp"
+#include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/timeUtil.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace okapi {
+class ControlLoopExecutor {
+  public:
+  /**
+   * Runs the control loops of many controllers in one task. Every base period, the executor runs
+   * each loop which is due, in the order the loops were added. A loop with a period of n base
+   * periods runs on every nth tick, counted from when the executor started, so loops with the same
+   * period always run on the same ticks.
+   *
+   * Controllers register with runOn() instead of starting their own task with startThread().
+   *
+   * @param itimeUtil The TimeUtil to get the rate the executor waits with from.
+   * @param ibasePeriod The time between ticks. The period of every loop is a multiple of this.
+   */
+  explicit ControlLoopExecutor(const TimeUtil &itimeUtil, QTime ibasePeriod = 10_ms);
+
+  ControlLoopExecutor(const ControlLoopExecutor &) = delete;
+  ControlLoopExecutor &operator=(const ControlLoopExecutor &) = delete;
+
+  ~ControlLoopExecutor();
+
+  /**
+   * Adds a control loop. It runs after every loop added before it on the same tick.
+   *
+   * If the period is not a positive multiple of the base period, an instance of
+   * std::invalid_argument is thrown (and an error is logged).
+   *
+   * @param iperiod The time between runs of the loop.
+   * @param istep Runs the loop once. Must not add or remove loops.
+   * @return An id to change or remove the loop with.
+   */
+  std::uint32_t add(QTime iperiod, std::function<void()> istep);
+
+  /**
+   * Changes the period of a loop. Throws like add() if the period is invalid.
+   *
+   * @param iid The id add() returned.
+   * @param iperiod The time between runs of the loop.
+   */
+  void setPeriod(std::uint32_t iid, QTime iperiod);
+
+  /**
+   * Removes a loop. If the loop is running, waits for it to finish first, so it is safe to destroy
+   * whatever the loop uses after this returns.
+   *
+   * @param iid The id add() returned.
+   */
+  void remove(std::uint32_t iid);
+
+  /**
+   * Runs every loop which is due on the next tick. The executor's task calls this every base
+   * period; call it directly to run the loops without starting the task.
+   */
+  void tick();
+
+  /**
+   * Returns the time between ticks.
+   *
+   * @return The time between ticks.
+   */
+  QTime getBasePeriod() const;
+
+  /**
+   * Returns how late the executor's task runs. Deadline misses are logged as warnings.
+   *
+   * @return The timing stats.
+   */
+  std::shared_ptr<LoopTimingStats> getTimingStats() const;
+
+  /**
+   * Returns the number of loops.
+   *
+   * @return The number of loops.
+   */
+  std::size_t size() const;
+
+  /**
+   * Starts the task which ticks the executor. The task runs at a higher priority than the default
+   * so control loops are not delayed by user code.
+   */
+  void startThread();
+
+  protected:
+  struct ControlLoop {
+    std::uint32_t id;
+    std::uint32_t periodTicks;
+    std::function<void()> step;
+  };
+
+  Logger *logger;
+  QTime basePeriod;
+  std::unique_ptr<AbstractRate> rate;
+  mutable CrossplatformMutex loopsMutex;
+  std::vector<ControlLoop> loops{};
+  std::uint32_t nextId{0};
+  std::uint64_t ticks{0};
+  std::atomic_bool dtorCalled{false};
+  CrossplatformThread *task{nullptr};
+
+  static void trampoline(void *context);
+  void loop();
+
+  /**
+   * Converts a period to a number of ticks. Throws std::invalid_argument if the period is not a
+   * positive multiple of the base period.
+   */
+  std::uint32_t toTicks(QTime iperiod) const;
+};
+} // namespace okapi
@@ -29,13 +29,10 @@ template <typename Input, typename Output> class ControllerRunner {
    * @return the error when settled
    */
   virtual Output runUntilSettled(const Input itarget, AsyncController<Input, Output> &icontroller) {
-    logger->info("ControllerRunner: runUntilSettled(AsyncController): Set target to " +
-                 std::to_string(itarget));
+    logger->info("ControllerRunner: runUntilSettled(AsyncController): Set target to %s",
+                 [&]() { return std::to_string(itarget); });
     icontroller.setTarget(itarget);
-
-    while (!icontroller.isSettled()) {
-      rate->delay(10);
-    }
+    icontroller.waitUntilSettled();
 
     logger->info("ControllerRunner: runUntilSettled(AsyncController): Done waiting to settle");
     return icontroller.getError();
@@ -52,8 +49,8 @@ template <typename Input, typename Output> class ControllerRunner {
   virtual Output runUntilSettled(const Input itarget,
                                  IterativeController<Input, Output> &icontroller,
                                  ControllerOutput<Output> &ioutput) {
-    logger->info("ControllerRunner: runUntilSettled(IterativeController): Set target to " +
-                 std::to_string(itarget));
+    logger->info("ControllerRunner: runUntilSettled(IterativeController): Set target to %s",
+                 [&]() { return std::to_string(itarget); });
     icontroller.setTarget(itarget);
 
     while (!icontroller.isSettled()) {
@@ -74,8 +71,8 @@ template <typename Input, typename Output> class ControllerRunner {
    */
   virtual Output runUntilAtTarget(const Input itarget,
                                   AsyncController<Input, Output> &icontroller) {
-    logger->info("ControllerRunner: runUntilAtTarget(AsyncController): Set target to " +
-                 std::to_string(itarget));
+    logger->info("ControllerRunner: runUntilAtTarget(AsyncController): Set target to %s",
+                 [&]() { return std::to_string(itarget); });
     icontroller.setTarget(itarget);
 
     double error = icontroller.getError();
@@ -101,8 +98,8 @@ template <typename Input, typename Output> class ControllerRunner {
   virtual Output runUntilAtTarget(const Input itarget,
                                   IterativeController<Input, Output> &icontroller,
                                   ControllerOutput<Output> &ioutput) {
-    logger->info("ControllerRunner: runUntilAtTarget(IterativeController): Set target to " +
-                 std::to_string(itarget));
+    logger->info("ControllerRunner: runUntilAtTarget(IterativeController): Set target to %s",
+                 [&]() { return std::to_string(itarget); });
     icontroller.setTarget(itarget);
 
     double error = icontroller.getError();
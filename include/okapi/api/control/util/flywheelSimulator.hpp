@@ -8,11 +8,35 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <functional>
 
 namespace okapi {
 class FlywheelSimulator {
   public:
+  /**
+   * How the simulation advances one timestep.
+   */
+  enum class Integrator {
+    /**
+     * Explicit Euler, which scales the acceleration by the square of the timestep. This is the
+     * default so existing simulations keep their behavior.
+     */
+    euler,
+
+    /**
+     * Semi-implicit Euler: updates the omega, then the angle from the new omega. Stays stable at
+     * larger timesteps than explicit Euler for about the same cost.
+     */
+    semiImplicitEuler,
+
+    /**
+     * Classic fourth-order Runge-Kutta. Evaluates the torque four times per step, but stays
+     * accurate at much larger timesteps.
+     */
+    rk4
+  };
+
   /**
    * A simulator for an inverted pendulum. The center of mass of the system changes as the link
    * rotates (by default, you can set a new torque function with setExternalTorqueFunction()).
@@ -40,6 +64,25 @@ class FlywheelSimulator {
    */
   double step(double itorque);
 
+  /**
+   * Steps the simulation by the timestep isteps times. This runs the steps in one loop, so it is
+   * much faster than calling step() isteps times. Subclasses which override stepImpl() are not
+   * called.
+   *
+   * @param isteps the number of steps
+   * @return the current angle
+   */
+  double stepN(std::size_t isteps);
+
+  /**
+   * Steps the simulation until the simulated time reaches itime. Does nothing if the simulated
+   * time is already at or after itime. See stepN().
+   *
+   * @param itime the time to step until (sec)
+   * @return the current angle
+   */
+  double simulateUntil(double itime);
+
   /**
    * Sets the torque function used to calculate the torque due to external forces. This torque gets
    * summed with the input torque.
@@ -49,7 +92,8 @@ class FlywheelSimulator {
    *   return (linkLength * std::cos(angle)) * (mass * -1 * gravity);
    * }
    *
-   * @param itorqueFunc the torque function. The return value is the torque due to external forces
+   * @param itorqueFunc the torque function. The return value is the torque due to external forces.
+   * Pass nullptr if there are no external forces, which is faster than a function returning 0.
    */
   void setExternalTorqueFunction(
     std::function<double(double angle, double mass, double linkLength)> itorqueFunc);
@@ -110,6 +154,13 @@ class FlywheelSimulator {
    */
   void setTimestep(double itimestep);
 
+  /**
+   * Sets the integrator used to step the simulation.
+   *
+   * @param iintegrator new integrator
+   */
+  void setIntegrator(Integrator iintegrator);
+
   /**
    * Returns the current angle (angle in rad).
    *
@@ -138,6 +189,13 @@ class FlywheelSimulator {
    */
   double getMaxTorque() const;
 
+  /**
+   * Returns the simulated time (sec), which starts at 0 and advances by the timestep every step.
+   *
+   * @return the simulated time
+   */
+  double getTime() const;
+
   protected:
   double inputTorque = 0;    // N*m
   double maxTorque = 0.5649; // N*m
@@ -149,11 +207,31 @@ class FlywheelSimulator {
   double muStatic;           // N*m
   double muDynamic;          // N*m
   double timestep;           // sec
+  double time = 0;           // sec
   double I = 0;              // moment of inertia
+  Integrator integrator = Integrator::euler;
+  bool gravityTorque = true; // Whether torqueFunc is the default torque function
   std::function<double(double, double, double)> torqueFunc;
 
   const double minTimestep = 0.000001; // 1 us
 
   virtual double stepImpl();
+
+  /**
+   * Steps the simulation isteps times, calling the torque function directly instead of through a
+   * std::function where possible.
+   */
+  double advance(std::size_t isteps);
+
+  /**
+   * Steps the simulation isteps times with the given external torque function.
+   */
+  template <typename TorqueFunc>
+  void advance(std::size_t isteps, const TorqueFunc &iexternalTorque);
+
+  /**
+   * Keeps the link between 0 and pi, stopping it at either end.
+   */
+  void applyHardStops();
 };
 } // namespace okapi
@@ -0,0 +1,76 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/util/timeUtil.hpp"
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace okapi {
+class PathFuture {
+  public:
+  enum class Status { pending, ready, failed };
+
+  /**
+   * The state shared between a PathFuture and the thread generating its path. The error message
+   * must be written before status is set to failed.
+   */
+  struct State {
+    explicit State(std::string ipathId);
+
+    const std::string pathId;
+    std::atomic<Status> status{Status::pending};
+    std::string error{""};
+  };
+
+  /**
+   * The result of a path which is being generated in another thread.
+   *
+   * @param istate The state shared with the generating thread.
+   * @param itimeUtil The TimeUtil to wait with.
+   */
+  PathFuture(std::shared_ptr<State> istate, const TimeUtil &itimeUtil);
+
+  /**
+   * Returns whether the path is still being generated.
+   *
+   * @return The status of the path.
+   */
+  Status getStatus() const;
+
+  /**
+   * Returns whether the path has finished generating, successfully or not.
+   *
+   * @return Whether the path has finished generating.
+   */
+  bool isDone() const;
+
+  /**
+   * Blocks the current task until the path has finished generating, successfully or not.
+   */
+  void wait() const;
+
+  /**
+   * Blocks the current task until the path has finished generating. Throws a std::runtime_error
+   * describing the problem if the path could not be generated.
+   */
+  void get() const;
+
+  /**
+   * Returns the identifier the path will be saved with.
+   *
+   * @return The path identifier.
+   */
+  const std::string &getPathId() const;
+
+  protected:
+  std::shared_ptr<State> state;
+  TimeUtil timeUtil;
+};
+} // namespace okapi
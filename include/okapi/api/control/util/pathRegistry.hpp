@@ -0,0 +1,262 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/coreProsAPI.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace okapi {
+/**
+ * Refers to a path saved in a motion profile controller. Handles are small enough to copy and
+ * store atomically, and looking up the path for a handle does not search or allocate.
+ */
+class PathHandle {
+  public:
+  /**
+   * A handle which does not refer to any path.
+   */
+  constexpr PathHandle() = default;
+
+  /**
+   * Returns whether this handle was given out by a registry. A valid handle may still have no path
+   * saved for it.
+   *
+   * @return Whether this handle was given out by a registry.
+   */
+  constexpr bool isValid() const {
+    return id != invalidId;
+  }
+
+  constexpr bool operator==(const PathHandle &other) const {
+    return id == other.id;
+  }
+
+  constexpr bool operator!=(const PathHandle &other) const {
+    return id != other.id;
+  }
+
+  constexpr bool operator<(const PathHandle &other) const {
+    return id < other.id;
+  }
+
+  protected:
+  template <typename T> friend class PathRegistry;
+
+  static constexpr std::uint32_t invalidId = 0xFFFFFFFF;
+
+  // The low 16 bits are the slot and the high 16 bits count how many times the slot was reused
+  constexpr explicit PathHandle(const std::uint32_t iid) : id(iid) {
+  }
+
+  std::uint32_t id{invalidId};
+};
+
+/**
+ * Saves paths in a dense array of slots indexed by PathHandle. Names are interned: each name gets
+ * one slot for the life of the registry, so a handle for a name stays valid while the path saved
+ * for it is replaced or removed. Unnamed slots are reused once their path is removed, and handles
+ * to them become stale instead of referring to the next path saved in the slot.
+ *
+ * Every method locks the registry, so it can be used from several threads at once.
+ *
+ * @tparam T The type of path.
+ */
+template <typename T> class PathRegistry {
+  public:
+  PathRegistry() = default;
+
+  PathRegistry(PathRegistry &&other) noexcept {
+    std::lock_guard<CrossplatformMutex> lock(other.mutex);
+    slots = std::move(other.slots);
+    names = std::move(other.names);
+    freeSlots = std::move(other.freeSlots);
+  }
+
+  /**
+   * Returns the handle for a name, reserving a slot for it if it does not have one.
+   *
+   * @param iname The name.
+   * @return The handle for the name, or an invalid handle if the registry is full.
+   */
+  PathHandle intern(const std::string &iname) {
+    std::lock_guard<CrossplatformMutex> lock(mutex);
+    if (const auto name = names.find(iname); name != names.end()) {
+      return name->second;
+    }
+
+    const PathHandle handle = allocate(iname);
+    if (handle.isValid()) {
+      names.emplace(iname, handle);
+    }
+
+    return handle;
+  }
+
+  /**
+   * Reserves a slot with no name. The slot is freed when its path is removed.
+   *
+   * @return The handle for the slot, or an invalid handle if the registry is full.
+   */
+  PathHandle create() {
+    std::lock_guard<CrossplatformMutex> lock(mutex);
+    return allocate("");
+  }
+
+  /**
+   * Returns the handle for a name without reserving a slot.
+   *
+   * @param iname The name.
+   * @return The handle for the name, or an invalid handle if the name has no slot.
+   */
+  PathHandle find(const std::string &iname) const {
+    std::lock_guard<CrossplatformMutex> lock(mutex);
+    if (const auto name = names.find(iname); name != names.end()) {
+      return name->second;
+    }
+
+    return PathHandle();
+  }
+
+  /**
+   * Saves a path, replacing the path saved for the handle. Does nothing if the handle is stale.
+   *
+   * @param ihandle The handle.
+   * @param ipath The path.
+   * @return Whether the path was saved.
+   */
+  bool set(const PathHandle ihandle, std::shared_ptr<T> ipath) {
+    std::unique_lock<CrossplatformMutex> lock(mutex);
+    Slot *slot = getSlot(ihandle);
+    if (slot == nullptr) {
+      return false;
+    }
+
+    // Free the old path after unlocking
+    slot->path.swap(ipath);
+    lock.unlock();
+    return true;
+  }
+
+  /**
+   * Returns the path saved for a handle. The path stays alive while the returned pointer is held,
+   * even if it is removed from the registry.
+   *
+   * @param ihandle The handle.
+   * @return The path, or nullptr if the handle is stale or has no path saved for it.
+   */
+  std::shared_ptr<T> get(const PathHandle ihandle) const {
+    std::lock_guard<CrossplatformMutex> lock(mutex);
+    const Slot *slot = getSlot(ihandle);
+    return slot == nullptr ? nullptr : slot->path;
+  }
+
+  /**
+   * Removes the path saved for a handle. An unnamed slot is freed, so the handle becomes stale.
+   *
+   * @param ihandle The handle.
+   */
+  void remove(const PathHandle ihandle) {
+    std::unique_lock<CrossplatformMutex> lock(mutex);
+    Slot *slot = getSlot(ihandle);
+    if (slot == nullptr) {
+      return;
+    }
+
+    std::shared_ptr<T> path = std::move(slot->path);
+    slot->path = nullptr;
+    if (slot->name.empty()) {
+      slot->generation++;
+      freeSlots.push_back(static_cast<std::uint16_t>(ihandle.id & indexMask));
+    }
+
+    // Free the path after unlocking
+    lock.unlock();
+  }
+
+  /**
+   * Returns the name of a handle.
+   *
+   * @param ihandle The handle.
+   * @return The name, or an empty string if the handle is unnamed or stale.
+   */
+  std::string getName(const PathHandle ihandle) const {
+    std::lock_guard<CrossplatformMutex> lock(mutex);
+    const Slot *slot = getSlot(ihandle);
+    return slot == nullptr ? "" : slot->name;
+  }
+
+  /**
+   * Returns the names which have a path saved for them, in alphabetical order.
+   *
+   * @return The names.
+   */
+  std::vector<std::string> getNames() const {
+    std::lock_guard<CrossplatformMutex> lock(mutex);
+    std::vector<std::string> out;
+    for (const auto &name : names) {
+      if (slots[name.second.id & indexMask].path) {
+        out.push_back(name.first);
+      }
+    }
+
+    return out;
+  }
+
+  protected:
+  struct Slot {
+    std::shared_ptr<T> path;
+    std::string name;
+    std::uint16_t generation;
+  };
+
+  static constexpr std::uint32_t indexMask = 0xFFFF;
+  // The last index is never used so no handle is equal to the invalid handle
+  static constexpr std::size_t maxSlots = 0xFFFF;
+
+  mutable CrossplatformMutex mutex;
+  std::vector<Slot> slots{};
+  std::map<std::string, PathHandle> names{};
+  std::vector<std::uint16_t> freeSlots{};
+
+  PathHandle allocate(const std::string &iname) {
+    std::size_t index;
+    if (!freeSlots.empty()) {
+      index = freeSlots.back();
+      freeSlots.pop_back();
+      slots[index].name = iname;
+    } else if (slots.size() < maxSlots) {
+      index = slots.size();
+      slots.push_back(Slot{nullptr, iname, 0});
+    } else {
+      return PathHandle();
+    }
+
+    return PathHandle(static_cast<std::uint32_t>(slots[index].generation) << 16 |
+                      static_cast<std::uint32_t>(index));
+  }
+
+  const Slot *getSlot(const PathHandle ihandle) const {
+    const std::size_t index = ihandle.id & indexMask;
+    if (!ihandle.isValid() || index >= slots.size() ||
+        slots[index].generation != static_cast<std::uint16_t>(ihandle.id >> 16)) {
+      return nullptr;
+    }
+
+    return &slots[index];
+  }
+
+  Slot *getSlot(const PathHandle ihandle) {
+    return const_cast<Slot *>(static_cast<const PathRegistry *>(this)->getSlot(ihandle));
+  }
+};
+} // namespace okapi
@@ -13,8 +13,13 @@
 #include "okapi/api/control/iterative/iterativePosPidController.hpp"
 #include "okapi/api/units/QTime.hpp"
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/parallelFor.hpp"
+#include "okapi/api/util/supplier.hpp"
 #include "okapi/api/util/timeUtil.hpp"
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace okapi {
@@ -24,6 +29,81 @@ class PIDTuner {
     double kP, kI, kD;
   };
 
+  /**
+   * A set of gains which was tested and the error it got. Lower errors are better.
+   */
+  struct Trial {
+    Output gains;
+    double error;
+  };
+
+  enum class Strategy {
+    /**
+     * Moves a swarm of particles towards the best gains found so far. Tests numIterations *
+     * numParticles gains.
+     */
+    particleSwarm,
+
+    /**
+     * Fits a quadratic model of the error around the best gains found so far and steps to the
+     * minimum of the model, within a region which grows while the model predicts well and shrinks
+     * while it does not. Tests 7 gains per step and stops once the region is small, so it usually
+     * needs far fewer tests than particleSwarm. Tests at most numIterations * numParticles gains.
+     */
+    trustRegion
+  };
+
+  /**
+   * How relayAutotune() turns the ultimate gain and period into gains.
+   */
+  enum class RelayRule {
+    /**
+     * Ziegler-Nichols: fast, with about 25% overshoot.
+     */
+    zieglerNichols,
+
+    /**
+     * Tyreus-Luyben: slower than Ziegler-Nichols, with much less overshoot.
+     */
+    tyreusLuyben
+  };
+
+  /**
+   * The result of relayAutotune(). Every field is zero if the system did not oscillate before the
+   * timeout.
+   */
+  struct RelayResult {
+    /**
+     * The gains, in the units IterativePosPIDController takes at its default 10 ms sample time.
+     * Scaling them by 0.5 and 2 gives good bounds for autotune().
+     */
+    Output gains;
+
+    /**
+     * The proportional gain at which the system oscillates steadily.
+     */
+    double ultimateGain;
+
+    /**
+     * The period of those oscillations.
+     */
+    QTime ultimatePeriod;
+  };
+
+  /**
+   * A model of the system being tuned, for tuning in simulation. Each loop, the tuner writes its
+   * output to the model, calls step(), and reads the model back.
+   */
+  class Plant : public ControllerInput<double>, public ControllerOutput<double> {
+    public:
+    virtual ~Plant() = default;
+
+    /**
+     * Advances the model by one loop of the tuner (10 ms).
+     */
+    virtual void step() = 0;
+  };
+
   PIDTuner(const std::shared_ptr<ControllerInput<double>> &iinput,
            const std::shared_ptr<ControllerOutput<double>> &ioutput,
            const TimeUtil &itimeUtil,
@@ -42,8 +122,107 @@ class PIDTuner {
 
   virtual ~PIDTuner();
 
+  /**
+   * Tunes the real system. Each particle is tested one after another by moving the system in real
+   * time.
+   *
+   * @return The best gains found.
+   */
   virtual Output autotune();
 
+  /**
+   * Tunes against a model of the system instead of the real system. Each test runs on a new model
+   * from iplantSupplier in simulated time, so tests do not wait in real time and the particles in
+   * each iteration are tested at the same time on up to ithreads threads. Each test starts from
+   * the same state, so with a fixed seed the result is the same no matter how many threads are
+   * used. The tests use SettledUtil's default params.
+   *
+   * @param iplantSupplier Makes a new model of the system, in its starting state.
+   * @param ithreads The maximum number of threads to use.
+   * @return The best gains found.
+   */
+  virtual Output autotune(const Supplier<std::unique_ptr<Plant>> &iplantSupplier,
+                          std::size_t ithreads = defaultThreadCount());
+
+  /**
+   * Sets the seed for the random starting gains and particle movements. Tuning with the same seed
+   * against the same model gives the same result. The seed is random by default.
+   *
+   * @param iseed The seed.
+   */
+  void setSeed(std::uint32_t iseed);
+
+  /**
+   * Sets how the tuner searches for gains. The default is Strategy::particleSwarm.
+   *
+   * @param istrategy The strategy.
+   */
+  void setStrategy(Strategy istrategy);
+
+  /**
+   * Returns every test run by this tuner, including tests loaded with loadTrials().
+   *
+   * @return The trials, oldest first.
+   */
+  const std::vector<Trial> &getTrials() const;
+
+  /**
+   * Saves every test to a file so a later tuner can continue from them with loadTrials().
+   *
+   * @param ifilename The file to write.
+   * @return Whether the file was written.
+   */
+  bool saveTrials(const std::string &ifilename) const;
+
+  /**
+   * Loads tests saved with saveTrials(). Strategy::trustRegion starts from the best loaded gains
+   * instead of the middle of the bounds. The errors are only comparable if the tests used the same
+   * goal, timeout, and error weights.
+   *
+   * @param ifilename The file to read.
+   * @return Whether the file was read.
+   */
+  bool loadTrials(const std::string &ifilename);
+
+  /**
+   * Tunes the real system in a few oscillations instead of a full search. The output is switched
+   * between +irelayAmplitude and -irelayAmplitude whenever the system crosses the goal, which makes
+   * it oscillate around the goal. The ultimate gain and period are measured from those
+   * oscillations and turned into gains with irule. The first oscillation is not measured because
+   * the system is still moving to the goal.
+   *
+   * @param irule How to turn the ultimate gain and period into gains.
+   * @param irelayAmplitude The output to switch between.
+   * @param ihysteresis How far past the goal the system must go before the output switches. Raise
+   * this above the sensor noise so noise does not switch the output.
+   * @param icycles The number of oscillations to measure, including the first one. At least 2.
+   * @param itimeout The longest time to oscillate for.
+   * @return The gains and the ultimate gain and period.
+   */
+  virtual RelayResult relayAutotune(RelayRule irule = RelayRule::tyreusLuyben,
+                                    double irelayAmplitude = 1,
+                                    double ihysteresis = 0,
+                                    std::size_t icycles = 4,
+                                    QTime itimeout = 10_s);
+
+  /**
+   * Runs relayAutotune() against a model of the system in simulated time.
+   *
+   * @param iplantSupplier Makes a new model of the system, in its starting state.
+   * @param irule How to turn the ultimate gain and period into gains.
+   * @param irelayAmplitude The output to switch between.
+   * @param ihysteresis How far past the goal the system must go before the output switches.
+   * @param icycles The number of oscillations to measure, including the first one. At least 2.
+   * @param itimeout The longest time to oscillate for.
+   * @return The gains and the ultimate gain and period.
+   */
+  virtual RelayResult relayAutotune(const Supplier<std::unique_ptr<Plant>> &iplantSupplier,
+                                    RelayRule irule = RelayRule::tyreusLuyben,
+                                    double irelayAmplitude = 1,
+                                    double ihysteresis = 0,
+                                    std::size_t icycles = 4,
+                                    QTime itimeout = 10_s);
+
   protected:
   static constexpr double inertia = 0.5;   // Particle inertia
   static constexpr double confSelf = 1.1;  // Self confidence
@@ -61,6 +240,70 @@ class PIDTuner {
     double bestError;
   };
 
+  /**
+   * Tests a batch of gains and writes the error of each one.
+   */
+  using Evaluator = std::function<void(const std::vector<Output> &, std::vector<double> &)>;
+
+  /**
+   * Searches for gains with the current strategy and records every test.
+   *
+   * @param ievaluate Tests a batch of gains.
+   * @return The best gains found.
+   */
+  Output optimize(const Evaluator &ievaluate);
+
+  /**
+   * Runs the particle swarm.
+   *
+   * @param ievaluate Tests a batch of gains.
+   * @return The best gains found.
+   */
+  Output optimizeSwarm(const Evaluator &ievaluate);
+
+  /**
+   * Runs the trust region search.
+   *
+   * @param ievaluate Tests a batch of gains.
+   * @return The best gains found.
+   */
+  Output optimizeTrustRegion(const Evaluator &ievaluate);
+
+  /**
+   * Runs the relay test on a system. See relayAutotune() for the params.
+   *
+   * @param iinput The system's input.
+   * @param ioutput The system's output.
+   * @param iwait Waits for one loop.
+   * @return The gains and the ultimate gain and period.
+   */
+  RelayResult runRelay(ControllerInput<double> &iinput,
+                       ControllerOutput<double> &ioutput,
+                       const std::function<void()> &iwait,
+                       RelayRule irule,
+                       double irelayAmplitude,
+                       double ihysteresis,
+                       std::size_t icycles,
+                       QTime itimeout) const;
+
+  /**
+   * Moves a system to a target with a set of gains and returns the error.
+   *
+   * @param igains The gains to test.
+   * @param itarget The target, relative to where the system starts.
+   * @param itimeUtil The time util for the test controller.
+   * @param iinput The system's input.
+   * @param ioutput The system's output.
+   * @param iwait Waits for one loop.
+   * @return The error, weighted by kSettle and kITAE.
+   */
+  double runTrial(const Output &igains,
+                  std::int32_t itarget,
+                  const TimeUtil &itimeUtil,
+                  ControllerInput<double> &iinput,
+                  ControllerOutput<double> &ioutput,
+                  const std::function<void()> &iwait) const;
+
   Logger *logger;
   std::shared_ptr<ControllerInput<double>> input;
   std::shared_ptr<ControllerOutput<double>> output;
@@ -79,5 +322,8 @@ class PIDTuner {
   const std::size_t numParticles;
   const double kSettle;
   const double kITAE;
+  std::uint32_t seed;
+  Strategy strategy{Strategy::particleSwarm};
+  std::vector<Trial> trials{};
 };
 } // namespace okapi
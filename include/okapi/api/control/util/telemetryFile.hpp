@@ -0,0 +1,63 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/control/util/telemetryRecorder.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace okapi {
+/**
+ * Reads and writes telemetry files. A file is a 16 byte header followed by the samples, each 32
+ * bytes. Everything is little-endian.
+ *
+ * Header layout (byte offset: contents):
+ *   0: magic "OKTL"
+ *   4: format version (uint16)
+ *   6: sample size (uint16)
+ *   8: number of samples (uint32)
+ *
+ * Sample layout: time in ms (uint32), then target, reading, error, proportional, integral,
+ * derivative, and output (float32).
+ */
+class TelemetryFile {
+  public:
+  static constexpr std::uint16_t version = 1;
+  static constexpr std::size_t headerSize = 16;
+  static constexpr std::size_t sampleSize = 32;
+
+  /**
+   * Writes samples to a file, replacing it if it exists.
+   *
+   * @param ifilename The file to write.
+   * @param isamples The samples to write.
+   * @return Whether the file was written.
+   */
+  static bool write(const std::string &ifilename, const std::vector<TelemetrySample> &isamples);
+
+  /**
+   * Reads the samples in a file. Returns false if the file does not exist, and logs a warning and
+   * returns false if it is not a valid telemetry file.
+   *
+   * @param ifilename The file to read.
+   * @param osamples Where to put the samples.
+   * @return Whether the samples were read.
+   */
+  static bool read(const std::string &ifilename, std::vector<TelemetrySample> &osamples);
+
+  /**
+   * Converts a telemetry file to CSV with a header row, for reading on a computer.
+   *
+   * @param ifilename The telemetry file to read.
+   * @param icsvFilename The CSV file to write.
+   * @return Whether the file was converted.
+   */
+  static bool toCsv(const std::string &ifilename, const std::string &icsvFilename);
+};
+} // namespace okapi
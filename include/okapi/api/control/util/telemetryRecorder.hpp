@@ -0,0 +1,100 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/coreProsAPI.hpp"
+#include "okapi/api/util/abstractTimer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace okapi {
+/**
+ * One control step. Terms a controller does not have are NaN.
+ */
+struct TelemetrySample {
+  std::uint32_t time; // ms
+  float target;
+  float reading;
+  float error;
+  float proportional;
+  float integral;
+  float derivative;
+  float output;
+};
+
+class TelemetryRecorder {
+  public:
+  /**
+   * Records the state of a controller every control step into a ring buffer which is allocated
+   * up front, so recording never allocates. Once the buffer is full, each new sample replaces the
+   * oldest one. Give each controller its own recorder with IterativePosPIDController,
+   * IterativeVelPIDController, or AsyncWrapper's setTelemetryRecorder().
+   *
+   * @param itimer The timer to timestamp samples with.
+   * @param icapacity The number of samples to keep. 1000 samples covers 10 seconds of a 10 ms loop.
+   */
+  explicit TelemetryRecorder(std::unique_ptr<AbstractTimer> itimer, std::size_t icapacity = 1000);
+
+  /**
+   * Records one control step. Safe to call while another task reads the samples.
+   */
+  void record(double itarget,
+              double ireading,
+              double ierror,
+              double iproportional,
+              double iintegral,
+              double iderivative,
+              double ioutput);
+
+  /**
+   * Returns the recorded samples, oldest first.
+   *
+   * @return The samples.
+   */
+  std::vector<TelemetrySample> getSamples() const;
+
+  /**
+   * @return The number of samples recorded and not yet replaced.
+   */
+  std::size_t size() const;
+
+  /**
+   * @return The number of samples the recorder keeps.
+   */
+  std::size_t capacity() const;
+
+  /**
+   * @return The number of samples which were replaced by newer ones since the last clear().
+   */
+  std::uint32_t getOverwritten() const;
+
+  /**
+   * Forgets every sample.
+   */
+  void clear();
+
+  /**
+   * Writes the samples to a file. See TelemetryFile for the format.
+   *
+   * @param ifilename The file to write.
+   * @return Whether the file was written.
+   */
+  bool dump(const std::string &ifilename) const;
+
+  protected:
+  std::unique_ptr<AbstractTimer> timer;
+  mutable CrossplatformMutex mutex;
+  std::vector<TelemetrySample> samples;
+  std::size_t next{0};
+  std::size_t count{0};
+  std::uint32_t overwritten{0};
+};
+} // namespace okapi
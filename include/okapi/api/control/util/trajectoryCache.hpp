@@ -0,0 +1,115 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/control/util/compactTrajectory.hpp"
+#include "okapi/api/coreProsAPI.hpp"
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace okapi {
+class TrajectoryCache {
+  public:
+  /**
+   * Builds a cache key by hashing everything a generated trajectory depends on (64-bit FNV-1a).
+   */
+  class KeyBuilder {
+    public:
+    KeyBuilder &add(double ivalue);
+
+    KeyBuilder &add(std::int64_t ivalue);
+
+    KeyBuilder &add(std::string_view ivalue);
+
+    std::uint64_t get() const;
+
+    protected:
+    std::uint64_t hash{14695981039346656037ULL};
+
+    void addBytes(const void *ibytes, std::size_t isize);
+  };
+
+  /**
+   * Saves generated trajectories to files so they can be loaded instead of generated again. Each
+   * set of trajectories is stored in its own TrajectoryFile named after its key, so changing any
+   * parameter which is part of the key will miss the cache and generate (and store) a new set.
+   *
+   * @param idirectory The directory to store files in (for example, "/usd" on the brain).
+   */
+  explicit TrajectoryCache(std::string idirectory);
+
+  /**
+   * Loads the trajectories stored with a key. Counts as a hit if they were loaded and a miss
+   * otherwise. A file's checksums are only checked the first time it is loaded, and not at all if
+   * this cache stored it, so loading the same trajectories again does not read the whole file.
+   *
+   * @param ikey The key the trajectories were stored with.
+   * @param iformat The format to load the trajectories into.
+   * @param otrajectories Where to put the loaded trajectories.
+   * @return Whether the trajectories were loaded.
+   */
+  bool load(std::uint64_t ikey,
+            const CompactTrajectory::Format &iformat,
+            std::vector<CompactTrajectory> &otrajectories);
+
+  /**
+   * Stores trajectories with a key, replacing any trajectories previously stored with it.
+   *
+   * @param ikey The key to store the trajectories with.
+   * @param itrajectories The trajectories to store.
+   * @return Whether the trajectories were stored.
+   */
+  bool store(std::uint64_t ikey, std::initializer_list<const CompactTrajectory *> itrajectories);
+
+  /**
+   * Removes the trajectories stored with a key, if there are any.
+   *
+   * @param ikey The key the trajectories were stored with.
+   */
+  void invalidate(std::uint64_t ikey);
+
+  /**
+   * Returns the path of the file used for a key.
+   *
+   * @param ikey The key.
+   * @return The path of the file.
+   */
+  std::string getFilename(std::uint64_t ikey) const;
+
+  /**
+   * Returns the number of calls to load() which loaded trajectories.
+   *
+   * @return The number of cache hits.
+   */
+  std::size_t getHits() const;
+
+  /**
+   * Returns the number of calls to load() which did not load trajectories.
+   *
+   * @return The number of cache misses.
+   */
+  std::size_t getMisses() const;
+
+  protected:
+  std::string directory;
+  std::atomic_size_t hits{0};
+  std::atomic_size_t misses{0};
+  // Keys whose files were written or already verified by this cache
+  std::set<std::uint64_t> verified;
+  CrossplatformMutex verifiedMutex;
+
+  bool isVerified(std::uint64_t ikey);
+
+  void setVerified(std::uint64_t ikey, bool iverified);
+};
+} // namespace okapi
@@ -0,0 +1,96 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/control/util/compactTrajectory.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace okapi {
+/**
+ * Reads and writes trajectory files. A file holds one or more trajectories, each made of a 64 byte
+ * header followed by the trajectory's data exactly as CompactTrajectory stores it in memory, padded
+ * to 64 bytes. Everything is little-endian.
+ *
+ * Header layout (byte offset: contents):
+ *   0: magic "OKTJ"
+ *   4: format version (uint16)
+ *   6: header size (uint16)
+ *   8: number of segments (uint32)
+ *  12: field mask (uint8)
+ *  13: precision, 0 for float64 and 1 for float32 (uint8)
+ *  16: dt (float64)
+ *  24: id, free for the writer to use (uint64)
+ *  32: data size in bytes, without padding (uint64)
+ *  40: FNV-1a checksum of the data (uint32)
+ *
+ * Because the data is aligned and already in the in-memory layout, a file is memory mapped (or on
+ * the brain, read with a single read) and the loaded trajectories point straight into it.
+ */
+class TrajectoryFile {
+  public:
+  static constexpr std::uint16_t version = 1;
+  static constexpr std::size_t headerSize = 64;
+  static constexpr std::size_t alignment = 64;
+
+  /**
+   * Writes trajectories to a file, replacing it if it exists.
+   *
+   * @param ifilename The file to write.
+   * @param itrajectories The trajectories to write.
+   * @param iid An id stored in the header of every trajectory.
+   * @return Whether the file was written.
+   */
+  static bool write(const std::string &ifilename,
+                    const std::vector<const CompactTrajectory *> &itrajectories,
+                    std::uint64_t iid = 0);
+
+  /**
+   * Loads the trajectories in a file. The trajectories use the file's data in place and keep it
+   * mapped until the last of them is destroyed. Returns false if the file does not exist, and logs
+   * a warning and returns false if it is not a valid trajectory file.
+   *
+   * Checking the checksums reads every byte of the file, which pulls the whole mapping into memory.
+   * Pass false for iverify to skip them for a file which was already verified or was written by
+   * this program; the headers are still checked.
+   *
+   * @param ifilename The file to read.
+   * @param otrajectories Where to put the loaded trajectories.
+   * @param oid If not null, set to the id the trajectories were written with.
+   * @param iverify Whether to check the checksum of each trajectory's data.
+   * @return Whether the trajectories were loaded.
+   */
+  static bool read(const std::string &ifilename,
+                   std::vector<CompactTrajectory> &otrajectories,
+                   std::uint64_t *oid = nullptr,
+                   bool iverify = true);
+
+  /**
+   * Converts a file written by pathfinder_serialize() (or several such trajectories written back
+   * to back) to a trajectory file.
+   *
+   * @param ilegacyFilename The file written by pathfinder_serialize().
+   * @param ifilename The trajectory file to write.
+   * @param iformat The fields and precision to keep.
+   * @return Whether the file was converted.
+   */
+  static bool convertLegacy(const std::string &ilegacyFilename,
+                            const std::string &ifilename,
+                            const CompactTrajectory::Format &iformat = {});
+
+  /**
+   * Computes the checksum stored in a trajectory header.
+   *
+   * @param idata The data to checksum.
+   * @param isize The number of bytes of data.
+   * @return The checksum.
+   */
+  static std::uint32_t checksum(const std::uint8_t *idata, std::size_t isize);
+};
+} // namespace okapi
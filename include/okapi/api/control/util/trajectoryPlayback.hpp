@@ -0,0 +1,70 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/units/QTime.hpp"
+#include "okapi/api/util/abstractRate.hpp"
+#include "okapi/api/util/abstractTimer.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace okapi {
+class TrajectoryPlayback {
+  public:
+  /**
+   * Plays a trajectory back in real time, outputting once per period instead of once per segment.
+   * Motors only take a new setpoint every motorUpdateRate, so there is no point outputting more
+   * often than that.
+   *
+   * The segment to output is found from the time since playback started rather than by counting
+   * ticks, so a slow tick does not delay the rest of the trajectory. Ticks which are missed
+   * entirely are skipped instead of being run late. If the rate is tracking deadlines, each overrun
+   * which causes ticks to be skipped is recorded as a deadline miss.
+   *
+   * @param itimer The timer to measure elapsed time with.
+   * @param irate The rate to wait for each tick with.
+   * @param iperiod The time between outputs, or zero to output once per segment.
+   */
+  TrajectoryPlayback(std::unique_ptr<AbstractTimer> itimer,
+                     std::unique_ptr<AbstractRate> irate,
+                     QTime iperiod);
+
+  /**
+   * Calls isample once per period with the fractional index of the segment for the current time,
+   * until the last segment has been sampled or isample returns false. The last segment is always
+   * sampled unless playback is stopped first.
+   *
+   * @param ilength The number of segments in the trajectory.
+   * @param idt The time between segments.
+   * @param isample Outputs the trajectory at an index. Returns false to stop playback.
+   */
+  void play(std::size_t ilength, QTime idt, const std::function<bool(double)> &isample);
+
+  /**
+   * Returns the number of times isample was called during the last playback.
+   *
+   * @return The number of ticks.
+   */
+  std::size_t getTicks() const;
+
+  /**
+   * Returns the number of ticks skipped during the last playback because an earlier tick overran.
+   *
+   * @return The number of skipped ticks.
+   */
+  std::size_t getSkippedTicks() const;
+
+  protected:
+  std::unique_ptr<AbstractTimer> timer;
+  std::unique_ptr<AbstractRate> rate;
+  QTime period;
+  std::size_t ticks{0};
+  std::size_t skippedTicks{0};
+};
+} // namespace okapi
@@ -14,39 +14,301 @@
 #include <cstdio>
 #include <cstdlib>
 #include <functional>
+#include <mutex>
 
 #ifdef THREADS_STD
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <thread>
 #define CROSSPLATFORM_THREAD_T std::thread
+#define CROSSPLATFORM_THREAD_ID_T std::thread::id
+#define CROSSPLATFORM_MUTEX_T std::mutex
 #else
 #include "api.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
 #define CROSSPLATFORM_THREAD_T pros::task_t
+#define CROSSPLATFORM_THREAD_ID_T pros::task_t
+#define CROSSPLATFORM_MUTEX_T pros::mutex_t
+
+extern "C" {
+// Declared in pros/apix.h, which is not included because it brings in LVGL
+pros::task_t mutex_get_owner(pros::mutex_t mutex);
+}
 #endif
 
 class CrossplatformThread {
   public:
-  CrossplatformThread(void (*ptr)(void *), void *params)
-    :
+#ifdef THREADS_STD
+  // Threads are not prioritized, but keep the same range as PROS
+  static constexpr std::uint32_t minPriority = 1;
+  static constexpr std::uint32_t defaultPriority = 8;
+  static constexpr std::uint32_t maxPriority = 16;
+#else
+  static constexpr std::uint32_t minPriority = TASK_PRIORITY_MIN;
+  static constexpr std::uint32_t defaultPriority = TASK_PRIORITY_DEFAULT;
+  static constexpr std::uint32_t maxPriority = TASK_PRIORITY_MAX;
+#endif
+
+  CrossplatformThread(void (*ptr)(void *),
+                      void *params,
+                      const std::uint32_t ipriority = defaultPriority)
+    : function(ptr),
+      functionParams(params),
 #ifdef THREADS_STD
       thread(ptr, params)
 #else
-      thread(pros::c::task_create(ptr,
-                                  params,
-                                  TASK_PRIORITY_DEFAULT,
+      thread(pros::c::task_create(run,
+                                  this,
+                                  ipriority,
                                   TASK_STACK_DEPTH_DEFAULT,
                                   "OkapiLibCrossplatformTask"))
 #endif
   {
+#ifdef THREADS_STD
+    static_cast<void>(ipriority);
+#endif
   }
 
   ~CrossplatformThread() {
 #ifdef THREADS_STD
-    thread.join();
+    if (thread.joinable()) {
+      thread.join();
+    }
 #else
     pros::c::task_delete(thread);
 #endif
   }
 
+  /**
+   * Blocks until the thread's function returns. Unlike deleting the thread, this never stops the
+   * function partway through, so tell it to return first.
+   */
+  void join() {
+#ifdef THREADS_STD
+    if (thread.joinable()) {
+      thread.join();
+    }
+#else
+    while (!finished.load(std::memory_order_acquire)) {
+      pros::c::task_delay(1);
+    }
+#endif
+  }
+
+  /**
+   * Returns an id for the calling thread which is different from the id of every other running
+   * thread.
+   *
+   * @return The id of the calling thread.
+   */
+  static CROSSPLATFORM_THREAD_ID_T getCurrentId() {
+#ifdef THREADS_STD
+    return std::this_thread::get_id();
+#else
+    // PROS has no call for the current task, but a task owns a mutex while it holds it
+    static const pros::mutex_t idMutex = pros::c::mutex_create();
+    pros::c::mutex_take(idMutex, TIMEOUT_MAX);
+    const pros::task_t self = ::mutex_get_owner(idMutex);
+    pros::c::mutex_give(idMutex);
+    return self;
+#endif
+  }
+
+  /**
+   * Lets other threads run before the calling thread continues.
+   */
+  static void yield() {
+#ifdef THREADS_STD
+    std::this_thread::yield();
+#else
+    pros::c::task_delay(1);
+#endif
+  }
+
   protected:
+  void (*function)(void *);
+  void *functionParams;
+  std::atomic_bool finished{false};
   CROSSPLATFORM_THREAD_T thread;
+
+#ifndef THREADS_STD
+  static void run(void *ithread) {
+    auto *self = static_cast<CrossplatformThread *>(ithread);
+    self->function(self->functionParams);
+    self->finished.store(true, std::memory_order_release);
+
+    // Wait to be deleted so the task handle stays valid for the destructor
+    while (true) {
+      pros::c::task_delay(TIMEOUT_MAX);
+    }
+  }
+#endif
+};
+
+/**
+ * A mutex which works with std::lock_guard. PROS has no way to delete a mutex, so on the brain the
+ * underlying mutex is never freed; only create these for objects which live for a long time.
+ */
+class CrossplatformMutex {
+  public:
+  CrossplatformMutex()
+#ifndef THREADS_STD
+    : mutex(pros::c::mutex_create())
+#endif
+  {
+  }
+
+  CrossplatformMutex(const CrossplatformMutex &) = delete;
+  CrossplatformMutex &operator=(const CrossplatformMutex &) = delete;
+
+  void lock() {
+#ifdef THREADS_STD
+    mutex.lock();
+#else
+    pros::c::mutex_take(mutex, TIMEOUT_MAX);
+#endif
+  }
+
+  void unlock() {
+#ifdef THREADS_STD
+    mutex.unlock();
+#else
+    pros::c::mutex_give(mutex);
+#endif
+  }
+
+  protected:
+  friend class CrossplatformConditionVariable;
+
+  CROSSPLATFORM_MUTEX_T mutex;
+};
+
+/**
+ * A condition variable which waits with a locked CrossplatformMutex. On the brain, waiting tasks
+ * are woken with task notifications.
+ *
+ * Waiters are only guaranteed to see a change if the change is made, or notifyAll() is called,
+ * while holding the mutex they wait with. Changes made without the mutex are still seen the next
+ * time notifyAll() is called.
+ */
+class CrossplatformConditionVariable {
+  public:
+  CrossplatformConditionVariable()
+#ifndef THREADS_STD
+    : waitersMutex(pros::c::mutex_create())
+#endif
+  {
+  }
+
+  CrossplatformConditionVariable(const CrossplatformConditionVariable &) = delete;
+  CrossplatformConditionVariable &operator=(const CrossplatformConditionVariable &) = delete;
+
+  /**
+   * Blocks until ipredicate returns true. ilock is unlocked while blocked and locked while
+   * ipredicate is called.
+   *
+   * @param ilock The lock on the mutex which guards the state ipredicate reads.
+   * @param ipredicate The condition to wait for.
+   */
+  template <typename Predicate>
+  void wait(std::unique_lock<CrossplatformMutex> &ilock, Predicate ipredicate) {
+    waiterCount++;
+#ifdef THREADS_STD
+    condition.wait(ilock, ipredicate);
+#else
+    while (!ipredicate()) {
+      waitForNotification(ilock, TIMEOUT_MAX);
+    }
+#endif
+    waiterCount--;
+  }
+
+  /**
+   * Blocks until ipredicate returns true or the timeout passes.
+   *
+   * @param ilock The lock on the mutex which guards the state ipredicate reads.
+   * @param ims The timeout in milliseconds.
+   * @param ipredicate The condition to wait for.
+   * @return The last value returned by ipredicate.
+   */
+  template <typename Predicate>
+  bool waitFor(std::unique_lock<CrossplatformMutex> &ilock,
+               const std::uint32_t ims,
+               Predicate ipredicate) {
+    waiterCount++;
+#ifdef THREADS_STD
+    const bool out = condition.wait_for(ilock, std::chrono::milliseconds(ims), ipredicate);
+#else
+    const std::uint32_t start = pros::c::millis();
+    bool out = ipredicate();
+    while (!out) {
+      const std::uint32_t elapsed = pros::c::millis() - start;
+      if (elapsed >= ims) {
+        break;
+      }
+
+      waitForNotification(ilock, ims - elapsed);
+      out = ipredicate();
+    }
+#endif
+    waiterCount--;
+    return out;
+  }
+
+  /**
+   * Wakes every waiting task so it checks its predicate again.
+   */
+  void notifyAll() {
+#ifdef THREADS_STD
+    condition.notify_all();
+#else
+    pros::c::mutex_take(waitersMutex, TIMEOUT_MAX);
+    for (const auto task : waiters) {
+      pros::c::task_notify(task);
+    }
+    waiters.clear();
+    pros::c::mutex_give(waitersMutex);
+#endif
+  }
+
+  /**
+   * Returns whether any task is waiting. A task which has just started waiting might not be
+   * counted yet, so this is only a hint for skipping work when nobody is waiting.
+   *
+   * @return Whether any task is waiting.
+   */
+  bool hasWaiters() const {
+    return waiterCount.load(std::memory_order_acquire) > 0;
+  }
+
+  protected:
+  std::atomic_size_t waiterCount{0};
+#ifdef THREADS_STD
+  std::condition_variable_any condition;
+#else
+  pros::mutex_t waitersMutex;
+  std::vector<pros::task_t> waiters;
+
+  void waitForNotification(std::unique_lock<CrossplatformMutex> &ilock, const std::uint32_t ims) {
+    // The waiting task holds the mutex, so it owns it
+    const pros::task_t self = ::mutex_get_owner(ilock.mutex()->mutex);
+
+    pros::c::mutex_take(waitersMutex, TIMEOUT_MAX);
+    waiters.push_back(self);
+    pros::c::mutex_give(waitersMutex);
+
+    // Notifications are counted, so one sent between unlocking and taking it is not lost
+    ilock.unlock();
+    pros::c::task_notify_take(true, ims);
+    ilock.lock();
+
+    // Stop waiting for a notification if this timed out
+    pros::c::mutex_take(waitersMutex, TIMEOUT_MAX);
+    waiters.erase(std::remove(waiters.begin(), waiters.end(), self), waiters.end());
+    pros::c::mutex_give(waitersMutex);
+  }
+#endif
 };
@@ -10,6 +10,8 @@
 #include "okapi/api/coreProsAPI.hpp"
 #include "okapi/api/units/QFrequency.hpp"
 #include "okapi/api/units/QTime.hpp"
+#include "okapi/api/util/loopTimingStats.hpp"
+#include <memory>
 
 namespace okapi {
 class AbstractRate {
@@ -47,5 +49,34 @@ class AbstractRate {
    * @param ims the time period
    */
   virtual void delayUntil(uint32_t ims) = 0;
+
+  /**
+   * Starts recording how late each delay ends into istats. A delay which starts after the time it
+   * was supposed to end at is recorded as a deadline miss. Several rates can share the same stats.
+   *
+   * Only implementations which know when their delays are scheduled to end record anything.
+   *
+   * @param istats The stats to record into, or nullptr to stop recording.
+   */
+  void trackDeadlines(std::shared_ptr<LoopTimingStats> istats);
+
+  /**
+   * Returns the stats this rate records into.
+   *
+   * @return The stats, or nullptr if this rate is not recording.
+   */
+  std::shared_ptr<LoopTimingStats> getTimingStats() const;
+
+  protected:
+  std::shared_ptr<LoopTimingStats> timingStats{nullptr};
+
+  /**
+   * Records one delay if deadlines are being tracked. Implementations call this after every delay.
+   *
+   * @param istart When the delay was started, in ms.
+   * @param ideadline When the delay was scheduled to end, in ms.
+   * @param iwoke When the delay actually ended, in ms.
+   */
+  void recordDelay(std::uint32_t istart, std::uint32_t ideadline, std::uint32_t iwoke);
 };
 } // namespace okapi
@@ -0,0 +1,103 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/coreProsAPI.hpp"
+#include "okapi/api/util/abstractRate.hpp"
+#include "okapi/api/util/mpscRingBuffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string_view>
+
+namespace okapi {
+class AsyncLogWriter {
+  public:
+  /**
+   * The longest message a record holds. Longer messages are truncated.
+   */
+  static constexpr std::size_t maxMessageLength = 116;
+
+  /**
+   * The number of records which can be waiting to be written. Records logged while the queue is
+   * full are dropped.
+   */
+  static constexpr std::size_t queueLength = 64;
+
+  /**
+   * Writes log statements to a file from a low priority task. Logging copies the statement into a
+   * fixed-size record in a lock-free queue, so it never allocates, locks, or waits for the file.
+   *
+   * @param ifile The file to write to.
+   * @param irate The rate to wait with when there is nothing to write.
+   */
+  AsyncLogWriter(FILE *ifile, std::unique_ptr<AbstractRate> irate);
+
+  AsyncLogWriter(const AsyncLogWriter &) = delete;
+  AsyncLogWriter &operator=(const AsyncLogWriter &) = delete;
+
+  /**
+   * Stops the writer task and writes the records still in the queue.
+   */
+  ~AsyncLogWriter();
+
+  /**
+   * Queues a log statement to be written. Safe to call from any task.
+   *
+   * @param itime The time the statement was logged, in ms.
+   * @param ilevelName The name of the level. Must point to a string which is never freed.
+   * @param imessage The message.
+   * @return Whether there was room in the queue.
+   */
+  bool push(std::uint32_t itime, const char *ilevelName, std::string_view imessage);
+
+  /**
+   * Writes every queued record and flushes the file. Blocks until they are written.
+   */
+  void flush();
+
+  /**
+   * Returns the number of records dropped because the queue was full.
+   *
+   * @return The number of dropped records.
+   */
+  std::uint32_t getDropped() const;
+
+  /**
+   * Starts the writer task. Until it is started, records are only written by flush().
+   */
+  void startThread();
+
+  protected:
+  struct Record {
+    std::uint32_t time;
+    const char *levelName;
+    std::uint16_t length;
+    char message[maxMessageLength];
+  };
+
+  FILE *file;
+  std::unique_ptr<AbstractRate> rate;
+  MpscRingBuffer<Record, queueLength> queue{};
+  std::atomic<std::uint32_t> dropped{0};
+  std::atomic_bool dtorCalled{false};
+  CrossplatformMutex drainMutex;
+  CrossplatformThread *task{nullptr};
+
+  static void trampoline(void *context);
+  void loop();
+
+  /**
+   * Writes every queued record. Only one task may drain at a time.
+   *
+   * @return Whether anything was written.
+   */
+  bool drain();
+};
+} // namespace okapi
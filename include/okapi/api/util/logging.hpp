@@ -8,9 +8,27 @@
 #pragma once
 
 #include "okapi/api/util/abstractTimer.hpp"
+#include "okapi/api/util/mathUtil.hpp"
+#include <atomic>
+#include <cstdio>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * The most verbose log level compiled in, as the value of a Logger::LogLevel. Log statements at
+ * more verbose levels are removed at compile time, including evaluating their arguments if they are
+ * deferred. Defaults to 4 (debug). Define it as 2 (warn) to remove debug and info logging.
+ */
+#ifndef OKAPI_LOG_LEVEL
+#define OKAPI_LOG_LEVEL 4
+#endif
 
 namespace okapi {
+class AbstractRate;
+class AsyncLogWriter;
+
 class Logger {
   public:
   enum class LogLevel { off = 0, debug = 4, info = 3, warn = 2, error = 1 };
@@ -50,24 +68,168 @@ class Logger {
    */
   static void setLogLevel(LogLevel level) noexcept;
 
-  void debug(std::string_view message) const noexcept;
+  /**
+   * Returns whether log statements at a level are compiled in. See OKAPI_LOG_LEVEL.
+   *
+   * @param ilevel The level.
+   * @return Whether the level is compiled in.
+   */
+  static constexpr bool isCompiledIn(const LogLevel ilevel) noexcept {
+    return ilevel != LogLevel::off && toUnderlyingType(ilevel) <= OKAPI_LOG_LEVEL;
+  }
+
+  /**
+   * Returns whether a log statement at a level would be written. This only checks the level and
+   * whether the logger is initialized, so it is cheap enough to call on every loop.
+   *
+   * @param ilevel The level.
+   * @return Whether a log statement at the level would be written.
+   */
+  static bool isEnabled(const LogLevel ilevel) noexcept {
+    return isCompiledIn(ilevel) && toUnderlyingType(logLevel) >= toUnderlyingType(ilevel) &&
+           logfile && timer;
+  }
+
+  void debug(std::string_view message) const noexcept {
+    log<LogLevel::debug>(message);
+  }
+
+  void info(std::string_view message) const noexcept {
+    log<LogLevel::info>(message);
+  }
+
+  void warn(std::string_view message) const noexcept {
+    log<LogLevel::warn>(message);
+  }
+
+  void error(std::string_view message) const noexcept {
+    log<LogLevel::error>(message);
+  }
+
+  /**
+   * Logs a printf-style message. The message is only formatted if the level is enabled, so a
+   * disabled log statement costs a level check. Arguments which are callable are deferred: they
+   * are only called, and their results printed, if the message is written. std::string arguments
+   * (including ones returned by deferred arguments) are printed with %s.
+   *
+   * @param iformat The printf-style format string.
+   * @param iargs The arguments to format.
+   */
+  template <typename Arg, typename... Args>
+  void debug(const char *iformat, const Arg &iarg, const Args &... iargs) const noexcept {
+    logf<LogLevel::debug>(iformat, iarg, iargs...);
+  }
+
+  /**
+   * Logs a printf-style message. See debug(const char *, ...).
+   */
+  template <typename Arg, typename... Args>
+  void info(const char *iformat, const Arg &iarg, const Args &... iargs) const noexcept {
+    logf<LogLevel::info>(iformat, iarg, iargs...);
+  }
+
+  /**
+   * Logs a printf-style message. See debug(const char *, ...).
+   */
+  template <typename Arg, typename... Args>
+  void warn(const char *iformat, const Arg &iarg, const Args &... iargs) const noexcept {
+    logf<LogLevel::warn>(iformat, iarg, iargs...);
+  }
+
+  /**
+   * Logs a printf-style message. See debug(const char *, ...).
+   */
+  template <typename Arg, typename... Args>
+  void error(const char *iformat, const Arg &iarg, const Args &... iargs) const noexcept {
+    logf<LogLevel::error>(iformat, iarg, iargs...);
+  }
+
+  /**
+   * Starts writing log statements from a low priority task instead of from the task which logs
+   * them, so a slow log file does not delay control loops. Logging then only copies the statement
+   * into a queue. Statements logged while the queue is full are dropped, and statements longer
+   * than AsyncLogWriter::maxMessageLength are truncated. Call after initialize(); initializing the
+   * logger again stops the writer.
+   *
+   * @param irate The rate the writer task waits with when there is nothing to write.
+   */
+  static void startAsyncWriter(std::unique_ptr<AbstractRate> irate) noexcept;
 
-  void info(std::string_view message) const noexcept;
+  /**
+   * Stops the writer task started by startAsyncWriter() and writes the statements still queued.
+   * Log statements are then written by the task which logs them again. Safe to call while other
+   * tasks are logging; blocks until none of them is using the writer.
+   */
+  static void stopAsyncWriter() noexcept;
 
-  void warn(std::string_view message) const noexcept;
+  /**
+   * Writes every queued log statement and flushes the log file. Blocks until they are written.
+   */
+  static void flush() noexcept;
 
-  void error(std::string_view message) const noexcept;
+  /**
+   * Returns the number of log statements dropped because the writer task fell behind.
+   *
+   * @return The number of dropped statements.
+   */
+  static std::uint32_t getDroppedMessages() noexcept;
 
   /**
-   * Closes the connection to the log file.
+   * Writes every queued log statement and closes the connection to the log file.
    */
   void close() noexcept;
 
   private:
   Logger();
+
+  template <LogLevel level> void log(std::string_view message) const noexcept {
+    if constexpr (isCompiledIn(level)) {
+      if (isEnabled(level)) {
+        write(level, message);
+      }
+    }
+  }
+
+  template <LogLevel level, typename... Args>
+  void logf(const char *iformat, const Args &... iargs) const noexcept {
+    if constexpr (isCompiledIn(level)) {
+      if (isEnabled(level)) {
+        // Deferred arguments are called here and their results live until writef returns
+        writef(level, iformat, toFormatArg(resolve(iargs))...);
+      }
+    }
+  }
+
+  template <typename T> static decltype(auto) resolve(const T &iarg) {
+    if constexpr (std::is_invocable_v<const T &>) {
+      return iarg();
+    } else {
+      return (iarg);
+    }
+  }
+
+  template <typename T> static const T &toFormatArg(const T &iarg) {
+    return iarg;
+  }
+
+  static const char *toFormatArg(const std::string &iarg) {
+    return iarg.c_str();
+  }
+
+  static const char *levelName(LogLevel ilevel) noexcept;
+
+  void write(LogLevel ilevel, std::string_view message) const noexcept;
+
+  void writef(LogLevel ilevel, const char *iformat, ...) const noexcept
+    __attribute__((format(printf, 3, 4)));
+
   static Logger *s_instance;
   static std::unique_ptr<AbstractTimer> timer;
   static LogLevel logLevel;
   static FILE *logfile;
+  // Tasks count themselves in asyncWriterUsers while they use asyncWriter, so the writer is only
+  // deleted once no task can still be pushing to it
+  static std::atomic<AsyncLogWriter *> asyncWriter;
+  static std::atomic_size_t asyncWriterUsers;
 };
 } // namespace okapi
@@ -0,0 +1,124 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/coreProsAPI.hpp"
+#include "okapi/api/units/QTime.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace okapi {
+class LoopTimingStats {
+  public:
+  /**
+   * The number of 1 ms wide buckets in the jitter histogram. Jitter of this many milliseconds or
+   * more goes into the last bucket.
+   */
+  static constexpr std::size_t histogramBuckets = 32;
+
+  /**
+   * Collects how late a periodic loop runs. Each time the loop's rate wakes up, it records how long
+   * after the scheduled time it woke up (the jitter). Each time the loop is still running when it
+   * should have woken up again, it records a deadline miss.
+   *
+   * Jitter is kept in a fixed-size histogram, so recording never allocates and percentiles are
+   * only accurate to the nearest millisecond. Every method is safe to call from any task.
+   *
+   * @param ionMiss Called with how late the loop was each time it misses a deadline. Runs in the
+   * loop's task, so it should return quickly.
+   */
+  explicit LoopTimingStats(std::function<void(QTime)> ionMiss = nullptr);
+
+  /**
+   * Makes stats which log a warning each time the loop misses a deadline.
+   *
+   * @param iname The name of the loop to put in the warning.
+   * @return The stats.
+   */
+  static std::shared_ptr<LoopTimingStats> withMissWarning(const std::string &iname);
+
+  /**
+   * Records that the loop woke up.
+   *
+   * @param ilateness How long after the scheduled time the loop woke up.
+   */
+  void recordWakeup(QTime ilateness);
+
+  /**
+   * Records that the loop missed a deadline and calls the miss callback.
+   *
+   * @param ilateness How long after the deadline the loop finished.
+   */
+  void recordMiss(QTime ilateness);
+
+  /**
+   * Sets the function called each time the loop misses a deadline.
+   *
+   * @param ionMiss Called with how late the loop was. Runs in the loop's task.
+   */
+  void setMissCallback(std::function<void(QTime)> ionMiss);
+
+  /**
+   * Forgets everything recorded so far. Keeps the miss callback.
+   */
+  void reset();
+
+  /**
+   * @return The number of wakeups recorded.
+   */
+  std::uint32_t getWakeups() const;
+
+  /**
+   * @return The number of deadline misses recorded.
+   */
+  std::uint32_t getMisses() const;
+
+  /**
+   * @return The smallest jitter recorded, or 0 if nothing was recorded.
+   */
+  QTime getMinJitter() const;
+
+  /**
+   * @return The mean jitter, or 0 if nothing was recorded.
+   */
+  QTime getMeanJitter() const;
+
+  /**
+   * @return The largest jitter recorded, or 0 if nothing was recorded.
+   */
+  QTime getMaxJitter() const;
+
+  /**
+   * Returns the jitter which the given fraction of wakeups were at or under, rounded up to the
+   * next millisecond. Never more than the largest jitter recorded.
+   *
+   * @param ifraction The fraction of wakeups, between 0 and 1.
+   * @return The jitter, or 0 if nothing was recorded.
+   */
+  QTime getJitterPercentile(double ifraction) const;
+
+  /**
+   * @return The jitter 99% of wakeups were at or under.
+   */
+  QTime getP99Jitter() const;
+
+  protected:
+  mutable CrossplatformMutex mutex;
+  std::function<void(QTime)> onMiss;
+  std::array<std::uint32_t, histogramBuckets> histogram{};
+  std::uint32_t wakeups{0};
+  std::uint32_t misses{0};
+  double minJitter{0}; // ms
+  double maxJitter{0}; // ms
+  double jitterSum{0}; // ms
+};
+} // namespace okapi
@@ -0,0 +1,132 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace okapi {
+/**
+ * A fixed size queue which any number of threads can push to while one thread pops from, without
+ * locking. Each slot has a sequence number which says whether it is ready to be written or read,
+ * so producers only contend on claiming a slot and never wait for each other to finish writing.
+ *
+ * @tparam T The type of the elements.
+ * @tparam N The maximum number of elements. Must be a power of two.
+ */
+template <typename T, std::size_t N> class MpscRingBuffer {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscRingBuffer: N must be a power of two");
+
+  public:
+  MpscRingBuffer() {
+    for (std::size_t i = 0; i < N; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscRingBuffer(const MpscRingBuffer &) = delete;
+  MpscRingBuffer &operator=(const MpscRingBuffer &) = delete;
+
+  /**
+   * Claims a slot at the back of the queue and fills it in place, so large elements are not
+   * copied. Safe to call from any thread.
+   *
+   * @param ifill Called with the slot to fill. The element is not visible to the consumer until
+   * ifill returns.
+   * @return Whether there was room for the element.
+   */
+  template <typename F> bool pushWith(F &&ifill) {
+    std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &cells[pos & mask];
+      const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // The consumer has not freed this slot yet, so the queue is full
+        return false;
+      } else {
+        // Another producer claimed this slot first
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    ifill(cell->data);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Adds an element to the back of the queue. Safe to call from any thread.
+   *
+   * @param ivalue The element.
+   * @return Whether there was room for the element.
+   */
+  bool push(const T &ivalue) {
+    return pushWith([&](T &oslot) { oslot = ivalue; });
+  }
+
+  /**
+   * Removes the element at the front of the queue. Only call this from the consuming thread. An
+   * element a producer is still filling in is not popped until it is done, even if elements behind
+   * it are done.
+   *
+   * @param ovalue Where to put the element.
+   * @return Whether there was an element.
+   */
+  bool pop(T &ovalue) {
+    const std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Cell &cell = cells[pos & mask];
+    if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+      return false;
+    }
+
+    ovalue = cell.data;
+    cell.sequence.store(pos + N, std::memory_order_release);
+    dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /**
+   * Returns the number of slots which have been claimed and not popped. The other threads may
+   * change it at any time.
+   *
+   * @return The number of elements in the queue.
+   */
+  std::size_t size() const {
+    return enqueuePos.load(std::memory_order_acquire) - dequeuePos.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Returns the maximum number of elements in the queue.
+   *
+   * @return The maximum number of elements in the queue.
+   */
+  static constexpr std::size_t capacity() {
+    return N;
+  }
+
+  protected:
+  static constexpr std::size_t mask = N - 1;
+
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T data;
+  };
+
+  std::array<Cell, N> cells{};
+  std::atomic<std::size_t> enqueuePos{0};
+  std::atomic<std::size_t> dequeuePos{0};
+};
+} // namespace okapi
@@ -0,0 +1,46 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace okapi {
+/**
+ * Returns the number of threads which can run at the same time. This is always one on the brain.
+ *
+ * @return The number of threads which can run at the same time.
+ */
+std::size_t defaultThreadCount();
+
+/**
+ * Calls a function for every index in [0, icount) using up to ithreads threads, one of which is the
+ * calling thread, and returns once every call has returned. Indices are handed out in order but
+ * may finish in any order, so the function must only write results for its own index. The
+ * function must not throw.
+ *
+ * The brain has a single core, so on the brain every call runs on the calling thread.
+ *
+ * @param icount The number of indices.
+ * @param ithreads The maximum number of threads to use.
+ * @param ibody The function to call with each index.
+ */
+void parallelFor(std::size_t icount,
+                 std::size_t ithreads,
+                 const std::function<void(std::size_t)> &ibody);
+
+/**
+ * Runs parallelFor() for pathfinder (see pf_parallel_for in pathfinder's trajectory.h).
+ *
+ * @param icount The number of indices.
+ * @param ibody The function to call with each index.
+ * @param icontext The first argument to ibody.
+ * @param iuser A pointer to a std::size_t holding the maximum number of threads to use.
+ */
+void pathfinderParallelFor(int icount, void (*ibody)(void *, int), void *icontext, void *iuser);
+} // namespace okapi
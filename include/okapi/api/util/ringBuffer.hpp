@@ -0,0 +1,85 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace okapi {
+/**
+ * A fixed size queue which one thread can push to while another thread pops from, without
+ * locking. Only one thread may push and only one thread may pop.
+ *
+ * @tparam T The type of the elements.
+ * @tparam N The maximum number of elements.
+ */
+template <typename T, std::size_t N> class RingBuffer {
+  public:
+  /**
+   * Adds an element to the back of the queue. Only call this from the producing thread.
+   *
+   * @param ivalue The element.
+   * @return Whether there was room for the element.
+   */
+  bool push(const T &ivalue) {
+    const std::size_t write = writeIndex.load(std::memory_order_relaxed);
+    const std::size_t next = (write + 1) % buffer.size();
+    if (next == readIndex.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    buffer[write] = ivalue;
+    writeIndex.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the element at the front of the queue. Only call this from the consuming thread.
+   *
+   * @param ovalue Where to put the element.
+   * @return Whether there was an element.
+   */
+  bool pop(T &ovalue) {
+    const std::size_t read = readIndex.load(std::memory_order_relaxed);
+    if (read == writeIndex.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    ovalue = buffer[read];
+    readIndex.store((read + 1) % buffer.size(), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Returns the number of elements in the queue. The other thread may change it at any time.
+   *
+   * @return The number of elements in the queue.
+   */
+  std::size_t size() const {
+    const std::size_t read = readIndex.load(std::memory_order_acquire);
+    const std::size_t write = writeIndex.load(std::memory_order_acquire);
+    return (write + buffer.size() - read) % buffer.size();
+  }
+
+  /**
+   * Returns the maximum number of elements in the queue.
+   *
+   * @return The maximum number of elements in the queue.
+   */
+  static constexpr std::size_t capacity() {
+    return N;
+  }
+
+  protected:
+  // One slot is always empty so a full queue can be told apart from an empty one
+  std::array<T, N + 1> buffer{};
+  std::atomic_size_t readIndex{0};
+  std::atomic_size_t writeIndex{0};
+};
+} // namespace okapi
@@ -0,0 +1,176 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/coreProsAPI.hpp"
+#include "okapi/api/units/QTime.hpp"
+#include "okapi/api/util/abstractRate.hpp"
+#include "okapi/api/util/abstractTimer.hpp"
+#include "okapi/api/util/timeUtil.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+
+namespace okapi {
+class VirtualClock : public std::enable_shared_from_this<VirtualClock> {
+  public:
+  /**
+   * A simulated clock for running controllers faster than real time. Timers made from this clock
+   * read the simulated time and rates made from it wait for simulated time instead of real time.
+   *
+   * Threads take part in the simulation by joining the clock. A rate made from this clock joins
+   * the thread which first waits on it and leaves when the rate is destroyed; threads can also
+   * join and leave directly with join() and leave(). Only one joined thread runs at a time: once
+   * every one of them is waiting, the clock jumps to the earliest time one of them should wake up
+   * at and wakes only that thread. Threads which wake up at the same time run in the order they
+   * started waiting. The simulation does not depend on how long each step takes to run, so it
+   * gives the same results on every run.
+   *
+   * Time does not start until iparticipants threads have joined, so threads which are started one
+   * after another all start at the same time. Time does not pass while a joined thread is running,
+   * so a joined thread must not block on anything other than the clock (for example, joining
+   * another thread which waits on the clock); destroy its rates or call leave() first.
+   *
+   * Time starts at 1 ms because timers treat a mark placed at 0 ms as no mark.
+   *
+   * @param iparticipants The number of threads to wait for before starting time.
+   */
+  explicit VirtualClock(std::size_t iparticipants = 1);
+
+  /**
+   * Returns the simulated time.
+   *
+   * @return The simulated time.
+   */
+  QTime millis() const;
+
+  /**
+   * Returns a timer which reads the simulated time.
+   *
+   * @return The timer.
+   */
+  std::unique_ptr<AbstractTimer> createTimer();
+
+  /**
+   * Returns a rate which waits for simulated time.
+   *
+   * @return The rate.
+   */
+  std::unique_ptr<AbstractRate> createRate();
+
+  /**
+   * Returns a TimeUtil whose timers, rates, and SettledUtils all use the simulated time. See
+   * SettledUtil for the params.
+   *
+   * @return The TimeUtil.
+   */
+  TimeUtil createTimeUtil(double iatTargetError = 50,
+                          double iatTargetDerivative = 5,
+                          QTime iatTargetTime = 250_ms);
+
+  /**
+   * Adds the calling thread to the simulation. Time will not pass while it runs until it waits on
+   * the clock. A thread which joins several times must leave as many times.
+   *
+   * @return The id of the calling thread, to pass to leave().
+   */
+  CROSSPLATFORM_THREAD_ID_T join();
+
+  /**
+   * Removes a thread from the simulation. This does not have to be called from that thread.
+   *
+   * @param ithread The id join() returned.
+   */
+  void leave(CROSSPLATFORM_THREAD_ID_T ithread);
+
+  /**
+   * Blocks the calling thread until the simulated time reaches iwakeup. Rates made from this clock
+   * call this; use a rate instead of calling this directly. A thread which has not joined the
+   * clock joins it until it wakes up.
+   *
+   * @param iwakeup The time to wake up at, in ms.
+   */
+  void sleepUntil(std::uint32_t iwakeup);
+
+  protected:
+  struct Sleeper {
+    std::uint32_t wakeup;
+    std::uint64_t order;
+  };
+
+  mutable CrossplatformMutex mutex;
+  CrossplatformConditionVariable turnChanged;
+  std::uint32_t now{1};
+  std::size_t participants;
+  bool started{false};
+  std::map<CROSSPLATFORM_THREAD_ID_T, std::size_t> joined{};
+  std::map<CROSSPLATFORM_THREAD_ID_T, Sleeper> sleepers{};
+  std::set<CROSSPLATFORM_THREAD_ID_T> woken{};
+  std::uint64_t sleeps{0};
+
+  /**
+   * Adds ithread to the simulation. The mutex must be held.
+   */
+  void joinLocked(CROSSPLATFORM_THREAD_ID_T ithread);
+
+  /**
+   * Removes ithread from the simulation. The mutex must be held.
+   */
+  void leaveLocked(CROSSPLATFORM_THREAD_ID_T ithread);
+
+  /**
+   * Wakes the sleeper which should wake up first, if every joined thread is sleeping. The mutex
+   * must be held.
+   */
+  void schedule();
+};
+
+class VirtualTimer : public AbstractTimer {
+  public:
+  /**
+   * A timer which reads the simulated time of a VirtualClock.
+   *
+   * @param iclock The clock.
+   */
+  explicit VirtualTimer(std::shared_ptr<VirtualClock> iclock);
+
+  QTime millis() const override;
+
+  protected:
+  std::shared_ptr<VirtualClock> clock;
+};
+
+class VirtualRate : public AbstractRate {
+  public:
+  /**
+   * A rate which waits for the simulated time of a VirtualClock. Waits are measured from when the
+   * previous one was supposed to end, like Rate. The first wait joins the calling thread to the
+   * clock, and destroying the rate makes that thread leave.
+   *
+   * @param iclock The clock.
+   */
+  explicit VirtualRate(std::shared_ptr<VirtualClock> iclock);
+
+  ~VirtualRate() override;
+
+  void delay(QFrequency ihz) override;
+
+  void delay(int ihz) override;
+
+  void delayUntil(QTime itime) override;
+
+  void delayUntil(uint32_t ims) override;
+
+  protected:
+  std::shared_ptr<VirtualClock> clock;
+  std::uint32_t lastTime{0};
+  bool hasJoined{false};
+  CROSSPLATFORM_THREAD_ID_T participant{};
+};
+} // namespace okapi
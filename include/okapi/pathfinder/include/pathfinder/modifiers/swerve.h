@@ -10,5 +10,11 @@ CAPI typedef enum {
 
 CAPI void pathfinder_modify_swerve(Segment *original, int length, Segment *front_left, Segment *front_right,
         Segment *back_left, Segment *back_right, double wheelbase_width, double wheelbase_depth, SWERVE_MODE mode);
+CAPI void pathfinder_modify_swerve_segment(Segment seg, int i, Segment *front_left, Segment *front_right,
+        Segment *back_left, Segment *back_right, double wheelbase_width, double wheelbase_depth, SWERVE_MODE mode);
+
+// Generates and modifies in one pass, without a buffer for the center trajectory
+CAPI int pathfinder_generate_swerve(TrajectoryCandidate *c, Segment *front_left, Segment *front_right,
+        Segment *back_left, Segment *back_right, double wheelbase_width, double wheelbase_depth, SWERVE_MODE mode);
 
 #endif
\ No newline at end of file
@@ -5,5 +5,9 @@
 #include "okapi/pathfinder/include/pathfinder/structs.h"
 
 CAPI void pathfinder_modify_tank(Segment *original, int length, Segment *left, Segment *right, double wheelbase_width);
+CAPI void pathfinder_modify_tank_segment(Segment seg, int i, Segment *left, Segment *right, double wheelbase_width);
+
+// Generates and modifies in one pass, without a buffer for the center trajectory
+CAPI int pathfinder_generate_tank(TrajectoryCandidate *c, Segment *left, Segment *right, double wheelbase_width);
 
 #endif
\ No newline at end of file
@@ -8,6 +8,10 @@
 #define PATHFINDER_SAMPLES_LOW  (int)PATHFINDER_SAMPLES_FAST*10
 #define PATHFINDER_SAMPLES_HIGH (int)PATHFINDER_SAMPLES_LOW*10
 
+// Negative sample counts select adaptive Gauss-Legendre quadrature to a tolerance of 10^-digits
+#define PATHFINDER_SAMPLES_ADAPTIVE(digits) (-(int)(digits))
+#define PATHFINDER_SAMPLES_GAUSS PATHFINDER_SAMPLES_ADAPTIVE(9)
+
 CAPI Coord pf_spline_coords(Spline s, double percentage);
 CAPI double pf_spline_deriv(Spline s, double percentage);
 CAPI double pf_spline_deriv_2(double a, double b, double c, double d, double e, double k, double p);
@@ -16,4 +20,17 @@ CAPI double pf_spline_angle(Spline s, double percentage);
 CAPI double pf_spline_distance(Spline *s, int sample_count);
 CAPI double pf_spline_progress_for_distance(Spline s, double distance, int sample_count);
 
+// Table variants: the table holds pf_spline_table_length(sample_count) cumulative arc lengths for
+// one spline, taken at up to PATHFINDER_TABLE_CHECKPOINTS + 1 evenly spaced samples
+#define PATHFINDER_TABLE_CHECKPOINTS PATHFINDER_SAMPLES_FAST
+CAPI int pf_spline_table_length(int sample_count);
+CAPI double pf_spline_distance_table(Spline *s, int sample_count, double *table);
+CAPI double pf_spline_progress_for_distance_table(Spline s, const double *table, double distance, int sample_count, int *cursor);
+
+// Adaptive quadrature variants: tolerances are absolute arc lengths
+CAPI double pf_spline_tolerance(int sample_count);
+CAPI double pf_spline_arc_length_gauss(Spline *s, double from, double to, double tolerance);
+CAPI double pf_spline_distance_gauss(Spline *s, double tolerance);
+CAPI double pf_spline_progress_for_distance_gauss(Spline s, double distance, double tolerance, double *last_t, double *last_distance);
+
 #endif
\ No newline at end of file
@@ -33,6 +33,7 @@ CAPI typedef struct {
 CAPI typedef struct {
     Spline *saptr;
     double *laptr;
+    double *taptr;
     double totalLength;
     int length;
     int path_length;
@@ -40,4 +41,18 @@ CAPI typedef struct {
     TrajectoryConfig config;
 } TrajectoryCandidate;
 
+CAPI typedef struct {
+    int filter_1_l, filter_2_l, index;
+    double dt, v, impulse, f1_last, f2_sum;
+    double *f2_ring;
+    Segment last;
+} SecondOrderFilter;
+
+CAPI typedef struct {
+    TrajectoryCandidate *candidate;
+    SecondOrderFilter filter;
+    int index, spline_i, table_cursor;
+    double spline_pos_initial, gauss_t, gauss_distance, tolerance;
+} TrajectoryGenerator;
+
 #endif
\ No newline at end of file
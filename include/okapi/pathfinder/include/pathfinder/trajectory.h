@@ -6,12 +6,38 @@
 
 CAPI int pathfinder_prepare(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), int sample_count, double dt,
         double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand);
+
+// Calls body(context, i) for every i in [0, count) and returns once every call has returned. The
+// calls may run in parallel. user is passed through from pathfinder_prepare_parallel.
+typedef void (*pf_parallel_for)(int count, void (*body)(void *context, int i), void *context, void *user);
+
+// Same as pathfinder_prepare, but fits and measures the splines through parallel_for. Each spline is
+// measured on its own and the lengths are summed in order afterwards, so the candidate is identical
+// to the one from pathfinder_prepare. parallel_for may be NULL to measure them one after another.
+CAPI int pathfinder_prepare_parallel(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), int sample_count, double dt,
+        double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        pf_parallel_for parallel_for, void *user);
+
+// Releases the buffers pathfinder_prepare allocated for a candidate and sets them to NULL, so it is
+// safe to call more than once. pathfinder_prepare leaves nothing allocated if it fails.
+CAPI void pathfinder_candidate_free(TrajectoryCandidate *c);
+
 CAPI int pathfinder_generate(TrajectoryCandidate *c, Segment *segments);
 
+// Produces the segments of pathfinder_generate one at a time. The generator takes ownership of the
+// candidate's buffers; pathfinder_generator_free releases them with pathfinder_candidate_free.
+CAPI int pathfinder_generator_init(TrajectoryCandidate *c, TrajectoryGenerator *g);
+CAPI int pathfinder_generator_next(TrajectoryGenerator *g, Segment *segment);
+CAPI void pathfinder_generator_free(TrajectoryGenerator *g);
+
 CAPI void pf_trajectory_copy(Segment *src, Segment *dest, int length);
 
 CAPI TrajectoryInfo pf_trajectory_prepare(TrajectoryConfig c);
 CAPI int pf_trajectory_create(TrajectoryInfo info, TrajectoryConfig c, Segment *seg);
+CAPI int pf_trajectory_filter_init(SecondOrderFilter *f, int filter_1_l, int filter_2_l,
+        double dt, double u, double v, double impulse);
+CAPI void pf_trajectory_filter_next(SecondOrderFilter *f, Segment *seg);
+CAPI void pf_trajectory_filter_free(SecondOrderFilter *f);
 CAPI int pf_trajectory_fromSecondOrderFilter(int filter_1_l, int filter_2_l, 
         double dt, double u, double v, double impulse, int len, Segment *t);
 
@@ -207,6 +207,9 @@ class MockRate : public AbstractRate {
   void delayUntil(QTime itime) override;
 
   void delayUntil(uint32_t ims) override;
+
+  protected:
+  static std::uint32_t now();
 };
 
 std::unique_ptr<SettledUtil> createSettledUtilPtr(double iatTargetError = 50,
@@ -223,7 +226,8 @@ TimeUtil createTimeUtil(const Supplier<std::unique_ptr<SettledUtil>> &isettledUt
 
 class SimulatedSystem : public ControllerInput<double>, public ControllerOutput<double> {
   public:
-  explicit SimulatedSystem(FlywheelSimulator &simulator);
+  explicit SimulatedSystem(FlywheelSimulator &simulator,
+                           std::unique_ptr<AbstractRate> irate = std::make_unique<MockRate>());
 
   virtual ~SimulatedSystem();
 
@@ -240,7 +244,7 @@ class SimulatedSystem : public ControllerInput<double>, public ControllerOutput<
   void join();
 
   FlywheelSimulator &simulator;
-  MockRate rate{};
+  std::unique_ptr<AbstractRate> rate;
   std::atomic_bool dtorCalled{false};
   std::thread thread;
 };
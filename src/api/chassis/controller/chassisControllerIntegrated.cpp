@@ -46,8 +46,7 @@ void ChassisControllerIntegrated::moveDistance(const double itarget) {
 }
 
 void ChassisControllerIntegrated::moveDistanceAsync(const QLength itarget) {
-  logger->info("ChassisControllerIntegrated: moving " + std::to_string(itarget.convert(meter)) +
-               " meters");
+  logger->info("ChassisControllerIntegrated: moving %f meters", itarget.convert(meter));
 
   leftController->reset();
   rightController->reset();
@@ -56,8 +55,7 @@ void ChassisControllerIntegrated::moveDistanceAsync(const QLength itarget) {
 
   const double newTarget = itarget.convert(meter) * scales.straight * gearsetRatioPair.ratio;
 
-  logger->info("ChassisControllerIntegrated: moving " + std::to_string(newTarget) +
-               " motor degrees");
+  logger->info("ChassisControllerIntegrated: moving %f motor degrees", newTarget);
 
   const auto enc = model->getSensorVals();
   leftController->setTarget(newTarget + enc[0]);
@@ -80,8 +78,7 @@ void ChassisControllerIntegrated::turnAngle(const double idegTarget) {
 }
 
 void ChassisControllerIntegrated::turnAngleAsync(const QAngle idegTarget) {
-  logger->info("ChassisControllerIntegrated: turning " +
-               std::to_string(idegTarget.convert(degree)) + " degrees");
+  logger->info("ChassisControllerIntegrated: turning %f degrees", idegTarget.convert(degree));
 
   leftController->reset();
   rightController->reset();
@@ -91,8 +88,7 @@ void ChassisControllerIntegrated::turnAngleAsync(const QAngle idegTarget) {
   const double newTarget =
     idegTarget.convert(degree) * scales.turn * gearsetRatioPair.ratio * boolToSign(normalTurns);
 
-  logger->info("ChassisControllerIntegrated: turning " + std::to_string(newTarget) +
-               " motor degrees");
+  logger->info("ChassisControllerIntegrated: turning %f motor degrees", newTarget);
 
   const auto enc = model->getSensorVals();
   leftController->setTarget(newTarget + enc[0]);
@@ -48,56 +48,74 @@ ChassisControllerPID::ChassisControllerPID(ChassisControllerPID &&other) noexcep
     doneLooping(other.doneLooping.load(std::memory_order_acquire)),
     newMovement(other.newMovement.load(std::memory_order_acquire)),
     dtorCalled(other.dtorCalled.load(std::memory_order_acquire)),
+    movementSettled(other.movementSettled.load(std::memory_order_acquire)),
     mode(other.mode),
+    pastMode(other.pastMode),
+    encStartVals(other.encStartVals),
     task(other.task) {
   other.task = nullptr;
+
+  // The executor calls the old object, so register this one in its place
+  if (other.executor) {
+    runOn(other.executor);
+    other.executor->remove(other.executorId);
+    other.executor = nullptr;
+  }
 }
 
 ChassisControllerPID::~ChassisControllerPID() {
   dtorCalled.store(true, std::memory_order_release);
+  if (executor) {
+    executor->remove(executorId);
+  }
   delete task;
 }
 
 void ChassisControllerPID::loop() {
-  auto encStartVals = model->getSensorVals();
+  while (!dtorCalled.load(std::memory_order_acquire)) {
+    step();
+    rate->delayUntil(loopPeriod);
+  }
+}
+
+void ChassisControllerPID::step() {
+  /**
+   * doneLooping is set to false by moveDistanceAsync and turnAngleAsync and then set to true by
+   * waitUntilSettled
+   */
+  if (doneLooping.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  if (mode != pastMode || newMovement.load(std::memory_order_acquire)) {
+    encStartVals = model->getSensorVals();
+    newMovement.store(false, std::memory_order_release);
+  }
+
   std::valarray<std::int32_t> encVals;
   double distanceElapsed = 0, angleChange = 0;
-  modeType pastMode = none;
 
-  while (!dtorCalled.load(std::memory_order_acquire)) {
-    /**
-     * doneLooping is set to false by moveDistanceAsync and turnAngleAsync and then set to true by
-     * waitUntilSettled
-     */
-    if (!doneLooping.load(std::memory_order_acquire)) {
-      if (mode != pastMode || newMovement.load(std::memory_order_acquire)) {
-        encStartVals = model->getSensorVals();
-        newMovement.store(false, std::memory_order_release);
-      }
-
-      switch (mode) {
-      case distance:
-        encVals = model->getSensorVals() - encStartVals;
-        distanceElapsed = static_cast<double>((encVals[0] + encVals[1])) / 2.0;
-        angleChange = static_cast<double>(encVals[0] - encVals[1]);
-        model->driveVector(distancePid->step(distanceElapsed), anglePid->step(angleChange));
-        break;
-
-      case angle:
-        encVals = model->getSensorVals() - encStartVals;
-        angleChange = static_cast<double>(encVals[0] - encVals[1]);
-        model->rotate(turnPid->step(angleChange));
-        break;
-
-      default:
-        break;
-      }
-
-      pastMode = mode;
-    }
-
-    rate->delayUntil(10_ms);
+  switch (mode) {
+  case distance:
+    encVals = model->getSensorVals() - encStartVals;
+    distanceElapsed = static_cast<double>((encVals[0] + encVals[1])) / 2.0;
+    angleChange = static_cast<double>(encVals[0] - encVals[1]);
+    model->driveVector(distancePid->step(distanceElapsed), anglePid->step(angleChange));
+    updateSettled(distancePid->isSettled() && anglePid->isSettled());
+    break;
+
+  case angle:
+    encVals = model->getSensorVals() - encStartVals;
+    angleChange = static_cast<double>(encVals[0] - encVals[1]);
+    model->rotate(turnPid->step(angleChange));
+    updateSettled(turnPid->isSettled());
+    break;
+
+  default:
+    break;
   }
+
+  pastMode = mode;
 }
 
 void ChassisControllerPID::trampoline(void *context) {
@@ -107,9 +125,9 @@ void ChassisControllerPID::trampoline(void *context) {
 }
 
 void ChassisControllerPID::moveDistanceAsync(const QLength itarget) {
-  logger->info("ChassisControllerPID: moving " + std::to_string(itarget.convert(meter)) +
-               " meters");
+  logger->info("ChassisControllerPID: moving %f meters", itarget.convert(meter));
 
+  movementSettled.store(false, std::memory_order_release);
   distancePid->reset();
   anglePid->reset();
   distancePid->flipDisable(false);
@@ -119,13 +137,16 @@ void ChassisControllerPID::moveDistanceAsync(const QLength itarget) {
 
   const double newTarget = itarget.convert(meter) * scales.straight * gearsetRatioPair.ratio;
 
-  logger->info("ChassisControllerPID: moving " + std::to_string(newTarget) + " motor degrees");
+  logger->info("ChassisControllerPID: moving %f motor degrees", newTarget);
 
   distancePid->setTarget(newTarget);
   anglePid->setTarget(0);
 
   doneLooping.store(false, std::memory_order_release);
   newMovement.store(true, std::memory_order_release);
+
+  // Wake a task waiting in the other mode so it sees the mode changed
+  notifySettled();
 }
 
 void ChassisControllerPID::moveDistanceAsync(const double itarget) {
@@ -144,9 +165,9 @@ void ChassisControllerPID::moveDistance(const double itarget) {
 }
 
 void ChassisControllerPID::turnAngleAsync(const QAngle idegTarget) {
-  logger->info("ChassisControllerPID: turning " + std::to_string(idegTarget.convert(degree)) +
-               " degrees");
+  logger->info("ChassisControllerPID: turning %f degrees", idegTarget.convert(degree));
 
+  movementSettled.store(false, std::memory_order_release);
   turnPid->reset();
   turnPid->flipDisable(false);
   distancePid->flipDisable(true);
@@ -156,12 +177,15 @@ void ChassisControllerPID::turnAngleAsync(const QAngle idegTarget) {
   const double newTarget =
     idegTarget.convert(degree) * scales.turn * gearsetRatioPair.ratio * boolToSign(normalTurns);
 
-  logger->info("ChassisControllerPID: turning " + std::to_string(newTarget) + " motor degrees");
+  logger->info("ChassisControllerPID: turning %f motor degrees", newTarget);
 
   turnPid->setTarget(newTarget);
 
   doneLooping.store(false, std::memory_order_release);
   newMovement.store(true, std::memory_order_release);
+
+  // Wake a task waiting in the other mode so it sees the mode changed
+  notifySettled();
 }
 
 void ChassisControllerPID::turnAngleAsync(const double idegTarget) {
@@ -213,14 +237,18 @@ void ChassisControllerPID::waitUntilSettled() {
 bool ChassisControllerPID::waitForDistanceSettled() {
   logger->info("ChassisControllerPID: Waiting to settle in distance mode");
 
-  while (!(distancePid->isSettled() && anglePid->isSettled())) {
-    if (mode == angle) {
-      // False will cause the loop to re-enter the switch
-      logger->warn("ChassisControllerPID: Mode changed to angle while waiting in distance!");
-      return false;
-    }
-
-    rate->delayUntil(10_ms);
+  // loop() wakes this task up once the PID controllers settle
+  bool settled = false;
+  std::unique_lock<CrossplatformMutex> lock(settledMutex);
+  settledCondition.wait(lock, [&]() {
+    settled = mode == distance && movementSettled.load(std::memory_order_acquire);
+    return settled || mode == angle;
+  });
+
+  if (!settled) {
+    // False will cause the loop to re-enter the switch
+    logger->warn("ChassisControllerPID: Mode changed to angle while waiting in distance!");
+    return false;
   }
 
   // True will cause the loop to exit
@@ -235,20 +263,36 @@ bool ChassisControllerPID::waitForDistanceSettled() {
 bool ChassisControllerPID::waitForAngleSettled() {
   logger->info("ChassisControllerPID: Waiting to settle in angle mode");
 
-  while (!turnPid->isSettled()) {
-    if (mode == distance) {
-      // False will cause the loop to re-enter the switch
-      logger->warn("ChassisControllerPID: Mode changed to distance while waiting in angle!");
-      return false;
-    }
-
-    rate->delayUntil(10_ms);
+  // loop() wakes this task up once the PID controller settles
+  bool settled = false;
+  std::unique_lock<CrossplatformMutex> lock(settledMutex);
+  settledCondition.wait(lock, [&]() {
+    settled = mode == angle && movementSettled.load(std::memory_order_acquire);
+    return settled || mode == distance;
+  });
+
+  if (!settled) {
+    // False will cause the loop to re-enter the switch
+    logger->warn("ChassisControllerPID: Mode changed to distance while waiting in angle!");
+    return false;
   }
 
   // True will cause the loop to exit
   return true;
 }
 
+void ChassisControllerPID::updateSettled(const bool isettled) {
+  movementSettled.store(isettled, std::memory_order_release);
+  if (isettled && settledCondition.hasWaiters()) {
+    notifySettled();
+  }
+}
+
+void ChassisControllerPID::notifySettled() {
+  std::lock_guard<CrossplatformMutex> lock(settledMutex);
+  settledCondition.notifyAll();
+}
+
 void ChassisControllerPID::stopAfterSettled() {
   distancePid->flipDisable(true);
   anglePid->flipDisable(true);
@@ -267,6 +311,13 @@ void ChassisControllerPID::startThread() {
   }
 }
 
+void ChassisControllerPID::runOn(const std::shared_ptr<ControlLoopExecutor> &iexecutor) {
+  if (!task && !executor) {
+    executorId = iexecutor->add(loopPeriod, [this]() { step(); });
+    executor = iexecutor;
+  }
+}
+
 ChassisScales ChassisControllerPID::getChassisScales() const {
   return scales;
 }
@@ -6,6 +6,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include "okapi/api/control/async/asyncLinearMotionProfileController.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <numeric>
 
 namespace okapi {
@@ -14,13 +17,18 @@ AsyncLinearMotionProfileController::AsyncLinearMotionProfileController(
   const double imaxVel,
   const double imaxAccel,
   const double imaxJerk,
-  const std::shared_ptr<ControllerOutput<double>> &ioutput)
+  const std::shared_ptr<ControllerOutput<double>> &ioutput,
+  const CompactTrajectory::Format &iformat,
+  const QTime ioutputPeriod)
   : logger(Logger::instance()),
     maxVel(imaxVel),
     maxAccel(imaxAccel),
     maxJerk(imaxJerk),
     output(ioutput),
-    timeUtil(itimeUtil) {
+    format(iformat),
+    outputPeriod(ioutputPeriod),
+    timeUtil(itimeUtil),
+    timingStats(LoopTimingStats::withMissWarning("AsyncLinearMotionProfileController")) {
 }
 
 AsyncLinearMotionProfileController::AsyncLinearMotionProfileController(
@@ -31,50 +39,139 @@ AsyncLinearMotionProfileController::AsyncLinearMotionProfileController(
     maxAccel(other.maxAccel),
     maxJerk(other.maxJerk),
     output(std::move(other.output)),
+    format(other.format),
+    outputPeriod(other.outputPeriod),
     timeUtil(std::move(other.timeUtil)),
-    currentPath(std::move(other.currentPath)),
+    timingStats(std::move(other.timingStats)),
+    cache(std::move(other.cache)),
+    currentPath(other.currentPath.load(std::memory_order_acquire)),
     isRunning(other.isRunning.load(std::memory_order_acquire)),
+    blending(other.blending.load(std::memory_order_acquire)),
+    sampleCount(other.sampleCount.load(std::memory_order_acquire)),
     disabled(other.disabled.load(std::memory_order_acquire)),
     dtorCalled(other.dtorCalled.load(std::memory_order_acquire)),
     task(other.task) {
+  std::lock_guard<CrossplatformMutex> lock(other.targetMutex);
+  missingPathId = std::move(other.missingPathId);
 }
 
 AsyncLinearMotionProfileController::~AsyncLinearMotionProfileController() {
   dtorCalled.store(true, std::memory_order_release);
+  delete task;
+}
 
-  for (auto path : paths) {
-    free(path.second.segment);
+PathHandle
+AsyncLinearMotionProfileController::generatePath(std::initializer_list<double> iwaypoints,
+                                                 const std::string &ipathId) {
+  if (iwaypoints.size() == 0) {
+    // No point in generating a path
+    logger->warn(
+      "AsyncLinearMotionProfileController: Not generating a path because no waypoints were given.");
+    return PathHandle();
   }
 
-  delete task;
+  auto trajectory = generateTrajectory(toWaypoints(iwaypoints), defaultThreadCount());
+  const PathHandle handle = paths.intern(ipathId);
+  storePath(handle, std::move(trajectory));
+  return handle;
 }
 
-void AsyncLinearMotionProfileController::generatePath(std::initializer_list<double> iwaypoints,
-                                                      const std::string &ipathId) {
+PathHandle
+AsyncLinearMotionProfileController::generatePath(std::initializer_list<double> iwaypoints) {
   if (iwaypoints.size() == 0) {
     // No point in generating a path
     logger->warn(
       "AsyncLinearMotionProfileController: Not generating a path because no waypoints were given.");
-    return;
+    return PathHandle();
+  }
+
+  auto trajectory = generateTrajectory(toWaypoints(iwaypoints), defaultThreadCount());
+  const PathHandle handle = paths.create();
+  storePath(handle, std::move(trajectory));
+  return handle;
+}
+
+void AsyncLinearMotionProfileController::generatePaths(
+  std::initializer_list<std::pair<std::string, std::initializer_list<double>>> ipaths,
+  const std::size_t ithreads) {
+  std::vector<std::string> ids;
+  std::vector<std::vector<Waypoint>> waypoints;
+  for (const auto &path : ipaths) {
+    if (path.second.size() == 0) {
+      // No point in generating a path
+      logger->warn(
+        "AsyncLinearMotionProfileController: Not generating path %s because no waypoints were "
+        "given.",
+        path.first);
+      continue;
+    }
+
+    ids.push_back(path.first);
+    waypoints.push_back(toWaypoints(path.second));
+  }
+
+  // Each path is generated on one thread, so there is no point splitting up its splines too
+  std::vector<std::unique_ptr<TrajectoryPair>> results(ids.size());
+  std::vector<std::string> errors(ids.size());
+  parallelFor(ids.size(), ithreads, [&](const std::size_t i) {
+    try {
+      results[i] = std::make_unique<TrajectoryPair>(generateTrajectory(std::move(waypoints[i]), 1));
+    } catch (const std::exception &e) {
+      errors[i] = e.what();
+    }
+  });
+
+  // Save the paths in order and stop at the first impossible one, like calling generatePath() for
+  // each path would
+  for (std::size_t i = 0; i < ids.size(); i++) {
+    if (!results[i]) {
+      throw std::runtime_error(errors[i]);
+    }
+
+    storePath(paths.intern(ids[i]), std::move(*results[i]));
   }
+}
 
+std::vector<Waypoint>
+AsyncLinearMotionProfileController::toWaypoints(std::initializer_list<double> iwaypoints) {
   std::vector<Waypoint> points;
   points.reserve(iwaypoints.size());
   for (auto &point : iwaypoints) {
     points.push_back(Waypoint{point, 0, 0});
   }
 
+  return points;
+}
+
+AsyncLinearMotionProfileController::TrajectoryPair
+AsyncLinearMotionProfileController::generateTrajectory(std::vector<Waypoint> points,
+                                                       const std::size_t ithreads) {
+  // Read the sample count once so the key matches the path even if it is changed meanwhile
+  const int samples = sampleCount.load(std::memory_order_acquire);
+  const std::uint64_t key = cache ? getCacheKey(points, samples) : 0;
+  std::vector<CompactTrajectory> cached;
+  if (cache && cache->load(key, format, cached) && cached.size() == 1) {
+    logger->info("AsyncLinearMotionProfileController: Loaded path from cache");
+    const int length = static_cast<int>(cached[0].size());
+    return TrajectoryPair{std::move(cached[0]), length};
+  }
+
+  // Measuring a spline is quick, so only split the splines between threads if there are many
+  std::size_t splineThreads = points.size() > minParallelSplines ? ithreads : 1;
+
   TrajectoryCandidate candidate;
   logger->info("AsyncLinearMotionProfileController: Preparing trajectory");
-  pathfinder_prepare(points.data(),
-                     static_cast<int>(points.size()),
-                     FIT_HERMITE_CUBIC,
-                     PATHFINDER_SAMPLES_FAST,
-                     0.001,
-                     maxVel,
-                     maxAccel,
-                     maxJerk,
-                     &candidate);
+  pathfinder_prepare_parallel(points.data(),
+                              static_cast<int>(points.size()),
+                              FIT_HERMITE_CUBIC,
+                              samples,
+                              0.001,
+                              maxVel,
+                              maxAccel,
+                              maxJerk,
+                              &candidate,
+                              pathfinderParallelFor,
+                              &splineThreads);
 
   const int length = candidate.length;
 
@@ -93,104 +190,246 @@ void AsyncLinearMotionProfileController::generatePath(std::initializer_list<doub
 
     logger->error(message);
 
-    if (candidate.laptr) {
-      free(candidate.laptr);
-    }
-
-    if (candidate.saptr) {
-      free(candidate.saptr);
-    }
+    pathfinder_candidate_free(&candidate);
 
     throw std::runtime_error(message);
   }
 
-  auto *trajectory = static_cast<Segment *>(malloc(length * sizeof(Segment)));
+  TrajectoryPair path{CompactTrajectory(nullptr, 0, format), length};
 
-  if (trajectory == nullptr) {
+  try {
+    path.segment = CompactTrajectory(length, candidate.info.dt, format);
+  } catch (const std::bad_alloc &) {
     std::string message = "AsyncLinearMotionProfileController: Could not allocate trajectory. The "
                           "path is probably impossible.";
     logger->error(message);
 
-    if (candidate.laptr) {
-      free(candidate.laptr);
-    }
-
-    if (candidate.saptr) {
-      free(candidate.saptr);
-    }
+    pathfinder_candidate_free(&candidate);
 
     throw std::runtime_error(message);
   }
 
   logger->info("AsyncLinearMotionProfileController: Generating path");
-  pathfinder_generate(&candidate, trajectory);
+  TrajectoryGenerator generator;
+  if (pathfinder_generator_init(&candidate, &generator) < 0) {
+    std::string message = "AsyncLinearMotionProfileController: Could not start generating the "
+                          "path. The path is probably impossible.";
+    logger->error(message);
+
+    pathfinder_candidate_free(&candidate);
+
+    throw std::runtime_error(message);
+  }
+
+  Segment segment;
+  for (int i = 0; pathfinder_generator_next(&generator, &segment); ++i) {
+    path.segment.set(i, segment);
+  }
+
+  pathfinder_generator_free(&generator);
 
-  // Free the old path before overwriting it
-  removePath(ipathId);
+  if (cache) {
+    cache->store(key, {&path.segment});
+  }
 
-  paths.emplace(ipathId, TrajectoryPair{trajectory, length});
   logger->info("AsyncLinearMotionProfileController: Completely done generating path");
-  logger->info("AsyncLinearMotionProfileController: " + std::to_string(length));
+  logger->info("AsyncLinearMotionProfileController: %d", length);
+  return path;
+}
+
+void AsyncLinearMotionProfileController::storePath(const PathHandle ipath,
+                                                   TrajectoryPair &&itrajectory) {
+  if (!paths.set(ipath, std::make_shared<TrajectoryPair>(std::move(itrajectory)))) {
+    logger->error("AsyncLinearMotionProfileController: Could not save a path because there is no "
+                  "room for more paths.");
+  }
+}
+
+void AsyncLinearMotionProfileController::setCache(const std::shared_ptr<TrajectoryCache> &icache) {
+  cache = icache;
+}
+
+std::uint64_t
+AsyncLinearMotionProfileController::getCacheKey(const std::vector<Waypoint> &iwaypoints,
+                                                const int isamples) const {
+  TrajectoryCache::KeyBuilder key;
+  key.add("AsyncLinearMotionProfileController")
+    .add("FIT_HERMITE_CUBIC")
+    .add(static_cast<std::int64_t>(isamples))
+    .add(0.001)
+    .add(maxVel)
+    .add(maxAccel)
+    .add(maxJerk)
+    .add(static_cast<std::int64_t>(format.fields))
+    .add(static_cast<std::int64_t>(format.precision));
+
+  for (const auto &point : iwaypoints) {
+    key.add(point.x);
+  }
+
+  return key.get();
 }
 
 void AsyncLinearMotionProfileController::removePath(const std::string &ipathId) {
-  auto oldPath = paths.find(ipathId);
-  if (oldPath != paths.end()) {
-    free(oldPath->second.segment);
-    paths.erase(ipathId);
+  removePath(paths.find(ipathId));
+}
+
+void AsyncLinearMotionProfileController::removePath(const PathHandle ipath) {
+  paths.remove(ipath);
+}
+
+PathHandle AsyncLinearMotionProfileController::getPathHandle(const std::string &ipathId) {
+  const PathHandle handle = paths.find(ipathId);
+  if (!handle.isValid()) {
+    logger->warn("AsyncLinearMotionProfileController: There is no path named %s.", ipathId);
   }
+
+  return handle;
 }
 
 std::vector<std::string> AsyncLinearMotionProfileController::getPaths() {
-  std::vector<std::string> keys;
+  return paths.getNames();
+}
 
-  for (const auto &path : paths) {
-    keys.push_back(path.first);
+std::size_t
+AsyncLinearMotionProfileController::getPathMemoryUsage(const std::string &ipathId) const {
+  if (const auto path = paths.get(paths.find(ipathId)); !path) {
+    return 0;
+  } else {
+    return path->segment.getMemoryUsage();
   }
-
-  return keys;
 }
 
 void AsyncLinearMotionProfileController::setTarget(const std::string ipathId) {
-  currentPath = ipathId;
+  const PathHandle handle = paths.find(ipathId);
+  if (!handle.isValid()) {
+    logger->warn("AsyncLinearMotionProfileController: There is no path named %s.", ipathId);
+    followPath(handle, ipathId);
+  } else {
+    followPath(handle, "");
+  }
+}
+
+void AsyncLinearMotionProfileController::setTarget(const PathHandle ipath) {
+  followPath(ipath, "");
+}
+
+void AsyncLinearMotionProfileController::followPath(const PathHandle ipath,
+                                                    const std::string &imissingPathId) {
+  {
+    std::lock_guard<CrossplatformMutex> lock(targetMutex);
+    missingPathId = imissingPathId;
+  }
+
+  currentPath.store(ipath, std::memory_order_release);
   isRunning = true;
 }
 
+bool AsyncLinearMotionProfileController::queuePath(const PathHandle ipath) {
+  if (!ipath.isValid()) {
+    logger->warn("AsyncLinearMotionProfileController: Not queueing an invalid path handle.");
+    return false;
+  }
+
+  if (!pathQueue.push(ipath)) {
+    logger->warn("AsyncLinearMotionProfileController: Not queueing path %s because the queue is "
+                 "full.",
+                 [&]() { return paths.getName(ipath); });
+    return false;
+  }
+
+  return true;
+}
+
+bool AsyncLinearMotionProfileController::queuePath(const std::string &ipathId) {
+  const PathHandle handle = paths.find(ipathId);
+  if (!handle.isValid()) {
+    logger->warn("AsyncLinearMotionProfileController: Not queueing path %s because it does not "
+                 "exist.",
+                 ipathId);
+    return false;
+  }
+
+  return queuePath(handle);
+}
+
+void AsyncLinearMotionProfileController::setPathBlending(const bool iblend) {
+  blending.store(iblend, std::memory_order_release);
+}
+
+void AsyncLinearMotionProfileController::setSampleCount(const int isamples) {
+  if (isamples == 0) {
+    logger->error("AsyncLinearMotionProfileController: The sample count must not be zero.");
+    throw std::invalid_argument(
+      "AsyncLinearMotionProfileController: The sample count must not be zero.");
+  }
+
+  sampleCount.store(isamples, std::memory_order_release);
+}
+
+void AsyncLinearMotionProfileController::clearQueue() {
+  PathHandle path;
+  while (pathQueue.pop(path)) {
+  }
+}
+
 void AsyncLinearMotionProfileController::controllerSet(const std::string ivalue) {
   setTarget(ivalue);
 }
 
 std::string AsyncLinearMotionProfileController::getTarget() {
-  return currentPath;
+  return static_cast<const AsyncLinearMotionProfileController *>(this)->getTarget();
 }
 
 std::string AsyncLinearMotionProfileController::getTarget() const {
-  return currentPath;
+  if (const PathHandle handle = currentPath.load(std::memory_order_acquire); handle.isValid()) {
+    return paths.getName(handle);
+  }
+
+  std::lock_guard<CrossplatformMutex> lock(targetMutex);
+  return missingPathId;
 }
 
 void AsyncLinearMotionProfileController::loop() {
   auto rate = timeUtil.getRate();
 
   while (!dtorCalled.load(std::memory_order_acquire)) {
+    if (isDisabled()) {
+      clearQueue();
+    } else if (!isRunning.load(std::memory_order_acquire) && pathQueue.size() > 0) {
+      // A path was queued while nothing was running. Mark the controller as running before
+      // popping so isSettled() never sees an empty queue and an idle controller in between.
+      isRunning.store(true, std::memory_order_release);
+      PathHandle next;
+      pathQueue.pop(next);
+      setTarget(next);
+    }
+
     if (isRunning.load(std::memory_order_acquire) && !isDisabled()) {
-      logger->info("AsyncLinearMotionProfileController: Running with path: " + currentPath);
-      auto path = paths.find(currentPath);
+      logger->info("AsyncLinearMotionProfileController: Running with path: %s",
+                   [&]() { return getTarget(); });
+      // Hold a reference so the path stays alive even if it is removed while being followed
+      const auto path = paths.get(currentPath.load(std::memory_order_acquire));
 
-      if (path == paths.end()) {
+      if (!path) {
         logger->warn(
-          "AsyncLinearMotionProfileController: Target was set to non-existent path with name: " +
-          currentPath);
+          "AsyncLinearMotionProfileController: Target was set to non-existent path with name: %s",
+          [&]() { return getTarget(); });
       } else {
-        logger->debug("AsyncLinearMotionProfileController: Path length is " +
-                      std::to_string(path->second.length));
+        logger->debug("AsyncLinearMotionProfileController: Path length is %d", path->length);
 
-        executeSinglePath(path->second, timeUtil.getRate());
+        executeSinglePath(*path, makeFollowingRate());
         output->controllerSet(0);
 
         logger->info("AsyncLinearMotionProfileController: Done moving");
       }
 
+      if (isDisabled()) {
+        clearQueue();
+      }
+
       isRunning.store(false, std::memory_order_release);
+      notifySettled();
     }
 
     rate->delayUntil(10_ms);
@@ -199,11 +438,123 @@ void AsyncLinearMotionProfileController::loop() {
 
 void AsyncLinearMotionProfileController::executeSinglePath(const TrajectoryPair &path,
                                                            std::unique_ptr<AbstractRate> rate) {
-  for (int i = 0; i < path.length && !isDisabled(); ++i) {
-    currentProfilePosition = path.segment[i].position;
-    output->controllerSet(path.segment[i].velocity / maxVel);
-    rate->delayUntil(1_ms);
+  using Field = CompactTrajectory::Field;
+
+  const double dt = path.segment.getDt();
+  // Reserve room for the whole queue up front so chaining paths never allocates while following
+  std::vector<ChainedPath> chain;
+  chain.reserve(maxQueuedPaths + 1);
+  chain.push_back(ChainedPath{&path,
+                              nullptr,
+                              currentPath.load(std::memory_order_acquire),
+                              0,
+                              static_cast<double>(path.length - 1) * dt,
+                              true});
+
+  TrajectoryPlayback playback(timeUtil.getTimer(), std::move(rate), outputPeriod);
+  playback.play(std::numeric_limits<std::size_t>::max(), dt * second, [&](const double index) {
+    if (isDisabled()) {
+      return false;
+    }
+
+    const double time = index * dt;
+    chainQueuedPath(chain, time);
+
+    while (chain.size() > 1 && time >= chain.front().end) {
+      chain.erase(chain.begin());
+    }
+
+    // The paths are followed as one profile by adding their velocities together. The position is
+    // measured along the newest path, less what is left of the paths it overlaps.
+    double velocity = 0;
+    double position = 0;
+    double remaining = 0;
+    double left = 0;
+    for (auto &link : chain) {
+      if (time < link.start) {
+        break;
+      }
+
+      if (!link.started) {
+        link.started = true;
+        currentPath.store(link.handle, std::memory_order_release);
+        logger->info("AsyncLinearMotionProfileController: Moving into queued path: %s",
+                     [&]() { return paths.getName(link.handle); });
+      }
+
+      const CompactTrajectory &segment = link.path->segment;
+      const double linkIndex = (time - link.start) / segment.getDt();
+      velocity += segment.interpolate(Field::velocity, linkIndex);
+      remaining += left;
+      position = segment.interpolate(Field::position, linkIndex);
+      left = segment.get(Field::position, segment.size() - 1) - position;
+    }
+
+    currentProfilePosition = position - remaining;
+    output->controllerSet(velocity / maxVel);
+
+    return time < chain.back().end || pathQueue.size() > 0;
+  });
+}
+
+void AsyncLinearMotionProfileController::chainQueuedPath(std::vector<ChainedPath> &ichain,
+                                                         const double itime) {
+  // Leave paths in the queue until there is room in the chain
+  PathHandle handle;
+  if (ichain.size() > maxQueuedPaths || !pathQueue.pop(handle)) {
+    return;
+  }
+
+  const auto next = paths.get(handle);
+  if (!next) {
+    logger->warn(
+      "AsyncLinearMotionProfileController: Skipping queued path which does not exist: %s",
+      [&]() { return paths.getName(handle); });
+    return;
   }
+
+  const double start = std::max(getChainStart(ichain, *next), itime);
+  ichain.push_back(ChainedPath{
+    next.get(),
+    next,
+    handle,
+    start,
+    start + static_cast<double>(next->length - 1) * next->segment.getDt()});
+}
+
+double
+AsyncLinearMotionProfileController::getChainStart(const std::vector<ChainedPath> &ichain,
+                                                  const TrajectoryPair &inext) const {
+  using Field = CompactTrajectory::Field;
+  const ChainedPath &last = ichain.back();
+  const CompactTrajectory &path = last.path->segment;
+  const auto lastEnd = static_cast<std::size_t>(last.path->length - 1);
+
+  // Paths which move in opposite directions have to stop to turn around
+  const double lastDistance = path.get(Field::position, lastEnd) - path.get(Field::position, 0);
+  const double nextDistance = inext.segment.get(Field::position, inext.length - 1) -
+                              inext.segment.get(Field::position, 0);
+  if (!blending.load(std::memory_order_acquire) || lastDistance * nextDistance <= 0) {
+    return last.end;
+  }
+
+  // Overlap the last path slowing down with the next path speeding up. Both profiles change speed
+  // at the same rate, so their velocities add up to a constant speed through the overlap.
+  const std::size_t slowing = lastEnd - path.findPeak(Field::velocity).second;
+  const std::size_t speeding = inext.segment.findPeak(Field::velocity).first;
+
+  return last.end - std::min(static_cast<double>(slowing) * path.getDt(),
+                             static_cast<double>(speeding) * inext.segment.getDt());
+}
+
+std::unique_ptr<AbstractRate> AsyncLinearMotionProfileController::makeFollowingRate() const {
+  auto rate = timeUtil.getRate();
+  rate->trackDeadlines(timingStats);
+  return rate;
+}
+
+std::shared_ptr<LoopTimingStats> AsyncLinearMotionProfileController::getTimingStats() const {
+  return timingStats;
 }
 
 void AsyncLinearMotionProfileController::trampoline(void *context) {
@@ -215,41 +566,43 @@ void AsyncLinearMotionProfileController::trampoline(void *context) {
 void AsyncLinearMotionProfileController::waitUntilSettled() {
   logger->info("AsyncLinearMotionProfileController: Waiting to settle");
 
-  auto rate = timeUtil.getRate();
-  while (!isSettled()) {
-    rate->delayUntil(10_ms);
-  }
+  // loop() wakes this task up once it finishes following the path
+  std::unique_lock<CrossplatformMutex> lock(settledMutex);
+  settledCondition.wait(lock, [&]() { return isSettled(); });
 
   logger->info("AsyncLinearMotionProfileController: Done waiting to settle");
 }
 
 void AsyncLinearMotionProfileController::moveTo(double iposition, double itarget) {
-  std::string name = reinterpret_cast<const char *>(this); // hmmmm...
-  generatePath({iposition, itarget}, name);
-  setTarget(name);
+  const PathHandle path = generatePath({iposition, itarget});
+  setTarget(path);
   waitUntilSettled();
-  removePath(name);
+  removePath(path);
 }
 
 double AsyncLinearMotionProfileController::getError() const {
-  if (const auto path = paths.find(getTarget()); path == paths.end()) {
+  if (const auto path = paths.get(currentPath.load(std::memory_order_acquire)); !path) {
     return 0;
   } else {
     // The last position in the path is the target position
-    return path->second.segment[path->second.length - 1].position - currentProfilePosition;
+    return path->segment.get(CompactTrajectory::Field::position, path->length - 1) -
+           currentProfilePosition;
   }
 }
 
 bool AsyncLinearMotionProfileController::isSettled() {
-  return isDisabled() || !isRunning.load(std::memory_order_acquire);
+  // Check the queue first because loop() marks the controller as running before popping from it
+  return isDisabled() ||
+         (pathQueue.size() == 0 && !isRunning.load(std::memory_order_acquire));
 }
 
 void AsyncLinearMotionProfileController::reset() {
   // Interrupt executeSinglePath() by disabling the controller
   flipDisable(true);
 
+  // loop() drops the queued paths while the controller is disabled
   auto rate = timeUtil.getRate();
-  while (isRunning.load(std::memory_order_acquire)) {
+  while (isRunning.load(std::memory_order_acquire) || pathQueue.size() > 0) {
     rate->delayUntil(1_ms);
   }
 
@@ -261,12 +614,18 @@ void AsyncLinearMotionProfileController::flipDisable() {
 }
 
 void AsyncLinearMotionProfileController::flipDisable(const bool iisDisabled) {
-  logger->info("AsyncLinearMotionProfileController: flipDisable " + std::to_string(iisDisabled));
+  logger->info("AsyncLinearMotionProfileController: flipDisable %d", iisDisabled);
   disabled.store(iisDisabled, std::memory_order_release);
+  notifySettled();
   // loop() will set the output to 0 when executeSinglePath() is done
   // the default implementation of executeSinglePath() breaks when disabled
 }
 
+void AsyncLinearMotionProfileController::notifySettled() {
+  std::lock_guard<CrossplatformMutex> lock(settledMutex);
+  settledCondition.notifyAll();
+}
+
 bool AsyncLinearMotionProfileController::isDisabled() const {
   return disabled.load(std::memory_order_acquire);
 }
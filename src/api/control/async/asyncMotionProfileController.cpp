@@ -7,6 +7,10 @@
  */
 #include "okapi/api/control/async/asyncMotionProfileController.hpp"
 #include "okapi/api/util/mathUtil.hpp"
+#include <array>
+#include <cmath>
+#include <limits>
+#include <mutex>
 #include <numeric>
 
 namespace okapi {
@@ -17,7 +21,9 @@ AsyncMotionProfileController::AsyncMotionProfileController(
   const double imaxJerk,
   const std::shared_ptr<ChassisModel> &imodel,
   const ChassisScales &iscales,
-  AbstractMotor::GearsetRatioPair ipair)
+  AbstractMotor::GearsetRatioPair ipair,
+  const CompactTrajectory::Format &iformat,
+  const QTime ioutputPeriod)
   : logger(Logger::instance()),
     maxVel(imaxVel),
     maxAccel(imaxAccel),
@@ -25,7 +31,10 @@ AsyncMotionProfileController::AsyncMotionProfileController(
     model(imodel),
     scales(iscales),
     pair(ipair),
-    timeUtil(itimeUtil) {
+    format(iformat),
+    outputPeriod(ioutputPeriod),
+    timeUtil(itimeUtil),
+    timingStats(LoopTimingStats::withMissWarning("AsyncMotionProfileController")) {
   if (ipair.ratio == 0) {
     logger->error("AsyncMotionProfileController: The gear ratio cannot be zero! Check if you are "
                   "using integer division.");
@@ -37,7 +46,7 @@ AsyncMotionProfileController::AsyncMotionProfileController(
 
 AsyncMotionProfileController::AsyncMotionProfileController(
   AsyncMotionProfileController &&other) noexcept
-  : logger(other.logger),
+  : logger(stopGenerationTask(other)),
     paths(std::move(other.paths)),
     maxVel(other.maxVel),
     maxAccel(other.maxAccel),
@@ -45,34 +54,149 @@ AsyncMotionProfileController::AsyncMotionProfileController(
     model(std::move(other.model)),
     scales(other.scales),
     pair(other.pair),
+    format(other.format),
+    outputPeriod(other.outputPeriod),
     timeUtil(std::move(other.timeUtil)),
-    currentPath(std::move(other.currentPath)),
+    timingStats(std::move(other.timingStats)),
+    cache(std::move(other.cache)),
+    gains(other.gains),
+    closedLoop(other.closedLoop),
+    positionError(other.positionError.load()),
+    headingError(other.headingError.load()),
+    currentPath(other.currentPath.load(std::memory_order_acquire)),
     isRunning(other.isRunning.load(std::memory_order_acquire)),
+    blending(other.blending.load(std::memory_order_acquire)),
+    sampleCount(other.sampleCount.load(std::memory_order_acquire)),
     disabled(other.disabled.load(std::memory_order_acquire)),
     dtorCalled(other.dtorCalled.load(std::memory_order_acquire)),
     task(other.task) {
+  std::lock_guard<CrossplatformMutex> lock(other.pathsMutex);
+  generationQueue = std::move(other.generationQueue);
+  pendingPaths = std::move(other.pendingPaths);
+  currentStream = std::move(other.currentStream);
+  missingPathId = std::move(other.missingPathId);
+
+  // The other controller's generation task was stopped, so generate the queued paths here
+  if (!generationQueue.empty()) {
+    generationTask = new CrossplatformThread(generationTrampoline, this);
+  }
+}
+
+Logger *AsyncMotionProfileController::stopGenerationTask(AsyncMotionProfileController &iother) {
+  if (iother.generationTask) {
+    iother.stopGeneration.store(true, std::memory_order_release);
+    iother.generationTask->join();
+    delete iother.generationTask;
+    iother.generationTask = nullptr;
+  }
+
+  return iother.logger;
 }
 
 AsyncMotionProfileController::~AsyncMotionProfileController() {
   dtorCalled.store(true, std::memory_order_release);
+  delete task;
+  delete generationTask;
+}
 
-  for (auto &path : paths) {
-    free(path.second.left);
-    free(path.second.right);
+PathHandle AsyncMotionProfileController::generatePath(std::initializer_list<Point> iwaypoints,
+                                                      const std::string &ipathId) {
+  if (iwaypoints.size() == 0) {
+    // No point in generating a path
+    logger->warn(
+      "AsyncMotionProfileController: Not generating a path because no waypoints were given.");
+    return PathHandle();
   }
 
-  delete task;
+  auto trajectory = generateTrajectory(toWaypoints(iwaypoints), defaultThreadCount());
+  const PathHandle handle = paths.intern(ipathId);
+  storePath(handle, std::move(trajectory));
+  return handle;
 }
 
-void AsyncMotionProfileController::generatePath(std::initializer_list<Point> iwaypoints,
-                                                const std::string &ipathId) {
+PathHandle AsyncMotionProfileController::generatePath(std::initializer_list<Point> iwaypoints) {
   if (iwaypoints.size() == 0) {
     // No point in generating a path
     logger->warn(
       "AsyncMotionProfileController: Not generating a path because no waypoints were given.");
-    return;
+    return PathHandle();
+  }
+
+  auto trajectory = generateTrajectory(toWaypoints(iwaypoints), defaultThreadCount());
+  const PathHandle handle = paths.create();
+  storePath(handle, std::move(trajectory));
+  return handle;
+}
+
+void AsyncMotionProfileController::generatePaths(
+  std::initializer_list<std::pair<std::string, std::initializer_list<Point>>> ipaths,
+  const std::size_t ithreads) {
+  std::vector<std::string> ids;
+  std::vector<std::vector<Waypoint>> waypoints;
+  for (const auto &path : ipaths) {
+    if (path.second.size() == 0) {
+      // No point in generating a path
+      logger->warn(
+        "AsyncMotionProfileController: Not generating path %s because no waypoints were given.",
+        path.first);
+      continue;
+    }
+
+    ids.push_back(path.first);
+    waypoints.push_back(toWaypoints(path.second));
+  }
+
+  // Each path is generated on one thread, so there is no point splitting up its splines too
+  std::vector<std::unique_ptr<TrajectoryPair>> results(ids.size());
+  std::vector<std::string> errors(ids.size());
+  parallelFor(ids.size(), ithreads, [&](const std::size_t i) {
+    try {
+      results[i] = std::make_unique<TrajectoryPair>(generateTrajectory(std::move(waypoints[i]), 1));
+    } catch (const std::exception &e) {
+      errors[i] = e.what();
+    }
+  });
+
+  // Save the paths in order and stop at the first impossible one, like calling generatePath() for
+  // each path would
+  for (std::size_t i = 0; i < ids.size(); i++) {
+    if (!results[i]) {
+      throw std::runtime_error(errors[i]);
+    }
+
+    storePath(paths.intern(ids[i]), std::move(*results[i]));
   }
+}
 
+PathFuture AsyncMotionProfileController::generatePathAsync(std::initializer_list<Point> iwaypoints,
+                                                           const std::string &ipathId) {
+  auto state = std::make_shared<PathFuture::State>(ipathId);
+
+  if (iwaypoints.size() == 0) {
+    // No point in generating a path
+    logger->warn(
+      "AsyncMotionProfileController: Not generating a path because no waypoints were given.");
+    state->error = "AsyncMotionProfileController: No waypoints were given.";
+    state->status.store(PathFuture::Status::failed, std::memory_order_release);
+    return PathFuture(state, timeUtil);
+  }
+
+  {
+    std::lock_guard<CrossplatformMutex> lock(pathsMutex);
+    const PathHandle handle = paths.intern(ipathId);
+    generationQueue.push_back(GenerationJob{toWaypoints(iwaypoints), handle, state});
+    pendingPaths[handle]++;
+  }
+
+  if (!generationTask) {
+    generationTask = new CrossplatformThread(generationTrampoline, this);
+  }
+
+  return PathFuture(state, timeUtil);
+}
+
+std::vector<Waypoint>
+AsyncMotionProfileController::toWaypoints(std::initializer_list<Point> iwaypoints) {
   std::vector<Waypoint> points;
   points.reserve(iwaypoints.size());
   for (auto &point : iwaypoints) {
@@ -80,21 +204,79 @@ void AsyncMotionProfileController::generatePath(std::initializer_list<Point> iwa
       Waypoint{point.x.convert(meter), point.y.convert(meter), point.theta.convert(radian)});
   }
 
-  TrajectoryCandidate candidate;
-  logger->info("AsyncMotionProfileController: Preparing trajectory");
-  pathfinder_prepare(points.data(),
-                     static_cast<int>(points.size()),
-                     FIT_HERMITE_CUBIC,
-                     PATHFINDER_SAMPLES_FAST,
-                     0.001,
-                     maxVel,
-                     maxAccel,
-                     maxJerk,
-                     &candidate);
+  return points;
+}
+
+AsyncMotionProfileController::TrajectoryPair
+AsyncMotionProfileController::generateTrajectory(std::vector<Waypoint> points,
+                                                 const std::size_t ithreads) {
+  // Read the sample count once so the key matches the path even if it is changed meanwhile
+  const int samples = sampleCount.load(std::memory_order_acquire);
+  const std::uint64_t key = cache ? getCacheKey(points, samples) : 0;
+  std::vector<CompactTrajectory> cached;
+  if (cache && cache->load(key, format, cached) && cached.size() == 2) {
+    logger->info("AsyncMotionProfileController: Loaded path from cache");
+    const int length = static_cast<int>(cached[0].size());
+    return TrajectoryPair{std::move(cached[0]), std::move(cached[1]), length};
+  }
 
+  TrajectoryCandidate candidate;
+  TrajectoryGenerator generator;
+  startGenerator(points, ithreads, samples, candidate, generator);
   const int length = candidate.length;
 
-  if (length < 0) {
+  TrajectoryPair path{
+    CompactTrajectory(nullptr, 0, format), CompactTrajectory(nullptr, 0, format), length};
+
+  try {
+    path.left = CompactTrajectory(length, candidate.info.dt, format);
+    path.right = CompactTrajectory(length, candidate.info.dt, format);
+  } catch (const std::bad_alloc &) {
+    std::string message = "AsyncMotionProfileController: Could not allocate left and/or right "
+                          "trajectories. The path is probably impossible.";
+    logger->error(message);
+    pathfinder_generator_free(&generator);
+    throw std::runtime_error(message);
+  }
+
+  logger->info("AsyncMotionProfileController: Generating path for tank drive");
+  generateTankSegments(generator, [&](const int i, const Segment &left, const Segment &right) {
+    path.left.set(i, left);
+    path.right.set(i, right);
+    return true;
+  });
+
+  if (cache) {
+    cache->store(key, {&path.left, &path.right});
+  }
+
+  logger->info("AsyncMotionProfileController: Completely done generating path");
+  logger->info("AsyncMotionProfileController: %d", length);
+  return path;
+}
+
+void AsyncMotionProfileController::startGenerator(std::vector<Waypoint> &points,
+                                                  const std::size_t ithreads,
+                                                  const int isamples,
+                                                  TrajectoryCandidate &icandidate,
+                                                  TrajectoryGenerator &igenerator) {
+  // Measuring a spline is quick, so only split the splines between threads if there are many
+  std::size_t splineThreads = points.size() > minParallelSplines ? ithreads : 1;
+
+  logger->info("AsyncMotionProfileController: Preparing trajectory");
+  pathfinder_prepare_parallel(points.data(),
+                              static_cast<int>(points.size()),
+                              FIT_HERMITE_CUBIC,
+                              isamples,
+                              0.001,
+                              maxVel,
+                              maxAccel,
+                              maxJerk,
+                              &icandidate,
+                              pathfinderParallelFor,
+                              &splineThreads);
+
+  if (icandidate.length < 0) {
     auto pointToString = [](Waypoint point) {
       return "Point{x = " + std::to_string(point.x) + ", y = " + std::to_string(point.y) +
              ", theta = " + std::to_string(point.angle) + "}";
@@ -108,93 +290,257 @@ void AsyncMotionProfileController::generatePath(std::initializer_list<Point> iwa
                       [&](std::string a, Waypoint b) { return a + ", " + pointToString(b); });
 
     logger->error(message);
+    pathfinder_candidate_free(&icandidate);
+    throw std::runtime_error(message);
+  }
 
-    if (candidate.laptr) {
-      free(candidate.laptr);
-    }
+  if (pathfinder_generator_init(&icandidate, &igenerator) < 0) {
+    std::string message = "AsyncMotionProfileController: Could not start generating the path. The "
+                          "path is probably impossible.";
+    logger->error(message);
+    pathfinder_candidate_free(&icandidate);
+    throw std::runtime_error(message);
+  }
+}
 
-    if (candidate.saptr) {
-      free(candidate.saptr);
+bool AsyncMotionProfileController::generateTankSegments(
+  TrajectoryGenerator &igenerator,
+  const std::function<bool(int, const Segment &, const Segment &)> &iconsumer) {
+  // The tank modifier only looks back one segment, so each side is generated through a two
+  // segment window instead of a full buffer
+  std::array<Segment, 2> left{};
+  std::array<Segment, 2> right{};
+  Segment segment;
+  bool finished = true;
+  for (int i = 0; pathfinder_generator_next(&igenerator, &segment); ++i) {
+    const int window = i > 0 ? 1 : 0;
+    pathfinder_modify_tank_segment(
+      segment, window, left.data(), right.data(), scales.wheelbaseWidth.convert(meter));
+
+    if (!iconsumer(i, left[window], right[window])) {
+      finished = false;
+      break;
     }
 
-    throw std::runtime_error(message);
+    left[0] = left[window];
+    right[0] = right[window];
   }
 
-  auto *trajectory = static_cast<Segment *>(malloc(length * sizeof(Segment)));
+  pathfinder_generator_free(&igenerator);
+  return finished;
+}
 
-  if (trajectory == nullptr) {
-    std::string message = "AsyncMotionProfileController: Could not allocate trajectory. The path "
-                          "is probably impossible.";
-    logger->error(message);
+void AsyncMotionProfileController::streamPath(std::vector<Waypoint> points) {
+  TrajectoryCandidate candidate;
+  TrajectoryGenerator generator;
+  const int samples = sampleCount.load(std::memory_order_acquire);
+  startGenerator(points, defaultThreadCount(), samples, candidate, generator);
 
-    if (candidate.laptr) {
-      free(candidate.laptr);
-    }
+  // Targets are ignored while a path is being followed, so let it finish first
+  waitUntilSettled();
 
-    if (candidate.saptr) {
-      free(candidate.saptr);
-    }
+  auto stream = std::make_shared<TrajectoryStream>();
+  stream->dt = candidate.info.dt;
+  {
+    std::lock_guard<CrossplatformMutex> lock(pathsMutex);
+    currentStream = stream;
+  }
 
-    throw std::runtime_error(message);
+  direction.store(1, std::memory_order_release);
+  isRunning.store(true, std::memory_order_release);
+
+  logger->info("AsyncMotionProfileController: Streaming path for tank drive");
+  auto rate = timeUtil.getRate();
+  const bool finished =
+    generateTankSegments(generator, [&](int, const Segment &left, const Segment &right) {
+      const PathTarget target{{left.position, left.velocity, left.acceleration},
+                              {right.position, right.velocity, right.acceleration},
+                              left.heading};
+      while (!stream->segments.push(target)) {
+        // The buffer is full, so wait for loop() to catch up unless it stopped following the path
+        if (stream->cancelled.load(std::memory_order_acquire) || isDisabled() ||
+            dtorCalled.load(std::memory_order_acquire)) {
+          return false;
+        }
+
+        rate->delayUntil(1_ms);
+      }
+
+      return true;
+    });
+
+  stream->done.store(true, std::memory_order_release);
+
+  if (!finished) {
+    logger->info("AsyncMotionProfileController: Stopped streaming path");
   }
 
-  logger->info("AsyncMotionProfileController: Generating path");
-  pathfinder_generate(&candidate, trajectory);
+  waitUntilSettled();
 
-  auto *leftTrajectory = (Segment *)malloc(sizeof(Segment) * length);
-  auto *rightTrajectory = (Segment *)malloc(sizeof(Segment) * length);
+  // If loop() never picked up the stream (because the controller was disabled), drop it so it is
+  // not followed later
+  std::unique_lock<CrossplatformMutex> lock(pathsMutex);
+  if (currentStream == stream) {
+    currentStream = nullptr;
+    isRunning.store(false, std::memory_order_release);
+    lock.unlock();
+    notifySettled();
+  }
+}
 
-  if (leftTrajectory == nullptr || rightTrajectory == nullptr) {
-    std::string message = "AsyncMotionProfileController: Could not allocate left and/or right "
-                          "trajectories. The path is probably impossible.";
-    logger->error(message);
+void AsyncMotionProfileController::storePath(const PathHandle ipath,
+                                             TrajectoryPair &&itrajectory) {
+  if (!paths.set(ipath, std::make_shared<TrajectoryPair>(std::move(itrajectory)))) {
+    logger->error("AsyncMotionProfileController: Could not save a path because there is no room "
+                  "for more paths.");
+  }
+}
 
-    if (leftTrajectory) {
-      free(leftTrajectory);
+void AsyncMotionProfileController::generationLoop() {
+  auto rate = timeUtil.getRate();
+
+  while (!dtorCalled.load(std::memory_order_acquire) &&
+         !stopGeneration.load(std::memory_order_acquire)) {
+    std::unique_lock<CrossplatformMutex> lock(pathsMutex);
+    if (generationQueue.empty()) {
+      lock.unlock();
+      rate->delayUntil(10_ms);
+      continue;
     }
 
-    if (rightTrajectory) {
-      free(rightTrajectory);
+    GenerationJob job = std::move(generationQueue.front());
+    generationQueue.pop_front();
+    lock.unlock();
+
+    try {
+      storePath(job.path, generateTrajectory(std::move(job.waypoints), 1));
+      job.state->status.store(PathFuture::Status::ready, std::memory_order_release);
+    } catch (const std::exception &e) {
+      job.state->error = e.what();
+      job.state->status.store(PathFuture::Status::failed, std::memory_order_release);
     }
 
-    if (trajectory) {
-      free(trajectory);
+    lock.lock();
+    if (--pendingPaths[job.path] == 0) {
+      pendingPaths.erase(job.path);
     }
+  }
 
-    throw std::runtime_error(message);
+  if (!dtorCalled.load(std::memory_order_acquire)) {
+    // The queue was moved to another controller, which generates the rest of it
+    return;
+  }
+
+  // Don't leave anyone waiting on paths which will never be generated
+  std::lock_guard<CrossplatformMutex> lock(pathsMutex);
+  for (auto &job : generationQueue) {
+    job.state->error = "AsyncMotionProfileController: The controller was destroyed before the "
+                       "path was generated.";
+    job.state->status.store(PathFuture::Status::failed, std::memory_order_release);
+  }
+  generationQueue.clear();
+  pendingPaths.clear();
+}
+
+void AsyncMotionProfileController::generationTrampoline(void *context) {
+  if (context) {
+    static_cast<AsyncMotionProfileController *>(context)->generationLoop();
   }
+}
 
-  logger->info("AsyncMotionProfileController: Modifying for tank drive");
-  pathfinder_modify_tank(
-    trajectory, length, leftTrajectory, rightTrajectory, scales.wheelbaseWidth.convert(meter));
+void AsyncMotionProfileController::setCache(const std::shared_ptr<TrajectoryCache> &icache) {
+  cache = icache;
+}
 
-  free(trajectory);
+void AsyncMotionProfileController::setFollowerGains(const FollowerGains &igains) {
+  const bool hasFields =
+    (format.fields & CompactTrajectory::mask({CompactTrajectory::Field::position,
+                                              CompactTrajectory::Field::velocity,
+                                              CompactTrajectory::Field::heading})) ==
+      CompactTrajectory::mask({CompactTrajectory::Field::position,
+                               CompactTrajectory::Field::velocity,
+                               CompactTrajectory::Field::heading}) &&
+    (igains.kA == 0 || (format.fields & CompactTrajectory::mask(
+                                          {CompactTrajectory::Field::acceleration})) != 0);
+  if (!hasFields) {
+    logger->error("AsyncMotionProfileController: Following paths closed-loop needs position, "
+                  "velocity, and heading (and acceleration if kA is not zero) to be stored.");
+    throw std::invalid_argument(
+      "AsyncMotionProfileController: Following paths closed-loop needs position, velocity, and "
+      "heading (and acceleration if kA is not zero) to be stored.");
+  }
 
-  // Free the old path before overwriting it
-  removePath(ipathId);
+  if (model->getSensorVals().size() < 2) {
+    logger->error("AsyncMotionProfileController: Following paths closed-loop needs a sensor for "
+                  "each side of the chassis.");
+    throw std::invalid_argument("AsyncMotionProfileController: Following paths closed-loop needs "
+                                "a sensor for each side of the chassis.");
+  }
 
-  paths.emplace(ipathId, TrajectoryPair{leftTrajectory, rightTrajectory, length});
-  logger->info("AsyncMotionProfileController: Completely done generating path");
-  logger->info("AsyncMotionProfileController: " + std::to_string(length));
+  std::lock_guard<CrossplatformMutex> lock(gainsMutex);
+  gains = igains;
+  closedLoop = true;
+}
+
+void AsyncMotionProfileController::disableFollowerGains() {
+  {
+    std::lock_guard<CrossplatformMutex> lock(gainsMutex);
+    closedLoop = false;
+  }
+
+  positionError.store(0);
+  headingError.store(0);
+}
+
+std::uint64_t
+AsyncMotionProfileController::getCacheKey(const std::vector<Waypoint> &iwaypoints,
+                                          const int isamples) const {
+  TrajectoryCache::KeyBuilder key;
+  key.add("AsyncMotionProfileController")
+    .add("FIT_HERMITE_CUBIC")
+    .add(static_cast<std::int64_t>(isamples))
+    .add(0.001)
+    .add(maxVel)
+    .add(maxAccel)
+    .add(maxJerk)
+    .add(scales.wheelbaseWidth.convert(meter))
+    .add(static_cast<std::int64_t>(format.fields))
+    .add(static_cast<std::int64_t>(format.precision));
+
+  for (const auto &point : iwaypoints) {
+    key.add(point.x).add(point.y).add(point.angle);
+  }
+
+  return key.get();
 }
 
 void AsyncMotionProfileController::removePath(const std::string &ipathId) {
-  auto oldPath = paths.find(ipathId);
-  if (oldPath != paths.end()) {
-    free(oldPath->second.left);
-    free(oldPath->second.right);
-    paths.erase(ipathId);
+  removePath(paths.find(ipathId));
+}
+
+void AsyncMotionProfileController::removePath(const PathHandle ipath) {
+  paths.remove(ipath);
+}
+
+PathHandle AsyncMotionProfileController::getPathHandle(const std::string &ipathId) {
+  const PathHandle handle = paths.find(ipathId);
+  if (!handle.isValid()) {
+    logger->warn("AsyncMotionProfileController: There is no path named %s.", ipathId);
   }
+
+  return handle;
 }
 
 std::vector<std::string> AsyncMotionProfileController::getPaths() {
-  std::vector<std::string> keys;
+  return paths.getNames();
+}
 
-  for (const auto &path : paths) {
-    keys.push_back(path.first);
+std::size_t AsyncMotionProfileController::getPathMemoryUsage(const std::string &ipathId) const {
+  if (const auto path = paths.get(paths.find(ipathId)); !path) {
+    return 0;
+  } else {
+    return path->left.getMemoryUsage() + path->right.getMemoryUsage();
   }
-
-  return keys;
 }
 
 void AsyncMotionProfileController::setTarget(std::string ipathId) {
@@ -202,67 +548,487 @@ void AsyncMotionProfileController::setTarget(std::string ipathId) {
 }
 
 void AsyncMotionProfileController::setTarget(std::string ipathId, const bool ibackwards) {
-  currentPath = ipathId;
+  const PathHandle handle = paths.find(ipathId);
+  if (!handle.isValid()) {
+    logger->warn("AsyncMotionProfileController: There is no path named %s.", ipathId);
+    followPath(handle, ibackwards, ipathId);
+  } else {
+    followPath(handle, ibackwards, "");
+  }
+}
+
+void AsyncMotionProfileController::setTarget(const PathHandle ipath, const bool ibackwards) {
+  followPath(ipath, ibackwards, "");
+}
+
+void AsyncMotionProfileController::followPath(const PathHandle ipath,
+                                              const bool ibackwards,
+                                              const std::string &imissingPathId) {
+  {
+    std::lock_guard<CrossplatformMutex> lock(pathsMutex);
+    missingPathId = imissingPathId;
+  }
+
+  currentPath.store(ipath, std::memory_order_release);
   isRunning.store(true, std::memory_order_release);
   direction.store(boolToSign(!ibackwards), std::memory_order_release);
 }
 
+bool AsyncMotionProfileController::queuePath(const PathHandle ipath, const bool ibackwards) {
+  if (!ipath.isValid()) {
+    logger->warn("AsyncMotionProfileController: Not queueing an invalid path handle.");
+    return false;
+  }
+
+  if (!pathQueue.push(QueuedPath{ipath, boolToSign(!ibackwards)})) {
+    logger->warn("AsyncMotionProfileController: Not queueing path %s because the queue is full.",
+                 [&]() { return paths.getName(ipath); });
+    return false;
+  }
+
+  return true;
+}
+
+bool AsyncMotionProfileController::queuePath(const std::string &ipathId, const bool ibackwards) {
+  const PathHandle handle = paths.find(ipathId);
+  if (!handle.isValid()) {
+    logger->warn("AsyncMotionProfileController: Not queueing path %s because it does not exist.",
+                 ipathId);
+    return false;
+  }
+
+  return queuePath(handle, ibackwards);
+}
+
+void AsyncMotionProfileController::setPathBlending(const bool iblend) {
+  using Field = CompactTrajectory::Field;
+  if (iblend && (format.fields & CompactTrajectory::mask({Field::heading})) == 0) {
+    logger->warn("AsyncMotionProfileController: Paths are stored without their heading, so they "
+                 "will not be blended.");
+  }
+
+  blending.store(iblend, std::memory_order_release);
+}
+
+void AsyncMotionProfileController::setSampleCount(const int isamples) {
+  if (isamples == 0) {
+    logger->error("AsyncMotionProfileController: The sample count must not be zero.");
+    throw std::invalid_argument("AsyncMotionProfileController: The sample count must not be zero.");
+  }
+
+  sampleCount.store(isamples, std::memory_order_release);
+}
+
+void AsyncMotionProfileController::clearQueue() {
+  QueuedPath path;
+  while (pathQueue.pop(path)) {
+  }
+}
+
 void AsyncMotionProfileController::controllerSet(std::string ivalue) {
   setTarget(ivalue);
 }
 
 std::string AsyncMotionProfileController::getTarget() {
-  return currentPath;
+  if (const PathHandle handle = currentPath.load(std::memory_order_acquire); handle.isValid()) {
+    return paths.getName(handle);
+  }
+
+  std::lock_guard<CrossplatformMutex> lock(pathsMutex);
+  return missingPathId;
 }
 
 void AsyncMotionProfileController::loop() {
   auto rate = timeUtil.getRate();
 
   while (!dtorCalled.load(std::memory_order_acquire)) {
+    if (isDisabled()) {
+      clearQueue();
+    } else if (!isRunning.load(std::memory_order_acquire) && pathQueue.size() > 0) {
+      // A path was queued while nothing was running. Mark the controller as running before
+      // popping so isSettled() never sees an empty queue and an idle controller in between.
+      isRunning.store(true, std::memory_order_release);
+      QueuedPath next;
+      pathQueue.pop(next);
+      setTarget(next.path, next.direction < 0);
+    }
+
     if (isRunning.load(std::memory_order_acquire) && !isDisabled()) {
-      logger->info("AsyncMotionProfileController: Running with path: " + currentPath);
-      auto path = paths.find(currentPath);
+      std::shared_ptr<TrajectoryStream> stream;
+      {
+        std::lock_guard<CrossplatformMutex> lock(pathsMutex);
+        stream = std::move(currentStream);
+        currentStream = nullptr;
+      }
+
+      if (stream) {
+        logger->info("AsyncMotionProfileController: Running with streamed path");
+        executeStream(*stream, makeFollowingRate());
+        model->stop();
 
-      if (path == paths.end()) {
+        logger->info("AsyncMotionProfileController: Done moving");
+      } else if (const auto path = waitForPath(currentPath.load(std::memory_order_acquire));
+                 !path) {
         logger->warn(
-          "AsyncMotionProfileController: Target was set to non-existent path with name: " +
-          currentPath);
+          "AsyncMotionProfileController: Target was set to non-existent path with name: %s",
+          [&]() { return getTarget(); });
       } else {
-        logger->debug("AsyncMotionProfileController: Path length is " +
-                      std::to_string(path->second.length));
+        logger->info("AsyncMotionProfileController: Running with path: %s",
+                     [&]() { return getTarget(); });
+        logger->debug("AsyncMotionProfileController: Path length is %d", path->length);
 
-        executeSinglePath(path->second, timeUtil.getRate());
+        executeSinglePath(*path, makeFollowingRate());
         model->stop();
 
         logger->info("AsyncMotionProfileController: Done moving");
       }
 
+      if (isDisabled()) {
+        clearQueue();
+      }
+
       isRunning.store(false, std::memory_order_release);
+      notifySettled();
+    }
+
+    rate->delayUntil(10_ms);
+  }
+}
+
+std::shared_ptr<AsyncMotionProfileController::TrajectoryPair>
+AsyncMotionProfileController::waitForPath(const PathHandle ipath) {
+  auto rate = timeUtil.getRate();
+  bool loggedWait = false;
+
+  while (!isDisabled() && !dtorCalled.load(std::memory_order_acquire)) {
+    std::unique_lock<CrossplatformMutex> lock(pathsMutex);
+    if (auto path = paths.get(ipath)) {
+      // Hold a reference so the path stays alive even if it is removed while being followed
+      return path;
+    } else if (pendingPaths.find(ipath) == pendingPaths.end()) {
+      return nullptr;
+    }
+    lock.unlock();
+
+    if (!loggedWait) {
+      logger->info("AsyncMotionProfileController: Waiting for path to be generated: %s",
+                   [&]() { return paths.getName(ipath); });
+      loggedWait = true;
     }
 
     rate->delayUntil(10_ms);
   }
+
+  return nullptr;
 }
 
 void AsyncMotionProfileController::executeSinglePath(const TrajectoryPair &path,
                                                      std::unique_ptr<AbstractRate> rate) {
+  const double dt = path.left.getDt();
+  // Reserve room for the whole queue up front so chaining paths never allocates while following
+  std::vector<ChainedPath> chain;
+  chain.reserve(maxQueuedPaths + 1);
+  chain.push_back(ChainedPath{&path,
+                              nullptr,
+                              currentPath.load(std::memory_order_acquire),
+                              direction.load(std::memory_order_acquire),
+                              0,
+                              static_cast<double>(path.length - 1) * dt,
+                              samplePath(path, 0),
+                              true});
+  QueuedPath waiting{};
+
+  // The paths are followed as one profile by adding together how far along each path the chassis
+  // should be, in the direction it is followed. Paths which have ended only add a fixed distance,
+  // so they are folded into one target.
+  PathTarget finished{};
+  auto addPath = [](PathTarget &itarget,
+                    const ChainedPath &ipath,
+                    const double itime,
+                    const bool iincludeVelocity) {
+    const PathTarget now =
+      samplePath(*ipath.path, (itime - ipath.start) / ipath.path->left.getDt());
+    const double dir = ipath.direction;
+    auto addSide = [&](SideTarget &iout, const SideTarget &inow, const SideTarget &iorigin) {
+      iout.position += dir * (inow.position - iorigin.position);
+      if (iincludeVelocity) {
+        iout.velocity += dir * inow.velocity;
+        iout.acceleration += dir * inow.acceleration;
+      }
+    };
+
+    addSide(itarget.left, now.left, ipath.origin.left);
+    addSide(itarget.right, now.right, ipath.origin.right);
+    itarget.heading += dir * (now.heading - ipath.origin.heading);
+  };
+
+  FollowerState state;
+  state.dt = outputPeriod > 0_ms ? outputPeriod.convert(second) : dt;
+  TrajectoryPlayback playback(timeUtil.getTimer(), std::move(rate), outputPeriod);
+  playback.play(std::numeric_limits<std::size_t>::max(), dt * second, [&](const double index) {
+    if (isDisabled()) {
+      return false;
+    }
+
+    const double time = index * dt;
+    chainQueuedPath(chain, waiting, time);
+
+    while (chain.size() > 1 && time >= chain.front().end) {
+      addPath(finished, chain.front(), chain.front().end, false);
+      chain.erase(chain.begin());
+    }
+
+    PathTarget target = finished;
+    for (auto &link : chain) {
+      if (time < link.start) {
+        break;
+      }
+
+      if (!link.started) {
+        link.started = true;
+        currentPath.store(link.handle, std::memory_order_release);
+        direction.store(link.direction, std::memory_order_release);
+        logger->info("AsyncMotionProfileController: Moving into queued path: %s",
+                     [&]() { return paths.getName(link.handle); });
+      }
+
+      addPath(target, link, time, true);
+    }
+
+    // Directions were applied per path, so the target is already in the direction to drive
+    followTarget(target, 1, time, state);
+
+    // Keep going while a queued path is still being generated
+    return time < chain.back().end || waiting.path.isValid() || pathQueue.size() > 0;
+  });
+}
+
+void AsyncMotionProfileController::chainQueuedPath(std::vector<ChainedPath> &ichain,
+                                                   QueuedPath &iwaiting,
+                                                   const double itime) {
+  // Leave paths in the queue until there is room in the chain
+  if (ichain.size() > maxQueuedPaths ||
+      (!iwaiting.path.isValid() && !pathQueue.pop(iwaiting))) {
+    return;
+  }
+
+  std::unique_lock<CrossplatformMutex> lock(pathsMutex);
+  const auto next = paths.get(iwaiting.path);
+  if (!next) {
+    if (pendingPaths.find(iwaiting.path) == pendingPaths.end()) {
+      lock.unlock();
+      logger->warn("AsyncMotionProfileController: Skipping queued path which does not exist: %s",
+                   [&]() { return paths.getName(iwaiting.path); });
+      iwaiting = QueuedPath{};
+    }
+
+    return;
+  }
+  lock.unlock();
+
+  const double start = std::max(getChainStart(ichain, *next, iwaiting.direction), itime);
+  ichain.push_back(ChainedPath{next.get(),
+                               next,
+                               iwaiting.path,
+                               iwaiting.direction,
+                               start,
+                               start + static_cast<double>(next->length - 1) * next->left.getDt(),
+                               samplePath(*next, 0)});
+  iwaiting = QueuedPath{};
+}
+
+double AsyncMotionProfileController::getChainStart(const std::vector<ChainedPath> &ichain,
+                                                   const TrajectoryPair &inext,
+                                                   const int idirection) const {
+  using Field = CompactTrajectory::Field;
+  const ChainedPath &last = ichain.back();
+  if (!blending.load(std::memory_order_acquire) || last.direction != idirection) {
+    return last.end;
+  }
+
+  // Without headings there is no way to tell whether the paths meet at an angle
+  const TrajectoryPair &path = *last.path;
+  if (!path.left.hasField(Field::heading) || !inext.left.hasField(Field::heading)) {
+    return last.end;
+  }
+
+  const double headingChange = std::remainder(
+    inext.left.get(Field::heading, 0) - path.left.get(Field::heading, path.length - 1),
+    static_cast<double>(2_pi));
+  if (std::abs(headingChange) > blendHeadingTolerance) {
+    return last.end;
+  }
+
+  // Overlap the last path slowing down with the next path speeding up. Both profiles change speed
+  // at the same rate, so their velocities add up to a constant speed through the overlap.
+  const auto lastEnd = static_cast<std::size_t>(path.length - 1);
+  const std::size_t slowing = std::min(lastEnd - path.left.findPeak(Field::velocity).second,
+                                       lastEnd - path.right.findPeak(Field::velocity).second);
+  const std::size_t speeding = std::min(inext.left.findPeak(Field::velocity).first,
+                                        inext.right.findPeak(Field::velocity).first);
+
+  return last.end - std::min(static_cast<double>(slowing) * path.left.getDt(),
+                             static_cast<double>(speeding) * inext.left.getDt());
+}
+
+void AsyncMotionProfileController::executeStream(TrajectoryStream &stream,
+                                                 std::unique_ptr<AbstractRate> rate) {
   const auto reversed = direction.load(std::memory_order_acquire);
 
-  for (int i = 0; i < path.length && !isDisabled(); ++i) {
-    const auto leftRPM = convertLinearToRotational(path.left[i].velocity * mps).convert(rpm);
-    const auto rightRPM = convertLinearToRotational(path.right[i].velocity * mps).convert(rpm);
+  // The stream does not know its length until it is done, so play until it runs out
+  std::size_t popped = 0;
+  PathTarget target{};
+  FollowerState state;
+  state.dt = outputPeriod > 0_ms ? outputPeriod.convert(second) : stream.dt;
+  auto sample = [&](const double index) {
+    if (isDisabled()) {
+      return false;
+    }
 
-    model->left(leftRPM / toUnderlyingType(pair.internalGearset) * reversed);
-    model->right(rightRPM / toUnderlyingType(pair.internalGearset) * reversed);
+    // Pop up to the segment for the current time. If generation fell behind, keep the last
+    // target until it catches up.
+    bool finished = false;
+    while (static_cast<double>(popped) <= index) {
+      // Check done before popping so the last segments pushed before it was set are not missed
+      const bool done = stream.done.load(std::memory_order_acquire);
+      if (stream.segments.pop(target)) {
+        popped++;
+      } else {
+        finished = done;
+        break;
+      }
+    }
 
-    rate->delayUntil(1_ms);
+    if (popped > 0) {
+      followTarget(target, reversed, index * stream.dt, state);
+    }
+
+    return !finished;
+  };
+
+  TrajectoryPlayback playback(timeUtil.getTimer(), std::move(rate), outputPeriod);
+  playback.play(std::numeric_limits<std::size_t>::max(), stream.dt * second, sample);
+
+  stream.cancelled.store(true, std::memory_order_release);
+}
+
+AsyncMotionProfileController::PathTarget
+AsyncMotionProfileController::samplePath(const TrajectoryPair &ipath, const double iindex) {
+  using Field = CompactTrajectory::Field;
+  return PathTarget{{ipath.left.interpolate(Field::position, iindex),
+                     ipath.left.interpolate(Field::velocity, iindex),
+                     ipath.left.interpolate(Field::acceleration, iindex)},
+                    {ipath.right.interpolate(Field::position, iindex),
+                     ipath.right.interpolate(Field::velocity, iindex),
+                     ipath.right.interpolate(Field::acceleration, iindex)},
+                    ipath.left.interpolate(Field::heading, iindex)};
+}
+
+void AsyncMotionProfileController::followTarget(const PathTarget &itarget,
+                                                const int idirection,
+                                                const double itime,
+                                                FollowerState &istate) {
+  // The gains can be changed from another task, so read them together
+  FollowerGains followerGains;
+  bool isClosedLoop;
+  {
+    std::lock_guard<CrossplatformMutex> lock(gainsMutex);
+    followerGains = gains;
+    isClosedLoop = closedLoop;
+  }
+
+  if (!isClosedLoop) {
+    driveAtVelocities(itarget.left.velocity, itarget.right.velocity, idirection);
+    return;
+  }
+
+  // Use the measured time since the last call so skipped ticks do not inflate the derivative
+  const double dt =
+    istate.started && itime > istate.lastTime ? itime - istate.lastTime : istate.dt;
+  istate.lastTime = itime;
+
+  const auto sensors = model->getSensorVals();
+  if (!istate.started) {
+    istate.started = true;
+    istate.initialLeft = sensors[0];
+    istate.initialRight = sensors[1];
+    istate.initialTarget = itarget;
   }
+
+  // Measure from where the path started, in the direction it is being followed
+  const int leftTicks = idirection * (sensors[0] - istate.initialLeft);
+  const int rightTicks = idirection * (sensors[1] - istate.initialRight);
+
+  const double ticksPerRev = 360 * pair.ratio;
+  const double circumference = scales.wheelDiameter.convert(meter) * static_cast<double>(1_pi);
+  const double leftDistance = static_cast<double>(leftTicks) / ticksPerRev * circumference;
+  const double rightDistance = static_cast<double>(rightTicks) / ticksPerRev * circumference;
+
+  // Pathfinder takes a whole number of ticks per revolution, which would round gear ratios which
+  // are not whole numbers. Instead, the measured distance is taken from the segment and the
+  // encoder reads zero. kV is one because the feedforward is already a velocity.
+  const EncoderConfig config{
+    0, 1, circumference, followerGains.kP, 0, followerGains.kD, 1, followerGains.kA};
+
+  auto followSide = [&](const SideTarget &side,
+                        const SideTarget &initial,
+                        EncoderFollower &follower,
+                        const double distance) {
+    const Segment segment{dt,
+                          0,
+                          0,
+                          side.position - initial.position - distance,
+                          side.velocity,
+                          side.acceleration,
+                          0,
+                          0};
+    // The segment is picked by time instead of by the follower, so always follow segment zero
+    follower.segment = 0;
+    return pathfinder_follow_encoder2(config, &follower, segment, 1, 0);
+  };
+
+  const double leftVel =
+    followSide(itarget.left, istate.initialTarget.left, istate.left, leftDistance);
+  const double rightVel =
+    followSide(itarget.right, istate.initialTarget.right, istate.right, rightDistance);
+
+  const double measuredHeading =
+    (rightDistance - leftDistance) / scales.wheelbaseWidth.convert(meter);
+  const double targetHeading = itarget.heading - istate.initialTarget.heading;
+  const double heading =
+    std::remainder(targetHeading - measuredHeading, static_cast<double>(2_pi));
+  const double turn = followerGains.kTurn * heading;
+
+  positionError.store((istate.left.last_error + istate.right.last_error) / 2);
+  headingError.store(heading);
+
+  driveAtVelocities(leftVel - turn, rightVel + turn, idirection);
+}
+
+void AsyncMotionProfileController::driveAtVelocities(const double ileftVel,
+                                                     const double irightVel,
+                                                     const int idirection) {
+  const auto leftRPM = convertLinearToRotational(ileftVel * mps).convert(rpm);
+  const auto rightRPM = convertLinearToRotational(irightVel * mps).convert(rpm);
+
+  model->left(leftRPM / toUnderlyingType(pair.internalGearset) * idirection);
+  model->right(rightRPM / toUnderlyingType(pair.internalGearset) * idirection);
 }
 
 QAngularSpeed AsyncMotionProfileController::convertLinearToRotational(QSpeed linear) const {
   return (linear * (360_deg / (scales.wheelDiameter * 1_pi))) * pair.ratio;
 }
 
+std::unique_ptr<AbstractRate> AsyncMotionProfileController::makeFollowingRate() const {
+  auto rate = timeUtil.getRate();
+  rate->trackDeadlines(timingStats);
+  return rate;
+}
+
+std::shared_ptr<LoopTimingStats> AsyncMotionProfileController::getTimingStats() const {
+  return timingStats;
+}
+
 void AsyncMotionProfileController::trampoline(void *context) {
   if (context) {
     static_cast<AsyncMotionProfileController *>(context)->loop();
@@ -272,36 +1038,49 @@ void AsyncMotionProfileController::trampoline(void *context) {
 void AsyncMotionProfileController::waitUntilSettled() {
   logger->info("AsyncMotionProfileController: Waiting to settle");
 
-  auto rate = timeUtil.getRate();
-  while (!isSettled()) {
-    rate->delayUntil(10_ms);
-  }
+  // loop() wakes this task up once it finishes following the path
+  std::unique_lock<CrossplatformMutex> lock(settledMutex);
+  settledCondition.wait(lock, [&]() { return isSettled(); });
 
   logger->info("AsyncMotionProfileController: Done waiting to settle");
 }
 
 void AsyncMotionProfileController::moveTo(std::initializer_list<Point> iwaypoints) {
-  std::string name = reinterpret_cast<const char *>(this); // hmmmm...
-  generatePath(iwaypoints, name);
-  setTarget(name);
+  if (iwaypoints.size() == 0) {
+    // No point in generating a path
+    logger->warn(
+      "AsyncMotionProfileController: Not generating a path because no waypoints were given.");
+    return;
+  }
+
+  if (!cache) {
+    streamPath(toWaypoints(iwaypoints));
+    return;
+  }
+
+  const PathHandle path = generatePath(iwaypoints);
+  setTarget(path);
   waitUntilSettled();
-  removePath(name);
+  removePath(path);
 }
 
 Point AsyncMotionProfileController::getError() const {
-  return Point{0_m, 0_m, 0_deg};
+  return Point{positionError.load() * meter, 0_m, headingError.load() * radian};
 }
 
 bool AsyncMotionProfileController::isSettled() {
-  return isDisabled() || !isRunning.load(std::memory_order_acquire);
+  // Check the queue first because loop() marks the controller as running before popping from it
+  return isDisabled() ||
+         (pathQueue.size() == 0 && !isRunning.load(std::memory_order_acquire));
 }
 
 void AsyncMotionProfileController::reset() {
-  // Interrupt executeSinglePath() by disabling the controller
+  // Interrupt executeSinglePath() or executeStream() by disabling the controller
   flipDisable(true);
 
+  // loop() drops the queued paths while the controller is disabled
   auto rate = timeUtil.getRate();
-  while (isRunning.load(std::memory_order_acquire)) {
+  while (isRunning.load(std::memory_order_acquire) || pathQueue.size() > 0) {
     rate->delayUntil(1_ms);
   }
 
@@ -313,10 +1092,16 @@ void AsyncMotionProfileController::flipDisable() {
 }
 
 void AsyncMotionProfileController::flipDisable(const bool iisDisabled) {
-  logger->info("AsyncMotionProfileController: flipDisable " + std::to_string(iisDisabled));
+  logger->info("AsyncMotionProfileController: flipDisable %d", iisDisabled);
   disabled.store(iisDisabled, std::memory_order_release);
-  // loop() will stop the chassis when executeSinglePath() is done
-  // the default implementation of executeSinglePath() breaks when disabled
+  notifySettled();
+  // loop() will stop the chassis when executeSinglePath() or executeStream() is done
+  // the default implementations of executeSinglePath() and executeStream() break when disabled
+}
+
+void AsyncMotionProfileController::notifySettled() {
+  std::lock_guard<CrossplatformMutex> lock(settledMutex);
+  settledCondition.notifyAll();
 }
 
 bool AsyncMotionProfileController::isDisabled() const {
@@ -27,7 +27,7 @@ AsyncPosIntegratedController::AsyncPosIntegratedController(
 }
 
 void AsyncPosIntegratedController::setTarget(const double itarget) {
-  logger->info("AsyncPosIntegratedController: Set target to " + std::to_string(itarget));
+  logger->info("AsyncPosIntegratedController: Set target to %f", itarget);
 
   hasFirstTarget = true;
 
@@ -61,9 +61,13 @@ void AsyncPosIntegratedController::flipDisable() {
 }
 
 void AsyncPosIntegratedController::flipDisable(const bool iisDisabled) {
-  logger->info("AsyncPosIntegratedController: flipDisable " + std::to_string(iisDisabled));
+  logger->info("AsyncPosIntegratedController: flipDisable %d", iisDisabled);
   controllerIsDisabled = iisDisabled;
   resumeMovement();
+
+  // Wake waitUntilSettled() so it sees the controller was disabled
+  std::lock_guard<CrossplatformMutex> lock(settledMutex);
+  settledCondition.notifyAll();
 }
 
 bool AsyncPosIntegratedController::isDisabled() const {
@@ -83,8 +87,10 @@ void AsyncPosIntegratedController::resumeMovement() {
 void AsyncPosIntegratedController::waitUntilSettled() {
   logger->info("AsyncPosIntegratedController: Waiting to settle");
 
-  while (!isSettled()) {
-    rate->delayUntil(motorUpdateRate);
+  // The motor runs its own control loop and only reports its position every motorUpdateRate, so
+  // check whether it settled that often. Disabling the controller wakes this task straight away.
+  std::unique_lock<CrossplatformMutex> lock(settledMutex);
+  while (!settledCondition.waitFor(lock, motorUpdateRate, [&]() { return isSettled(); })) {
   }
 
   logger->info("AsyncPosIntegratedController: Done waiting to settle");
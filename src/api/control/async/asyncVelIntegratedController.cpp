@@ -16,7 +16,7 @@ AsyncVelIntegratedController::AsyncVelIntegratedController(
 }
 
 void AsyncVelIntegratedController::setTarget(const double itarget) {
-  logger->info("AsyncVelIntegratedController: Set target to " + std::to_string(itarget));
+  logger->info("AsyncVelIntegratedController: Set target to %f", itarget);
 
   hasFirstTarget = true;
 
@@ -50,7 +50,7 @@ void AsyncVelIntegratedController::flipDisable() {
 }
 
 void AsyncVelIntegratedController::flipDisable(const bool iisDisabled) {
-  logger->info("AsyncVelIntegratedController: flipDisable " + std::to_string(iisDisabled));
+  logger->info("AsyncVelIntegratedController: flipDisable %d", iisDisabled);
   controllerIsDisabled = iisDisabled;
   resumeMovement();
 }
@@ -42,7 +42,7 @@ IterativePosPIDController::IterativePosPIDController(const Gains &igains,
 }
 
 void IterativePosPIDController::setTarget(const double itarget) {
-  logger->info("IterativePosPIDController: Set target to " + std::to_string(itarget));
+  logger->info("IterativePosPIDController: Set target to %f", itarget);
   target = itarget;
 }
 
@@ -148,12 +148,21 @@ double IterativePosPIDController::step(const double inewReading) {
       loopDtTimer->clearHardMark(); // Important that we only clear if dt >= sampleTime
 
       settledUtil->isSettled(error);
+
+      if (telemetry) {
+        telemetry->record(
+          target, inewReading, error, kP * error, integral, -kD * derivative, output);
+      }
     }
   }
 
   return output;
 }
 
+void IterativePosPIDController::setTelemetryRecorder(std::shared_ptr<TelemetryRecorder> irecorder) {
+  telemetry = std::move(irecorder);
+}
+
 void IterativePosPIDController::setGains(const double ikP,
                                          const double ikI,
                                          const double ikD,
@@ -184,7 +193,7 @@ void IterativePosPIDController::flipDisable() {
 }
 
 void IterativePosPIDController::flipDisable(const bool iisDisabled) {
-  logger->info("IterativePosPIDController: flipDisable " + std::to_string(iisDisabled));
+  logger->info("IterativePosPIDController: flipDisable %d", iisDisabled);
   controllerIsDisabled = iisDisabled;
 }
 
@@ -70,7 +70,8 @@ double IterativeVelPIDController::step(const double inewReading) {
   if (!controllerIsDisabled) {
     loopDtTimer->placeHardMark();
 
-    if (loopDtTimer->getDtFromHardMark() >= sampleTime) {
+    const bool stepped = loopDtTimer->getDtFromHardMark() >= sampleTime;
+    if (stepped) {
       error = getError();
 
       // Derivative over measurement to eliminate derivative kick on setpoint change
@@ -86,6 +87,17 @@ double IterativeVelPIDController::step(const double inewReading) {
 
     output =
       std::clamp(outputSum + kF * target + kSF * std::copysign(1.0, target), outputMin, outputMax);
+
+    if (stepped && telemetry) {
+      telemetry->record(target,
+                        velMath->getVelocity().convert(rpm),
+                        error,
+                        kP * error,
+                        outputSum,
+                        -kD * derivative,
+                        output);
+    }
+
     return output;
   }
 
@@ -93,7 +105,7 @@ double IterativeVelPIDController::step(const double inewReading) {
 }
 
 void IterativeVelPIDController::setTarget(const double itarget) {
-  logger->info("IterativeVelPIDController: Set target to " + std::to_string(itarget));
+  logger->info("IterativeVelPIDController: Set target to %f", itarget);
   target = itarget;
 }
 
@@ -138,7 +150,7 @@ void IterativeVelPIDController::flipDisable() {
 }
 
 void IterativeVelPIDController::flipDisable(const bool iisDisabled) {
-  logger->info("IterativeVelPIDController: flipDisable " + std::to_string(iisDisabled));
+  logger->info("IterativeVelPIDController: flipDisable %d", iisDisabled);
   controllerIsDisabled = iisDisabled;
 }
 
@@ -154,6 +166,10 @@ QAngularSpeed IterativeVelPIDController::getVel() const {
   return velMath->getVelocity();
 }
 
+void IterativeVelPIDController::setTelemetryRecorder(std::shared_ptr<TelemetryRecorder> irecorder) {
+  telemetry = std::move(irecorder);
+}
+
 QTime IterativeVelPIDController::getSampleTime() const {
   return sampleTime;
 }
@@ -0,0 +1,208 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/compactTrajectory.hpp"
+#include "okapi/api/util/mathUtil.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace okapi {
+CompactTrajectory::CompactTrajectory(const std::size_t ilength,
+                                     const double idt,
+                                     const Format &iformat)
+  : length(ilength),
+    dt(idt),
+    format(iformat),
+    storage(new std::uint8_t[getMemoryUsage(ilength, iformat)],
+            std::default_delete<std::uint8_t[]>()) {
+  assignColumns();
+}
+
+CompactTrajectory::CompactTrajectory(const Segment *isegments,
+                                     const std::size_t ilength,
+                                     const Format &iformat)
+  : CompactTrajectory(ilength, ilength > 0 ? isegments[0].dt : 0, iformat) {
+  for (std::size_t i = 0; i < ilength; i++) {
+    set(i, isegments[i]);
+  }
+}
+
+CompactTrajectory::CompactTrajectory(std::shared_ptr<std::uint8_t> istorage,
+                                     const std::size_t ilength,
+                                     const double idt,
+                                     const Format &iformat)
+  : length(ilength), dt(idt), format(iformat), storage(std::move(istorage)) {
+  assignColumns();
+}
+
+CompactTrajectory::CompactTrajectory(CompactTrajectory &&other) noexcept
+  : length(other.length),
+    dt(other.dt),
+    format(other.format),
+    storage(std::move(other.storage)),
+    columns(other.columns) {
+  other.length = 0;
+  other.columns.fill(nullptr);
+}
+
+CompactTrajectory &CompactTrajectory::operator=(CompactTrajectory &&other) noexcept {
+  length = other.length;
+  dt = other.dt;
+  format = other.format;
+  storage = std::move(other.storage);
+  columns = other.columns;
+  other.length = 0;
+  other.columns.fill(nullptr);
+  return *this;
+}
+
+void CompactTrajectory::set(const std::size_t i, const Segment &isegment) {
+  const std::array<double, numFields> values{isegment.x,
+                                             isegment.y,
+                                             isegment.position,
+                                             isegment.velocity,
+                                             isegment.acceleration,
+                                             isegment.jerk,
+                                             isegment.heading};
+
+  for (std::size_t field = 0; field < numFields; field++) {
+    if (columns[field] == nullptr) {
+      continue;
+    }
+
+    if (format.precision == Precision::float32) {
+      static_cast<float *>(columns[field])[i] = static_cast<float>(values[field]);
+    } else {
+      static_cast<double *>(columns[field])[i] = values[field];
+    }
+  }
+}
+
+double CompactTrajectory::get(const Field ifield, const std::size_t i) const {
+  const void *column = columns[fieldIndex(ifield)];
+
+  if (column == nullptr) {
+    return 0;
+  } else if (format.precision == Precision::float32) {
+    return static_cast<const float *>(column)[i];
+  } else {
+    return static_cast<const double *>(column)[i];
+  }
+}
+
+double CompactTrajectory::interpolate(const Field ifield, const double iindex) const {
+  if (length == 0) {
+    return 0;
+  } else if (!(iindex > 0)) {
+    return get(ifield, 0);
+  } else if (iindex >= static_cast<double>(length - 1)) {
+    return get(ifield, length - 1);
+  }
+
+  const auto i = static_cast<std::size_t>(iindex);
+  const double fraction = iindex - static_cast<double>(i);
+  if (ifield == Field::heading) {
+    // Headings wrap, so turn the short way between them instead of all the way around
+    return get(ifield, i) + std::remainder(get(ifield, i + 1) - get(ifield, i), 2 * pi) * fraction;
+  }
+
+  return get(ifield, i) + (get(ifield, i + 1) - get(ifield, i)) * fraction;
+}
+
+Segment CompactTrajectory::getSegment(const std::size_t i) const {
+  return Segment{dt,
+                 get(Field::x, i),
+                 get(Field::y, i),
+                 get(Field::position, i),
+                 get(Field::velocity, i),
+                 get(Field::acceleration, i),
+                 get(Field::jerk, i),
+                 get(Field::heading, i)};
+}
+
+std::pair<std::size_t, std::size_t> CompactTrajectory::findPeak(const Field ifield) const {
+  double peak = 0;
+  for (std::size_t i = 0; i < length; i++) {
+    peak = std::max(peak, std::abs(get(ifield, i)));
+  }
+
+  // Cruising segments are not all exactly equal, so allow a little slack
+  const double threshold = peak * (1 - 1e-3);
+  std::size_t first = 0;
+  while (first + 1 < length && std::abs(get(ifield, first)) < threshold) {
+    first++;
+  }
+
+  std::size_t last = length == 0 ? 0 : length - 1;
+  while (last > first && std::abs(get(ifield, last)) < threshold) {
+    last--;
+  }
+
+  return {first, last};
+}
+
+bool CompactTrajectory::hasField(const Field ifield) const {
+  return (format.fields & toUnderlyingType(ifield)) != 0;
+}
+
+std::size_t CompactTrajectory::size() const {
+  return length;
+}
+
+double CompactTrajectory::getDt() const {
+  return dt;
+}
+
+const CompactTrajectory::Format &CompactTrajectory::getFormat() const {
+  return format;
+}
+
+const std::uint8_t *CompactTrajectory::getData() const {
+  return storage.get();
+}
+
+std::size_t CompactTrajectory::getMemoryUsage() const {
+  return getMemoryUsage(length, format);
+}
+
+std::size_t CompactTrajectory::getMemoryUsage(const std::size_t ilength, const Format &iformat) {
+  return ilength * fieldCount(iformat.fields) * elementSize(iformat.precision);
+}
+
+void CompactTrajectory::assignColumns() {
+  // Columns are laid out back to back in one allocation, in field order
+  std::uint8_t *column = storage.get();
+  for (std::size_t i = 0; i < numFields; i++) {
+    if (format.fields & (1 << i)) {
+      columns[i] = column;
+      column += length * elementSize(format.precision);
+    }
+  }
+}
+
+std::size_t CompactTrajectory::fieldIndex(const Field ifield) {
+  std::size_t index = 0;
+  while ((toUnderlyingType(ifield) >> index) != 1) {
+    index++;
+  }
+  return index;
+}
+
+std::size_t CompactTrajectory::elementSize(const Precision iprecision) {
+  return iprecision == Precision::float32 ? sizeof(float) : sizeof(double);
+}
+
+std::size_t CompactTrajectory::fieldCount(const std::uint8_t ifields) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < numFields; i++) {
+    if (ifields & (1 << i)) {
+      count++;
+    }
+  }
+  return count;
+}
+} // namespace okapi
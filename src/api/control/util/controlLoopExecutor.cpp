@@ -0,0 +1,117 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/controlLoopExecutor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace okapi {
+ControlLoopExecutor::ControlLoopExecutor(const TimeUtil &itimeUtil, const QTime ibasePeriod)
+  : logger(Logger::instance()), basePeriod(ibasePeriod), rate(itimeUtil.getRate()) {
+  if (basePeriod.convert(millisecond) < 1) {
+    logger->error("ControlLoopExecutor: The base period must be at least 1 ms.");
+    throw std::invalid_argument("ControlLoopExecutor: The base period must be at least 1 ms.");
+  }
+
+  rate->trackDeadlines(LoopTimingStats::withMissWarning("ControlLoopExecutor"));
+}
+
+ControlLoopExecutor::~ControlLoopExecutor() {
+  dtorCalled.store(true, std::memory_order_release);
+  delete task;
+}
+
+std::uint32_t ControlLoopExecutor::add(const QTime iperiod, std::function<void()> istep) {
+  const std::uint32_t periodTicks = toTicks(iperiod);
+
+  std::lock_guard<CrossplatformMutex> lock(loopsMutex);
+  const std::uint32_t id = nextId++;
+  loops.push_back(ControlLoop{id, periodTicks, std::move(istep)});
+  return id;
+}
+
+void ControlLoopExecutor::setPeriod(const std::uint32_t iid, const QTime iperiod) {
+  const std::uint32_t periodTicks = toTicks(iperiod);
+
+  std::lock_guard<CrossplatformMutex> lock(loopsMutex);
+  for (auto &loop : loops) {
+    if (loop.id == iid) {
+      loop.periodTicks = periodTicks;
+    }
+  }
+}
+
+void ControlLoopExecutor::remove(const std::uint32_t iid) {
+  std::lock_guard<CrossplatformMutex> lock(loopsMutex);
+  loops.erase(std::remove_if(loops.begin(),
+                             loops.end(),
+                             [&](const ControlLoop &loop) { return loop.id == iid; }),
+              loops.end());
+}
+
+void ControlLoopExecutor::tick() {
+  std::lock_guard<CrossplatformMutex> lock(loopsMutex);
+  for (const auto &loop : loops) {
+    if (ticks % loop.periodTicks == 0) {
+      loop.step();
+    }
+  }
+
+  ticks++;
+}
+
+QTime ControlLoopExecutor::getBasePeriod() const {
+  return basePeriod;
+}
+
+std::shared_ptr<LoopTimingStats> ControlLoopExecutor::getTimingStats() const {
+  return rate->getTimingStats();
+}
+
+std::size_t ControlLoopExecutor::size() const {
+  std::lock_guard<CrossplatformMutex> lock(loopsMutex);
+  return loops.size();
+}
+
+void ControlLoopExecutor::startThread() {
+  if (!task) {
+    task = new CrossplatformThread(trampoline, this, CrossplatformThread::maxPriority - 1);
+  }
+}
+
+void ControlLoopExecutor::trampoline(void *context) {
+  if (context) {
+    static_cast<ControlLoopExecutor *>(context)->loop();
+  }
+}
+
+void ControlLoopExecutor::loop() {
+  while (!dtorCalled.load(std::memory_order_acquire)) {
+    tick();
+    rate->delayUntil(basePeriod);
+  }
+}
+
+std::uint32_t ControlLoopExecutor::toTicks(const QTime iperiod) const {
+  const double ratio = iperiod.convert(millisecond) / basePeriod.convert(millisecond);
+  const double periodTicks = std::round(ratio);
+
+  // Periods converted through QTime are not exact, so allow a little slack
+  if (periodTicks < 1 || std::abs(ratio - periodTicks) > 1e-6) {
+    const std::string msg = "ControlLoopExecutor: The period " +
+                            std::to_string(iperiod.convert(millisecond)) +
+                            " ms is not a multiple of the base period.";
+    logger->error(msg);
+    throw std::invalid_argument(msg);
+  }
+
+  return static_cast<std::uint32_t>(periodTicks);
+}
+} // namespace okapi
@@ -13,6 +13,10 @@
 #include <utility>
 
 namespace okapi {
+static double torqueDueToGravity(const double iangle, const double imass, const double ilinkLen) {
+  return (ilinkLen * std::cos(iangle)) * (imass * -1 * gravity);
+}
+
 FlywheelSimulator::FlywheelSimulator(const double imass,
                                      const double ilinkLen,
                                      const double imuStatic,
@@ -24,9 +28,7 @@ FlywheelSimulator::FlywheelSimulator(const double imass,
     muDynamic(imuDynamic),
     timestep(itimestep),
     I(mass * ipow(linkLen, 2)),
-    torqueFunc([](double iiangle, double iimass, double iilinkLen) {
-      return (iilinkLen * std::cos(iiangle)) * (iimass * -1 * gravity);
-    }) {
+    torqueFunc(torqueDueToGravity) {
 }
 
 FlywheelSimulator::~FlywheelSimulator() = default;
@@ -40,28 +42,92 @@ double FlywheelSimulator::step(const double itorque) {
   return stepImpl();
 }
 
+double FlywheelSimulator::stepN(const std::size_t isteps) {
+  return advance(isteps);
+}
+
+double FlywheelSimulator::simulateUntil(const double itime) {
+  if (itime <= time) {
+    return angle;
+  }
+
+  // Allow a little slack so rounding in the simulated time does not add a step
+  const double steps = std::ceil((itime - time) / timestep - 1e-6);
+  return advance(static_cast<std::size_t>(steps));
+}
+
 double FlywheelSimulator::stepImpl() {
-  double torqueTotal = inputTorque + torqueFunc(angle, mass, linkLen);
+  return advance(1);
+}
 
-  if (omega == 0 && muStatic > std::fabs(torqueTotal)) {
-    torqueTotal = 0;
+double FlywheelSimulator::advance(const std::size_t isteps) {
+  if (gravityTorque) {
+    advance(isteps, torqueDueToGravity);
+  } else if (torqueFunc) {
+    advance(isteps, torqueFunc);
+  } else {
+    advance(isteps, [](double, double, double) { return 0.0; });
   }
 
-  if (omega != 0) {
-    if (torqueTotal > 0) {
-      torqueTotal -= muDynamic * omega;
-    } else {
-      torqueTotal += muDynamic * omega * -1;
+  return angle;
+}
+
+template <typename TorqueFunc>
+void FlywheelSimulator::advance(const std::size_t isteps, const TorqueFunc &iexternalTorque) {
+  const auto accelAt = [&](const double iangle, const double iomega) {
+    double torqueTotal = inputTorque + iexternalTorque(iangle, mass, linkLen);
+
+    if (iomega == 0 && muStatic > std::fabs(torqueTotal)) {
+      torqueTotal = 0;
     }
-  }
 
-  accel = torqueTotal / I;
-  omega += accel * ipow(timestep, 2);
+    torqueTotal -= muDynamic * iomega;
+    return torqueTotal / I;
+  };
+
+  const double halfStep = timestep / 2;
 
-  if (omega != 0) {
-    angle += omega * timestep;
+  switch (integrator) {
+  case Integrator::euler:
+    for (std::size_t i = 0; i < isteps; i++) {
+      accel = accelAt(angle, omega);
+      omega += accel * ipow(timestep, 2);
+      angle += omega * timestep;
+      applyHardStops();
+    }
+    break;
+
+  case Integrator::semiImplicitEuler:
+    for (std::size_t i = 0; i < isteps; i++) {
+      accel = accelAt(angle, omega);
+      omega += accel * timestep;
+      angle += omega * timestep;
+      applyHardStops();
+    }
+    break;
+
+  case Integrator::rk4:
+    for (std::size_t i = 0; i < isteps; i++) {
+      const double a1 = accelAt(angle, omega);
+      const double w2 = omega + a1 * halfStep;
+      const double a2 = accelAt(angle + omega * halfStep, w2);
+      const double w3 = omega + a2 * halfStep;
+      const double a3 = accelAt(angle + w2 * halfStep, w3);
+      const double w4 = omega + a3 * timestep;
+      const double a4 = accelAt(angle + w3 * timestep, w4);
+
+      accel = (a1 + 2 * a2 + 2 * a3 + a4) / 6;
+      angle += (omega + 2 * w2 + 2 * w3 + w4) / 6 * timestep;
+      omega += accel * timestep;
+      applyHardStops();
+    }
+    break;
   }
 
+  time += static_cast<double>(isteps) * timestep;
+}
+
+void FlywheelSimulator::applyHardStops() {
   if (radianToDegree * angle > 181) {
     angle = pi;
     omega = 0;
@@ -71,13 +137,12 @@ double FlywheelSimulator::stepImpl() {
     angle = 0;
     omega = 0;
   }
-
-  return angle;
 }
 
 void FlywheelSimulator::setExternalTorqueFunction(
   std::function<double(double, double, double)> itorqueFunc) {
   torqueFunc = std::move(itorqueFunc);
+  gravityTorque = false;
 }
 
 void FlywheelSimulator::setTorque(const double itorque) {
@@ -128,8 +193,12 @@ void FlywheelSimulator::setDynamicFriction(const double imuDynamic) {
   }
 }
 
+void FlywheelSimulator::setIntegrator(const Integrator iintegrator) {
+  integrator = iintegrator;
+}
+
 void FlywheelSimulator::setTimestep(const double itimestep) {
-  if (timestep < minTimestep) {
+  if (itimestep < minTimestep) {
     timestep = minTimestep;
   } else {
     timestep = itimestep;
@@ -151,4 +220,8 @@ double FlywheelSimulator::getAcceleration() const {
 double FlywheelSimulator::getMaxTorque() const {
   return maxTorque;
 }
+
+double FlywheelSimulator::getTime() const {
+  return time;
+}
 } // namespace okapi
@@ -0,0 +1,45 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/pathFuture.hpp"
+#include <stdexcept>
+
+namespace okapi {
+PathFuture::State::State(std::string ipathId) : pathId(std::move(ipathId)) {
+}
+
+PathFuture::PathFuture(std::shared_ptr<State> istate, const TimeUtil &itimeUtil)
+  : state(std::move(istate)), timeUtil(itimeUtil) {
+}
+
+PathFuture::Status PathFuture::getStatus() const {
+  return state->status.load(std::memory_order_acquire);
+}
+
+bool PathFuture::isDone() const {
+  return getStatus() != Status::pending;
+}
+
+void PathFuture::wait() const {
+  auto rate = timeUtil.getRate();
+  while (!isDone()) {
+    rate->delayUntil(10_ms);
+  }
+}
+
+void PathFuture::get() const {
+  wait();
+
+  if (getStatus() == Status::failed) {
+    throw std::runtime_error(state->error);
+  }
+}
+
+const std::string &PathFuture::getPathId() const {
+  return state->pathId;
+}
+} // namespace okapi
@@ -7,10 +7,14 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include "okapi/api/control/util/pidTuner.hpp"
+#include "okapi/api/util/mathUtil.hpp"
+#include "okapi/api/util/virtualClock.hpp"
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <limits>
 #include <random>
+#include <stdexcept>
 
 namespace okapi {
 PIDTuner::PIDTuner(const std::shared_ptr<ControllerInput<double>> &iinput,
@@ -44,18 +48,180 @@ PIDTuner::PIDTuner(const std::shared_ptr<ControllerInput<double>> &iinput,
     numIterations(inumIterations),
     numParticles(inumParticles),
     kSettle(ikSettle),
-    kITAE(ikITAE) {
+    kITAE(ikITAE),
+    seed(std::random_device{}()) {
   input = iinput;
 }
 
 PIDTuner::~PIDTuner() = default;
 
 PIDTuner::Output PIDTuner::autotune() {
-  std::random_device rd;  // Random seed
-  std::mt19937 gen(rd()); // Mersenne twister
+  // Reverse the goal every test to stay in the same general area
+  bool firstGoal = true;
+  return optimize([&](const std::vector<Output> &igains, std::vector<double> &oerrors) {
+    for (std::size_t index = 0; index < igains.size(); index++) {
+      logger->info("PIDTuner: Test number %zu", index);
+
+      std::int32_t target = goal;
+      if (!firstGoal) {
+        target *= -1;
+      }
+
+      firstGoal = !firstGoal;
+
+      oerrors[index] = runTrial(igains[index],
+                                target,
+                                timeUtil,
+                                *input,
+                                *output,
+                                [&]() { rate->delayUntil(loopDelta); });
+    }
+  });
+}
+
+PIDTuner::Output PIDTuner::autotune(const Supplier<std::unique_ptr<Plant>> &iplantSupplier,
+                                    const std::size_t ithreads) {
+  return optimize([&](const std::vector<Output> &igains, std::vector<double> &oerrors) {
+    parallelFor(igains.size(), ithreads, [&](const std::size_t index) {
+      // Every test gets its own model and clock, so the tests do not affect each other
+      const auto plant = iplantSupplier.get();
+      const auto clock = std::make_shared<VirtualClock>();
+      const auto plantRate = clock->createRate();
+
+      oerrors[index] = runTrial(igains[index],
+                                goal,
+                                clock->createTimeUtil(),
+                                *plant,
+                                *plant,
+                                [&]() {
+                                  plant->step();
+                                  plantRate->delayUntil(loopDelta);
+                                });
+    });
+  });
+}
+
+PIDTuner::RelayResult PIDTuner::relayAutotune(const RelayRule irule,
+                                              const double irelayAmplitude,
+                                              const double ihysteresis,
+                                              const std::size_t icycles,
+                                              const QTime itimeout) {
+  return runRelay(*input,
+                  *output,
+                  [&]() { rate->delayUntil(loopDelta); },
+                  irule,
+                  irelayAmplitude,
+                  ihysteresis,
+                  icycles,
+                  itimeout);
+}
+
+PIDTuner::RelayResult
+PIDTuner::relayAutotune(const Supplier<std::unique_ptr<Plant>> &iplantSupplier,
+                        const RelayRule irule,
+                        const double irelayAmplitude,
+                        const double ihysteresis,
+                        const std::size_t icycles,
+                        const QTime itimeout) {
+  const auto plant = iplantSupplier.get();
+  const auto clock = std::make_shared<VirtualClock>();
+  const auto plantRate = clock->createRate();
+
+  return runRelay(*plant,
+                  *plant,
+                  [&]() {
+                    plant->step();
+                    plantRate->delayUntil(loopDelta);
+                  },
+                  irule,
+                  irelayAmplitude,
+                  ihysteresis,
+                  icycles,
+                  itimeout);
+}
+
+void PIDTuner::setSeed(const std::uint32_t iseed) {
+  seed = iseed;
+}
+
+void PIDTuner::setStrategy(const Strategy istrategy) {
+  strategy = istrategy;
+}
+
+const std::vector<PIDTuner::Trial> &PIDTuner::getTrials() const {
+  return trials;
+}
+
+bool PIDTuner::saveTrials(const std::string &ifilename) const {
+  FILE *file = fopen(ifilename.c_str(), "w");
+  if (file == nullptr) {
+    logger->warn("PIDTuner: Could not open %s for writing", ifilename);
+    return false;
+  }
+
+  bool ok = true;
+  for (const auto &trial : trials) {
+    ok = ok && fprintf(file,
+                       "%.17g %.17g %.17g %.17g\n",
+                       trial.gains.kP,
+                       trial.gains.kI,
+                       trial.gains.kD,
+                       trial.error) > 0;
+  }
+
+  return fclose(file) == 0 && ok;
+}
+
+bool PIDTuner::loadTrials(const std::string &ifilename) {
+  FILE *file = fopen(ifilename.c_str(), "r");
+  if (file == nullptr) {
+    logger->warn("PIDTuner: Could not open %s for reading", ifilename);
+    return false;
+  }
+
+  std::vector<Trial> loaded;
+  Trial trial{};
+  int read;
+  while ((read = fscanf(file,
+                        "%lf %lf %lf %lf",
+                        &trial.gains.kP,
+                        &trial.gains.kI,
+                        &trial.gains.kD,
+                        &trial.error)) == 4) {
+    loaded.push_back(trial);
+  }
+
+  fclose(file);
+  if (read != EOF) {
+    logger->warn("PIDTuner: %s is not a trials file", ifilename);
+    return false;
+  }
+
+  trials.insert(trials.end(), loaded.begin(), loaded.end());
+  return true;
+}
+
+PIDTuner::Output PIDTuner::optimize(const Evaluator &ievaluate) {
+  const auto recorded = [&](const std::vector<Output> &igains, std::vector<double> &oerrors) {
+    ievaluate(igains, oerrors);
+    for (std::size_t i = 0; i < igains.size(); i++) {
+      trials.push_back(Trial{igains[i], oerrors[i]});
+    }
+  };
+
+  switch (strategy) {
+  case Strategy::trustRegion:
+    return optimizeTrustRegion(recorded);
+  case Strategy::particleSwarm:
+  default:
+    return optimizeSwarm(recorded);
+  }
+}
+
+PIDTuner::Output PIDTuner::optimizeSwarm(const Evaluator &ievaluate) {
+  std::mt19937 gen(seed); // Mersenne twister
   std::uniform_real_distribution<double> dist(0, 1);
 
-  IterativePosPIDController testController(0, 0, 0, 0, timeUtil);
   std::vector<ParticleSet> particles;
   for (std::size_t i = 0; i < numParticles; i++) {
     ParticleSet set{};
@@ -81,53 +247,21 @@ PIDTuner::Output PIDTuner::autotune() {
   global.kD.best = 0;
   global.bestError = std::numeric_limits<double>::max();
 
+  std::vector<Output> gains(numParticles);
+  std::vector<double> errors(numParticles);
+
   // Run the optimization
   for (std::size_t iteration = 0; iteration < numIterations; iteration++) {
-    logger->info("PIDTuner: Iteration number " + std::to_string(iteration));
-    bool firstGoal = true;
-
-    for (std::size_t particleIndex = 0; particleIndex < numParticles; particleIndex++) {
-      logger->info("PIDTuner: Particle number " + std::to_string(particleIndex));
-
-      testController.setGains(particles.at(particleIndex).kP.pos,
-                              particles.at(particleIndex).kI.pos,
-                              particles.at(particleIndex).kD.pos);
-
-      // Reverse the goal every iteration to stay in the same general area
-      std::int32_t target = goal;
-      if (!firstGoal) {
-        target *= -1;
-      }
-
-      firstGoal = !firstGoal;
-
-      testController.setTarget(target);
-      const double start_val = input->controllerGet();
-
-      QTime settleTime = 0_ms;
-      double itae = 0;
-      // Test constants then calculate fitness function
-      while (!testController.isSettled()) {
-        settleTime += loopDelta;
-        if (settleTime > timeout)
-          break;
-
-        const double inputVal = input->controllerGet() - start_val;
-        const double outputVal = testController.step(inputVal);
-        const double error = testController.getError();
-        // sum of the error emphasizing later error
-        itae += (settleTime.convert(millisecond) * abs((int)error)) / divisor;
-
-        output->controllerSet(outputVal);
-        rate->delayUntil(loopDelta);
-      }
-
-      output->controllerSet(0);
-      testController.reset();
+    logger->info("PIDTuner: Iteration number %zu", iteration);
+    for (std::size_t i = 0; i < numParticles; i++) {
+      gains[i] = Output{particles[i].kP.pos, particles[i].kI.pos, particles[i].kD.pos};
+    }
 
-      const double error = kSettle * settleTime.convert(millisecond) + kITAE * itae;
+    ievaluate(gains, errors);
 
-      logger->info("PIDTuner: New error is " + std::to_string(error));
+    // Update the bests in order so ties are broken the same way however the errors were found
+    for (std::size_t particleIndex = 0; particleIndex < numParticles; particleIndex++) {
+      const double error = errors[particleIndex];
 
       if (error < particles.at(particleIndex).bestError) {
         particles.at(particleIndex).kP.best = particles.at(particleIndex).kP.pos;
@@ -187,4 +321,266 @@ PIDTuner::Output PIDTuner::autotune() {
 
   return Output{global.kP.best, global.kI.best, global.kD.best};
 }
+
+PIDTuner::Output PIDTuner::optimizeTrustRegion(const Evaluator &ievaluate) {
+  using Point = std::array<double, 3>;
+  constexpr double maxRadius = 0.25;
+  constexpr double minRadius = 1.0 / 64;
+
+  // Search in [0, 1] for each gain so the radius means the same thing for every gain
+  const Point lower{kPMin, kIMin, kDMin};
+  const Point upper{kPMax, kIMax, kDMax};
+  const auto toGains = [&](const Point &ipoint) {
+    Point gains;
+    for (std::size_t i = 0; i < gains.size(); i++) {
+      gains[i] = lower[i] + (upper[i] - lower[i]) * ipoint[i];
+    }
+    return Output{gains[0], gains[1], gains[2]};
+  };
+
+  std::vector<std::size_t> searched;
+  for (std::size_t i = 0; i < lower.size(); i++) {
+    if (upper[i] > lower[i]) {
+      searched.push_back(i);
+    }
+  }
+
+  Point center{0.5, 0.5, 0.5};
+  double radius = maxRadius;
+  if (!trials.empty()) {
+    // Continue from the best gains tested before
+    const auto best =
+      std::min_element(trials.begin(), trials.end(), [](const Trial &a, const Trial &b) {
+        return a.error < b.error;
+      });
+    const Point gains{best->gains.kP, best->gains.kI, best->gains.kD};
+    for (const std::size_t i : searched) {
+      center[i] = std::clamp((gains[i] - lower[i]) / (upper[i] - lower[i]), 0.0, 1.0);
+    }
+
+    radius = maxRadius / 2;
+  }
+
+  std::vector<double> errors(1);
+  ievaluate({toGains(center)}, errors);
+  double centerError = errors[0];
+  std::size_t tests = 1;
+
+  const std::size_t maxTests = numIterations * numParticles;
+  while (radius >= minRadius && tests + 2 * searched.size() + 1 <= maxTests) {
+    // Test two points along each gain. A point past a bound is moved to the other side.
+    std::vector<Point> points;
+    std::vector<std::array<double, 2>> offsets;
+    for (const std::size_t i : searched) {
+      const double a = center[i] + radius > 1 ? -2 * radius : radius;
+      const double b = center[i] - radius < 0 ? 2 * radius : -radius;
+      offsets.push_back({a, b});
+
+      for (const double offset : {a, b}) {
+        Point point = center;
+        point[i] += offset;
+        points.push_back(point);
+      }
+    }
+
+    std::vector<Output> gains;
+    for (const auto &point : points) {
+      gains.push_back(toGains(point));
+    }
+
+    errors.resize(points.size());
+    ievaluate(gains, errors);
+
+    // Model the error along each gain as f0 + g * s + c * s^2 / 2 and step to its minimum
+    Point candidate = center;
+    double predicted = 0;
+    double longestStep = 0;
+    for (std::size_t j = 0; j < searched.size(); j++) {
+      const std::size_t i = searched[j];
+      const double a = offsets[j][0];
+      const double b = offsets[j][1];
+      const double da = errors[2 * j] - centerError;
+      const double db = errors[2 * j + 1] - centerError;
+      const double det = a * b * (b - a);
+      const double g = (da * b * b - db * a * a) / det;
+      const double c = 2 * (a * db - b * da) / det;
+
+      double step = 0;
+      if (c > 0) {
+        step = std::clamp(-g / c, -radius, radius);
+      } else if (g != 0) {
+        step = g > 0 ? -radius : radius;
+      }
+
+      step = std::clamp(center[i] + step, 0.0, 1.0) - center[i];
+      candidate[i] = center[i] + step;
+      predicted -= g * step + c * step * step / 2;
+      longestStep = std::max(longestStep, std::fabs(step));
+    }
+
+    points.push_back(candidate);
+    errors.resize(points.size());
+    std::vector<double> candidateError(1);
+    ievaluate({toGains(candidate)}, candidateError);
+    errors.back() = candidateError[0];
+    tests += points.size();
+
+    const double ratio = predicted > 0 ? (centerError - candidateError[0]) / predicted : 0;
+
+    // Move to the best point tested, even if the model did not predict it
+    const auto best = std::min_element(errors.begin(), errors.end());
+    if (*best < centerError) {
+      center = points[best - errors.begin()];
+      centerError = *best;
+    }
+
+    if (ratio >= 0.75 && longestStep >= 0.99 * radius) {
+      radius = std::min(2 * radius, maxRadius);
+    } else if (ratio < 0.25) {
+      radius /= 2;
+    }
+
+    logger->info("PIDTuner: Best error is %f, radius is %f", centerError, radius);
+  }
+
+  return toGains(center);
+}
+
+double PIDTuner::runTrial(const Output &igains,
+                          const std::int32_t itarget,
+                          const TimeUtil &itimeUtil,
+                          ControllerInput<double> &iinput,
+                          ControllerOutput<double> &ioutput,
+                          const std::function<void()> &iwait) const {
+  IterativePosPIDController testController(igains.kP, igains.kI, igains.kD, 0, itimeUtil);
+  testController.setTarget(itarget);
+  const double start_val = iinput.controllerGet();
+
+  QTime settleTime = 0_ms;
+  double itae = 0;
+  // Test constants then calculate fitness function
+  while (!testController.isSettled()) {
+    settleTime += loopDelta;
+    if (settleTime > timeout)
+      break;
+
+    const double inputVal = iinput.controllerGet() - start_val;
+    const double outputVal = testController.step(inputVal);
+    const double error = testController.getError();
+    // sum of the error emphasizing later error
+    itae += (settleTime.convert(millisecond) * abs((int)error)) / divisor;
+
+    ioutput.controllerSet(outputVal);
+    iwait();
+  }
+
+  ioutput.controllerSet(0);
+
+  const double error = kSettle * settleTime.convert(millisecond) + kITAE * itae;
+
+  logger->info("PIDTuner: New error is %f", error);
+
+  return error;
+}
+
+PIDTuner::RelayResult PIDTuner::runRelay(ControllerInput<double> &iinput,
+                                         ControllerOutput<double> &ioutput,
+                                         const std::function<void()> &iwait,
+                                         const RelayRule irule,
+                                         const double irelayAmplitude,
+                                         const double ihysteresis,
+                                         const std::size_t icycles,
+                                         const QTime itimeout) const {
+  if (icycles < 2) {
+    const std::string msg =
+      "PIDTuner: The relay test needs at least 2 cycles, but was given " + std::to_string(icycles);
+    logger->error(msg);
+    throw std::invalid_argument(msg);
+  }
+
+  const double startVal = iinput.controllerGet();
+
+  // Cycles run from one switch to +irelayAmplitude to the next
+  std::vector<QTime> switchTimes;
+  std::vector<double> amplitudes;
+  double maxVal = std::numeric_limits<double>::lowest();
+  double minVal = std::numeric_limits<double>::max();
+  double relayOut = irelayAmplitude;
+
+  QTime time = 0_ms;
+  while (switchTimes.size() <= icycles && time <= itimeout) {
+    const double inputVal = iinput.controllerGet() - startVal;
+    const double error = goal - inputVal;
+    maxVal = std::max(maxVal, inputVal);
+    minVal = std::min(minVal, inputVal);
+
+    if (relayOut > 0 && error < -ihysteresis) {
+      relayOut = -irelayAmplitude;
+    } else if (relayOut < 0 && error > ihysteresis) {
+      relayOut = irelayAmplitude;
+
+      if (!switchTimes.empty()) {
+        amplitudes.push_back((maxVal - minVal) / 2);
+      }
+
+      switchTimes.push_back(time);
+      maxVal = inputVal;
+      minVal = inputVal;
+    }
+
+    ioutput.controllerSet(relayOut);
+    iwait();
+    time += loopDelta;
+  }
+
+  ioutput.controllerSet(0);
+
+  if (switchTimes.size() <= icycles) {
+    logger->warn("PIDTuner: The system did not oscillate %zu times within the timeout", icycles);
+    return RelayResult{{0, 0, 0}, 0, 0_ms};
+  }
+
+  // The first cycle starts from wherever the goal was approached from, so skip it
+  const QTime period = (switchTimes.back() - switchTimes[1]) / static_cast<double>(icycles - 1);
+  double amplitude = 0;
+  for (std::size_t i = 1; i < amplitudes.size(); i++) {
+    amplitude += amplitudes[i];
+  }
+  amplitude /= static_cast<double>(amplitudes.size() - 1);
+
+  if (amplitude <= ihysteresis) {
+    logger->warn("PIDTuner: The oscillations were no larger than the hysteresis");
+    return RelayResult{{0, 0, 0}, 0, 0_ms};
+  }
+
+  // Describing function of a relay with hysteresis
+  const double ultimateGain = 4 * irelayAmplitude /
+                              (pi * std::sqrt(amplitude * amplitude - ihysteresis * ihysteresis));
+  const double periodSec = period.convert(second);
+
+  double kP = 0;
+  double ti = 0;
+  double td = 0;
+  switch (irule) {
+  case RelayRule::zieglerNichols:
+    kP = 0.6 * ultimateGain;
+    ti = periodSec / 2;
+    td = periodSec / 8;
+    break;
+
+  case RelayRule::tyreusLuyben:
+    kP = ultimateGain / 2.2;
+    ti = 2.2 * periodSec;
+    td = periodSec / 6.3;
+    break;
+  }
+
+  // IterativePosPIDController scales kI and kD by its sample time, so undo that here
+  const double dt = loopDelta.convert(second);
+  const Output gains{kP, kP / ti, kP * td / (dt * dt)};
+
+  logger->info("PIDTuner: Ultimate gain is %f, ultimate period is %f s", ultimateGain, periodSec);
+
+  return RelayResult{gains, ultimateGain, period};
+}
 } // namespace okapi
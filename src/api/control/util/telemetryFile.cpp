@@ -0,0 +1,151 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/telemetryFile.hpp"
+#include "okapi/api/util/logging.hpp"
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace okapi {
+namespace {
+constexpr char magic[4] = {'O', 'K', 'T', 'L'};
+
+void putLittleEndian(std::uint8_t *obytes, const std::uint32_t ivalue, const std::size_t isize) {
+  for (std::size_t i = 0; i < isize; i++) {
+    obytes[i] = static_cast<std::uint8_t>(ivalue >> (8 * i));
+  }
+}
+
+std::uint32_t getLittleEndian(const std::uint8_t *ibytes, const std::size_t isize) {
+  std::uint32_t value = 0;
+  for (std::size_t i = 0; i < isize; i++) {
+    value |= static_cast<std::uint32_t>(ibytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+void putFloat(std::uint8_t *obytes, const float ivalue) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &ivalue, sizeof(bits));
+  putLittleEndian(obytes, bits, 4);
+}
+
+float getFloat(const std::uint8_t *ibytes) {
+  const std::uint32_t bits = getLittleEndian(ibytes, 4);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+} // namespace
+
+bool TelemetryFile::write(const std::string &ifilename,
+                          const std::vector<TelemetrySample> &isamples) {
+  FILE *file = fopen(ifilename.c_str(), "wb");
+  if (file == nullptr) {
+    Logger::instance()->warn("TelemetryFile: Could not open %s for writing", ifilename);
+    return false;
+  }
+
+  std::array<std::uint8_t, headerSize> header{};
+  std::memcpy(header.data(), magic, sizeof(magic));
+  putLittleEndian(header.data() + 4, version, 2);
+  putLittleEndian(header.data() + 6, sampleSize, 2);
+  putLittleEndian(header.data() + 8, static_cast<std::uint32_t>(isamples.size()), 4);
+  bool ok = fwrite(header.data(), 1, header.size(), file) == header.size();
+
+  std::array<std::uint8_t, sampleSize> bytes{};
+  for (const auto &sample : isamples) {
+    putLittleEndian(bytes.data(), sample.time, 4);
+    putFloat(bytes.data() + 4, sample.target);
+    putFloat(bytes.data() + 8, sample.reading);
+    putFloat(bytes.data() + 12, sample.error);
+    putFloat(bytes.data() + 16, sample.proportional);
+    putFloat(bytes.data() + 20, sample.integral);
+    putFloat(bytes.data() + 24, sample.derivative);
+    putFloat(bytes.data() + 28, sample.output);
+    ok = ok && fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  }
+
+  ok = fclose(file) == 0 && ok;
+  if (!ok) {
+    Logger::instance()->warn("TelemetryFile: Could not write %s", ifilename);
+  }
+
+  return ok;
+}
+
+bool TelemetryFile::read(const std::string &ifilename, std::vector<TelemetrySample> &osamples) {
+  FILE *file = fopen(ifilename.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  std::array<std::uint8_t, headerSize> header{};
+  if (fread(header.data(), 1, header.size(), file) != header.size() ||
+      std::memcmp(header.data(), magic, sizeof(magic)) != 0 ||
+      getLittleEndian(header.data() + 4, 2) != version ||
+      getLittleEndian(header.data() + 6, 2) != sampleSize) {
+    fclose(file);
+    Logger::instance()->warn("TelemetryFile: %s is not a valid telemetry file", ifilename);
+    return false;
+  }
+
+  const std::uint32_t count = getLittleEndian(header.data() + 8, 4);
+  std::vector<TelemetrySample> samples;
+  std::array<std::uint8_t, sampleSize> bytes{};
+  for (std::uint32_t i = 0; i < count; i++) {
+    if (fread(bytes.data(), 1, bytes.size(), file) != bytes.size()) {
+      fclose(file);
+      Logger::instance()->warn("TelemetryFile: %s is truncated", ifilename);
+      return false;
+    }
+
+    samples.push_back(TelemetrySample{getLittleEndian(bytes.data(), 4),
+                                      getFloat(bytes.data() + 4),
+                                      getFloat(bytes.data() + 8),
+                                      getFloat(bytes.data() + 12),
+                                      getFloat(bytes.data() + 16),
+                                      getFloat(bytes.data() + 20),
+                                      getFloat(bytes.data() + 24),
+                                      getFloat(bytes.data() + 28)});
+  }
+
+  fclose(file);
+  osamples = std::move(samples);
+  return true;
+}
+
+bool TelemetryFile::toCsv(const std::string &ifilename, const std::string &icsvFilename) {
+  std::vector<TelemetrySample> samples;
+  if (!read(ifilename, samples)) {
+    return false;
+  }
+
+  FILE *file = fopen(icsvFilename.c_str(), "w");
+  if (file == nullptr) {
+    Logger::instance()->warn("TelemetryFile: Could not open %s for writing", icsvFilename);
+    return false;
+  }
+
+  fprintf(file, "time_ms,target,reading,error,proportional,integral,derivative,output\n");
+  for (const auto &sample : samples) {
+    fprintf(file,
+            "%lu,%g,%g,%g,%g,%g,%g,%g\n",
+            static_cast<unsigned long>(sample.time),
+            sample.target,
+            sample.reading,
+            sample.error,
+            sample.proportional,
+            sample.integral,
+            sample.derivative,
+            sample.output);
+  }
+
+  return fclose(file) == 0;
+}
+} // namespace okapi
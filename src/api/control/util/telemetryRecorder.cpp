@@ -0,0 +1,83 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/telemetryRecorder.hpp"
+#include "okapi/api/control/util/telemetryFile.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace okapi {
+TelemetryRecorder::TelemetryRecorder(std::unique_ptr<AbstractTimer> itimer,
+                                     const std::size_t icapacity)
+  : timer(std::move(itimer)), samples(std::max<std::size_t>(icapacity, 1)) {
+}
+
+void TelemetryRecorder::record(const double itarget,
+                               const double ireading,
+                               const double ierror,
+                               const double iproportional,
+                               const double iintegral,
+                               const double iderivative,
+                               const double ioutput) {
+  const TelemetrySample sample{static_cast<std::uint32_t>(timer->millis().convert(millisecond)),
+                               static_cast<float>(itarget),
+                               static_cast<float>(ireading),
+                               static_cast<float>(ierror),
+                               static_cast<float>(iproportional),
+                               static_cast<float>(iintegral),
+                               static_cast<float>(iderivative),
+                               static_cast<float>(ioutput)};
+
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  samples[next] = sample;
+  next = (next + 1) % samples.size();
+  if (count < samples.size()) {
+    count++;
+  } else {
+    overwritten++;
+  }
+}
+
+std::vector<TelemetrySample> TelemetryRecorder::getSamples() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  std::vector<TelemetrySample> out;
+  out.reserve(count);
+
+  const std::size_t first = (next + samples.size() - count) % samples.size();
+  for (std::size_t i = 0; i < count; i++) {
+    out.push_back(samples[(first + i) % samples.size()]);
+  }
+
+  return out;
+}
+
+std::size_t TelemetryRecorder::size() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  return count;
+}
+
+std::size_t TelemetryRecorder::capacity() const {
+  return samples.size();
+}
+
+std::uint32_t TelemetryRecorder::getOverwritten() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  return overwritten;
+}
+
+void TelemetryRecorder::clear() {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  next = 0;
+  count = 0;
+  overwritten = 0;
+}
+
+bool TelemetryRecorder::dump(const std::string &ifilename) const {
+  // Copy the samples out first so recording is not blocked while the file is written
+  return TelemetryFile::write(ifilename, getSamples());
+}
+} // namespace okapi
@@ -0,0 +1,118 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryCache.hpp"
+#include "okapi/api/control/util/trajectoryFile.hpp"
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+
+namespace okapi {
+TrajectoryCache::KeyBuilder &TrajectoryCache::KeyBuilder::add(const double ivalue) {
+  addBytes(&ivalue, sizeof(ivalue));
+  return *this;
+}
+
+TrajectoryCache::KeyBuilder &TrajectoryCache::KeyBuilder::add(const std::int64_t ivalue) {
+  addBytes(&ivalue, sizeof(ivalue));
+  return *this;
+}
+
+TrajectoryCache::KeyBuilder &TrajectoryCache::KeyBuilder::add(const std::string_view ivalue) {
+  addBytes(ivalue.data(), ivalue.size());
+  return *this;
+}
+
+std::uint64_t TrajectoryCache::KeyBuilder::get() const {
+  return hash;
+}
+
+void TrajectoryCache::KeyBuilder::addBytes(const void *ibytes, const std::size_t isize) {
+  const auto *bytes = static_cast<const std::uint8_t *>(ibytes);
+  for (std::size_t i = 0; i < isize; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+}
+
+TrajectoryCache::TrajectoryCache(std::string idirectory)
+  : directory(std::move(idirectory)) {
+}
+
+bool TrajectoryCache::load(const std::uint64_t ikey,
+                           const CompactTrajectory::Format &iformat,
+                           std::vector<CompactTrajectory> &otrajectories) {
+  std::vector<CompactTrajectory> trajectories;
+  std::uint64_t id;
+
+  // The key is checked again in case the file was renamed or the key collided with a file that
+  // was not written by a cache
+  if (!TrajectoryFile::read(getFilename(ikey), trajectories, &id, !isVerified(ikey)) ||
+      id != ikey) {
+    setVerified(ikey, false);
+    misses++;
+    return false;
+  }
+
+  setVerified(ikey, true);
+
+  for (auto &trajectory : trajectories) {
+    const auto &format = trajectory.getFormat();
+    if (format.fields != iformat.fields || format.precision != iformat.precision) {
+      CompactTrajectory converted(trajectory.size(), trajectory.getDt(), iformat);
+      for (std::size_t i = 0; i < trajectory.size(); i++) {
+        converted.set(i, trajectory.getSegment(i));
+      }
+      trajectory = std::move(converted);
+    }
+  }
+
+  otrajectories = std::move(trajectories);
+  hits++;
+  return true;
+}
+
+bool TrajectoryCache::store(const std::uint64_t ikey,
+                            std::initializer_list<const CompactTrajectory *> itrajectories) {
+  const bool stored = TrajectoryFile::write(getFilename(ikey), itrajectories, ikey);
+  setVerified(ikey, stored);
+  return stored;
+}
+
+void TrajectoryCache::invalidate(const std::uint64_t ikey) {
+  setVerified(ikey, false);
+  std::remove(getFilename(ikey).c_str());
+}
+
+std::string TrajectoryCache::getFilename(const std::uint64_t ikey) const {
+  char name[32];
+  snprintf(name, sizeof(name), "/%016" PRIx64 ".pft", ikey);
+  return directory + name;
+}
+
+std::size_t TrajectoryCache::getHits() const {
+  return hits.load();
+}
+
+std::size_t TrajectoryCache::getMisses() const {
+  return misses.load();
+}
+
+bool TrajectoryCache::isVerified(const std::uint64_t ikey) {
+  std::lock_guard<CrossplatformMutex> lock(verifiedMutex);
+  return verified.find(ikey) != verified.end();
+}
+
+void TrajectoryCache::setVerified(const std::uint64_t ikey, const bool iverified) {
+  std::lock_guard<CrossplatformMutex> lock(verifiedMutex);
+  if (iverified) {
+    verified.insert(ikey);
+  } else {
+    verified.erase(ikey);
+  }
+}
+} // namespace okapi
@@ -0,0 +1,324 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryFile.hpp"
+#include "okapi/api/util/logging.hpp"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#ifdef THREADS_STD
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace okapi {
+namespace {
+constexpr char magic[4] = {'O', 'K', 'T', 'J'};
+
+bool isLittleEndian() {
+  const std::uint16_t value = 1;
+  std::uint8_t first;
+  std::memcpy(&first, &value, 1);
+  return first == 1;
+}
+
+void putLittleEndian(std::uint8_t *obytes, const std::uint64_t ivalue, const std::size_t isize) {
+  for (std::size_t i = 0; i < isize; i++) {
+    obytes[i] = static_cast<std::uint8_t>(ivalue >> (8 * i));
+  }
+}
+
+std::uint64_t getLittleEndian(const std::uint8_t *ibytes, const std::size_t isize) {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < isize; i++) {
+    value |= static_cast<std::uint64_t>(ibytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+std::uint64_t getBigEndian(const std::uint8_t *ibytes, const std::size_t isize) {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < isize; i++) {
+    value = (value << 8) | ibytes[i];
+  }
+  return value;
+}
+
+/**
+ * Reverses the bytes of every element in place. Only needed on big-endian hosts.
+ */
+void swapElements(std::uint8_t *idata, const std::size_t isize, const std::size_t ielementSize) {
+  for (std::size_t i = 0; i + ielementSize <= isize; i += ielementSize) {
+    for (std::size_t j = 0; j < ielementSize / 2; j++) {
+      std::swap(idata[i + j], idata[i + ielementSize - 1 - j]);
+    }
+  }
+}
+
+std::size_t padToAlignment(const std::size_t isize) {
+  return (isize + TrajectoryFile::alignment - 1) / TrajectoryFile::alignment *
+         TrajectoryFile::alignment;
+}
+
+/**
+ * Maps a whole file into memory. The mapping is private, so writes to it are not written back to
+ * the file. Returns nullptr if the file could not be opened.
+ */
+std::shared_ptr<std::uint8_t> mapFile(const std::string &ifilename, std::size_t &osize) {
+  osize = 0;
+
+#ifdef THREADS_STD
+  const int fd = open(ifilename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  const auto size = static_cast<std::size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+
+  osize = size;
+  return std::shared_ptr<std::uint8_t>(static_cast<std::uint8_t *>(mapping),
+                                       [size](std::uint8_t *ptr) { munmap(ptr, size); });
+#else
+  // There is no mmap on the brain, so read the whole file with one call instead
+  FILE *file = fopen(ifilename.c_str(), "rb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (size <= 0) {
+    fclose(file);
+    return nullptr;
+  }
+
+  std::shared_ptr<std::uint8_t> buffer(new (std::nothrow) std::uint8_t[size],
+                                       std::default_delete<std::uint8_t[]>());
+  if (!buffer || fread(buffer.get(), 1, size, file) != static_cast<std::size_t>(size)) {
+    fclose(file);
+    return nullptr;
+  }
+
+  fclose(file);
+  osize = static_cast<std::size_t>(size);
+  return buffer;
+#endif
+}
+} // namespace
+
+bool TrajectoryFile::write(const std::string &ifilename,
+                           const std::vector<const CompactTrajectory *> &itrajectories,
+                           const std::uint64_t iid) {
+  FILE *file = fopen(ifilename.c_str(), "wb");
+  if (file == nullptr) {
+    Logger::instance()->warn("TrajectoryFile: Could not open %s for writing", ifilename);
+    return false;
+  }
+
+  const std::uint8_t padding[alignment]{};
+  bool valid = true;
+  for (const auto *trajectory : itrajectories) {
+    const auto &format = trajectory->getFormat();
+    const auto size = trajectory->getMemoryUsage();
+    const std::uint8_t *data = trajectory->getData();
+
+    std::unique_ptr<std::uint8_t[]> swapped;
+    if (!isLittleEndian() && size > 0) {
+      swapped.reset(new std::uint8_t[size]);
+      std::memcpy(swapped.get(), data, size);
+      swapElements(swapped.get(),
+                   size,
+                   format.precision == CompactTrajectory::Precision::float32 ? sizeof(float)
+                                                                              : sizeof(double));
+      data = swapped.get();
+    }
+
+    std::uint64_t dtBits;
+    const double dt = trajectory->getDt();
+    std::memcpy(&dtBits, &dt, sizeof(dt));
+
+    std::uint8_t header[headerSize]{};
+    std::memcpy(header, magic, sizeof(magic));
+    putLittleEndian(header + 4, version, 2);
+    putLittleEndian(header + 6, headerSize, 2);
+    putLittleEndian(header + 8, trajectory->size(), 4);
+    header[12] = format.fields;
+    header[13] = format.precision == CompactTrajectory::Precision::float32 ? 1 : 0;
+    putLittleEndian(header + 16, dtBits, 8);
+    putLittleEndian(header + 24, iid, 8);
+    putLittleEndian(header + 32, size, 8);
+    putLittleEndian(header + 40, checksum(data, size), 4);
+
+    valid = valid && fwrite(header, 1, headerSize, file) == headerSize;
+    valid = valid && (size == 0 || fwrite(data, 1, size, file) == size);
+    const std::size_t paddingSize = padToAlignment(size) - size;
+    valid = valid && (paddingSize == 0 || fwrite(padding, 1, paddingSize, file) == paddingSize);
+  }
+
+  valid = fclose(file) == 0 && valid;
+
+  if (!valid) {
+    std::remove(ifilename.c_str());
+    Logger::instance()->warn("TrajectoryFile: Could not write %s", ifilename);
+  }
+
+  return valid;
+}
+
+bool TrajectoryFile::read(const std::string &ifilename,
+                          std::vector<CompactTrajectory> &otrajectories,
+                          std::uint64_t *oid,
+                          const bool iverify) {
+  std::size_t size;
+  const auto mapping = mapFile(ifilename, size);
+  if (!mapping) {
+    return false;
+  }
+
+  std::vector<CompactTrajectory> trajectories;
+  std::uint64_t id = 0;
+  std::size_t offset = 0;
+  bool valid = true;
+  while (valid && offset < size) {
+    std::uint8_t *header = mapping.get() + offset;
+    valid = size - offset >= headerSize && std::memcmp(header, magic, sizeof(magic)) == 0 &&
+            getLittleEndian(header + 4, 2) == version &&
+            getLittleEndian(header + 6, 2) == headerSize &&
+            (header[12] & ~CompactTrajectory::allFields) == 0 && header[13] <= 1;
+    if (!valid) {
+      break;
+    }
+
+    const CompactTrajectory::Format format{header[12],
+                                           header[13] == 1 ? CompactTrajectory::Precision::float32
+                                                           : CompactTrajectory::Precision::float64};
+    const auto length = static_cast<std::size_t>(getLittleEndian(header + 8, 4));
+    const auto dataSize = CompactTrajectory::getMemoryUsage(length, format);
+    std::uint8_t *data = header + headerSize;
+
+    valid = getLittleEndian(header + 32, 8) == dataSize &&
+            size - offset - headerSize >= padToAlignment(dataSize) &&
+            (!iverify || getLittleEndian(header + 40, 4) == checksum(data, dataSize)) &&
+            (trajectories.empty() || getLittleEndian(header + 24, 8) == id);
+    if (!valid) {
+      break;
+    }
+
+    if (!isLittleEndian()) {
+      swapElements(data,
+                   dataSize,
+                   format.precision == CompactTrajectory::Precision::float32 ? sizeof(float)
+                                                                              : sizeof(double));
+    }
+
+    double dt;
+    const std::uint64_t dtBits = getLittleEndian(header + 16, 8);
+    std::memcpy(&dt, &dtBits, sizeof(dt));
+    id = getLittleEndian(header + 24, 8);
+
+    // Share ownership of the whole mapping but point at this trajectory's data
+    trajectories.emplace_back(std::shared_ptr<std::uint8_t>(mapping, data), length, dt, format);
+    offset += headerSize + padToAlignment(dataSize);
+  }
+
+  if (!valid) {
+    Logger::instance()->warn("TrajectoryFile: %s is not a valid trajectory file", ifilename);
+    return false;
+  }
+
+  otrajectories = std::move(trajectories);
+  if (oid != nullptr) {
+    *oid = id;
+  }
+
+  return true;
+}
+
+bool TrajectoryFile::convertLegacy(const std::string &ilegacyFilename,
+                                   const std::string &ifilename,
+                                   const CompactTrajectory::Format &iformat) {
+  std::size_t size;
+  const auto mapping = mapFile(ilegacyFilename, size);
+  if (!mapping) {
+    Logger::instance()->warn("TrajectoryFile: Could not read %s", ilegacyFilename);
+    return false;
+  }
+
+  // pathfinder_serialize writes a big-endian int length, then eight big-endian doubles per segment
+  constexpr std::size_t segmentSize = 8 * sizeof(double);
+  std::vector<CompactTrajectory> trajectories;
+  std::size_t offset = 0;
+  while (offset < size) {
+    const std::uint8_t *bytes = mapping.get() + offset;
+    const auto length =
+      size - offset >= 4 ? static_cast<std::size_t>(getBigEndian(bytes, 4)) : SIZE_MAX;
+    if (length == SIZE_MAX || length > (size - offset - 4) / segmentSize) {
+      Logger::instance()->warn("TrajectoryFile: %s is not a valid pathfinder_serialize file",
+                               ilegacyFilename);
+      return false;
+    }
+
+    bytes += 4;
+    std::array<double, 8> values{};
+    const std::size_t index = trajectories.size();
+    for (std::size_t i = 0; i < length; i++) {
+      for (std::size_t j = 0; j < values.size(); j++) {
+        const std::uint64_t bits = getBigEndian(bytes + i * segmentSize + j * sizeof(double), 8);
+        std::memcpy(&values[j], &bits, sizeof(double));
+      }
+
+      if (i == 0) {
+        // dt is the same for every segment, so take it from the first one
+        trajectories.emplace_back(length, values[0], iformat);
+      }
+
+      trajectories[index].set(
+        i,
+        Segment{
+          values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7]});
+    }
+
+    if (length == 0) {
+      trajectories.emplace_back(std::size_t{0}, 0.0, iformat);
+    }
+
+    offset += 4 + length * segmentSize;
+  }
+
+  std::vector<const CompactTrajectory *> pointers;
+  for (const auto &trajectory : trajectories) {
+    pointers.push_back(&trajectory);
+  }
+
+  return write(ifilename, pointers);
+}
+
+std::uint32_t TrajectoryFile::checksum(const std::uint8_t *idata, const std::size_t isize) {
+  std::uint32_t hash = 2166136261U;
+  for (std::size_t i = 0; i < isize; i++) {
+    hash ^= idata[i];
+    hash *= 16777619U;
+  }
+  return hash;
+}
+} // namespace okapi
@@ -0,0 +1,73 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryPlayback.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace okapi {
+TrajectoryPlayback::TrajectoryPlayback(std::unique_ptr<AbstractTimer> itimer,
+                                       std::unique_ptr<AbstractRate> irate,
+                                       const QTime iperiod)
+  : timer(std::move(itimer)), rate(std::move(irate)), period(iperiod) {
+}
+
+void TrajectoryPlayback::play(const std::size_t ilength,
+                              const QTime idt,
+                              const std::function<bool(double)> &isample) {
+  ticks = 0;
+  skippedTicks = 0;
+
+  if (ilength == 0) {
+    return;
+  }
+
+  // Rates work in whole milliseconds
+  const double dtMs = idt.convert(millisecond);
+  const double periodMs =
+    std::max(1.0, std::round(period > 0_ms ? period.convert(millisecond) : dtMs));
+  const double lastIndex = static_cast<double>(ilength - 1);
+
+  const QTime start = timer->millis();
+  double deadline = 0; // When the current tick was due, relative to start
+  while (true) {
+    const double elapsed = (timer->millis() - start).convert(millisecond);
+    const double index = dtMs > 0 ? std::min(elapsed / dtMs, lastIndex) : lastIndex;
+
+    ticks++;
+    if (!isample(index) || index >= lastIndex) {
+      return;
+    }
+
+    // Wait for the next tick which is still in the future. Deadlines are multiples of the period
+    // from the start, so late ticks do not push back the ones after them.
+    const double sampled = (timer->millis() - start).convert(millisecond);
+    double next = deadline + periodMs;
+    if (next < sampled) {
+      const auto missed = static_cast<std::size_t>((sampled - deadline) / periodMs);
+      skippedTicks += missed;
+
+      // The rate never sees the missed deadline because the wait is lengthened to skip it
+      if (const auto stats = rate->getTimingStats()) {
+        stats->recordMiss((sampled - (deadline + periodMs)) * millisecond);
+      }
+      next = deadline + static_cast<double>(missed + 1) * periodMs;
+    }
+
+    rate->delayUntil(static_cast<std::uint32_t>(next - deadline));
+    deadline = next;
+  }
+}
+
+std::size_t TrajectoryPlayback::getTicks() const {
+  return ticks;
+}
+
+std::size_t TrajectoryPlayback::getSkippedTicks() const {
+  return skippedTicks;
+}
+} // namespace okapi
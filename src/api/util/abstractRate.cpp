@@ -9,4 +9,28 @@
 
 namespace okapi {
 AbstractRate::~AbstractRate() = default;
+
+void AbstractRate::trackDeadlines(std::shared_ptr<LoopTimingStats> istats) {
+  timingStats = std::move(istats);
+}
+
+std::shared_ptr<LoopTimingStats> AbstractRate::getTimingStats() const {
+  return timingStats;
+}
+
+void AbstractRate::recordDelay(const std::uint32_t istart,
+                               const std::uint32_t ideadline,
+                               const std::uint32_t iwoke) {
+  if (!timingStats) {
+    return;
+  }
+
+  // Compare as signed differences so the stats survive the millisecond counter wrapping
+  const auto overrun = static_cast<std::int32_t>(istart - ideadline);
+  if (overrun > 0) {
+    timingStats->recordMiss(overrun * millisecond);
+  }
+
+  timingStats->recordWakeup(static_cast<std::int32_t>(iwoke - ideadline) * millisecond);
 }
+} // namespace okapi
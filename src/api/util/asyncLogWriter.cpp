@@ -0,0 +1,100 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/asyncLogWriter.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace okapi {
+AsyncLogWriter::AsyncLogWriter(FILE *ifile, std::unique_ptr<AbstractRate> irate)
+  : file(ifile), rate(std::move(irate)) {
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+  dtorCalled.store(true, std::memory_order_release);
+  if (task) {
+    // Let the writer task finish its record instead of deleting it partway through a write
+    task->join();
+    delete task;
+  }
+
+  // The writer task is gone, so nothing else is draining
+  drain();
+  fflush(file);
+}
+
+bool AsyncLogWriter::push(const std::uint32_t itime,
+                          const char *ilevelName,
+                          std::string_view imessage) {
+  const bool pushed = queue.pushWith([&](Record &orecord) {
+    orecord.time = itime;
+    orecord.levelName = ilevelName;
+    orecord.length = static_cast<std::uint16_t>(std::min(imessage.size(), maxMessageLength));
+    std::memcpy(orecord.message, imessage.data(), orecord.length);
+  });
+
+  if (!pushed) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return pushed;
+}
+
+void AsyncLogWriter::flush() {
+  std::lock_guard<CrossplatformMutex> lock(drainMutex);
+  drain();
+  fflush(file);
+}
+
+std::uint32_t AsyncLogWriter::getDropped() const {
+  return dropped.load(std::memory_order_relaxed);
+}
+
+void AsyncLogWriter::startThread() {
+  if (!task) {
+    task = new CrossplatformThread(trampoline, this, CrossplatformThread::minPriority);
+  }
+}
+
+void AsyncLogWriter::trampoline(void *context) {
+  if (context) {
+    static_cast<AsyncLogWriter *>(context)->loop();
+  }
+}
+
+void AsyncLogWriter::loop() {
+  while (!dtorCalled.load(std::memory_order_acquire)) {
+    bool wrote;
+    {
+      std::lock_guard<CrossplatformMutex> lock(drainMutex);
+      wrote = drain();
+    }
+
+    // Keep draining while there is a backlog instead of waiting between batches
+    if (!wrote) {
+      rate->delayUntil(10_ms);
+    }
+  }
+}
+
+bool AsyncLogWriter::drain() {
+  bool wrote = false;
+  Record record;
+  while (queue.pop(record)) {
+    fprintf(file,
+            "%ld %s: %.*s\n",
+            static_cast<long>(record.time),
+            record.levelName,
+            static_cast<int>(record.length),
+            record.message);
+    wrote = true;
+  }
+
+  return wrote;
+}
+} // namespace okapi
@@ -6,7 +6,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/asyncLogWriter.hpp"
 #include "okapi/api/util/mathUtil.hpp"
+#include <cstdarg>
 #include <stdio.h>
 
 namespace okapi {
@@ -14,6 +16,30 @@ Logger *Logger::s_instance;
 std::unique_ptr<AbstractTimer> Logger::timer;
 Logger::LogLevel Logger::logLevel;
 FILE *Logger::logfile;
+std::atomic<AsyncLogWriter *> Logger::asyncWriter{nullptr};
+std::atomic_size_t Logger::asyncWriterUsers{0};
+
+namespace {
+/**
+ * Counts the calling task as a user of the async writer while it is in scope.
+ */
+class AsyncWriterUse {
+  public:
+  explicit AsyncWriterUse(std::atomic_size_t &iusers) : users(iusers) {
+    users.fetch_add(1);
+  }
+
+  ~AsyncWriterUse() {
+    users.fetch_sub(1);
+  }
+
+  AsyncWriterUse(const AsyncWriterUse &) = delete;
+  AsyncWriterUse &operator=(const AsyncWriterUse &) = delete;
+
+  private:
+  std::atomic_size_t &users;
+};
+} // namespace
 
 Logger::Logger() = default;
 
@@ -28,6 +54,8 @@ Logger *Logger::instance() noexcept {
 void Logger::initialize(std::unique_ptr<AbstractTimer> itimer,
                         std::string_view filename,
                         Logger::LogLevel level) noexcept {
+  // The writer writes to the old file
+  stopAsyncWriter();
   timer = std::move(itimer);
   logLevel = level;
 
@@ -40,6 +68,7 @@ void Logger::initialize(std::unique_ptr<AbstractTimer> itimer,
 void Logger::initialize(std::unique_ptr<AbstractTimer> itimer,
                         FILE *file,
                         Logger::LogLevel level) noexcept {
+  stopAsyncWriter();
   timer = std::move(itimer);
   logLevel = level;
 
@@ -52,43 +81,117 @@ void Logger::setLogLevel(Logger::LogLevel level) noexcept {
   logLevel = level;
 }
 
-void Logger::debug(std::string_view message) const noexcept {
-  if (toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::info) && logfile && timer) {
-    fprintf(logfile,
-            "%ld DEBUG: %s\n",
-            static_cast<long>(timer->millis().convert(millisecond)),
-            message.data());
+const char *Logger::levelName(const LogLevel ilevel) noexcept {
+  switch (ilevel) {
+  case LogLevel::debug:
+    return "DEBUG";
+  case LogLevel::info:
+    return "INFO";
+  case LogLevel::warn:
+    return "WARN";
+  case LogLevel::error:
+    return "ERROR";
+  default:
+    return "";
+  }
+}
+
+void Logger::startAsyncWriter(std::unique_ptr<AbstractRate> irate) noexcept {
+  if (!logfile || asyncWriter.load()) {
+    return;
+  }
+
+  auto *writer = new AsyncLogWriter(logfile, std::move(irate));
+  AsyncLogWriter *expected = nullptr;
+  if (!asyncWriter.compare_exchange_strong(expected, writer)) {
+    // Another task started a writer first
+    delete writer;
+    return;
+  }
+
+  writer->startThread();
+}
+
+void Logger::stopAsyncWriter() noexcept {
+  AsyncLogWriter *writer = asyncWriter.exchange(nullptr);
+  if (!writer) {
+    return;
   }
+
+  // A task which loaded the writer before the exchange is still counted as a user
+  while (asyncWriterUsers.load() != 0) {
+    CrossplatformThread::yield();
+  }
+
+  delete writer;
 }
 
-void Logger::info(std::string_view message) const noexcept {
-  if (toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::info) && logfile && timer) {
-    fprintf(logfile,
-            "%ld INFO: %s\n",
-            static_cast<long>(timer->millis().convert(millisecond)),
-            message.data());
+void Logger::flush() noexcept {
+  {
+    AsyncWriterUse use(asyncWriterUsers);
+    if (AsyncLogWriter *writer = asyncWriter.load()) {
+      writer->flush();
+      return;
+    }
+  }
+
+  if (logfile) {
+    fflush(logfile);
   }
 }
 
-void Logger::warn(std::string_view message) const noexcept {
-  if (toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::warn) && logfile && timer) {
-    fprintf(logfile,
-            "%ld WARN: %s\n",
-            static_cast<long>(timer->millis().convert(millisecond)),
-            message.data());
+std::uint32_t Logger::getDroppedMessages() noexcept {
+  AsyncWriterUse use(asyncWriterUsers);
+  AsyncLogWriter *writer = asyncWriter.load();
+  return writer ? writer->getDropped() : 0;
+}
+
+void Logger::write(const LogLevel ilevel, std::string_view message) const noexcept {
+  {
+    AsyncWriterUse use(asyncWriterUsers);
+    if (AsyncLogWriter *writer = asyncWriter.load()) {
+      writer->push(static_cast<std::uint32_t>(timer->millis().convert(millisecond)),
+                   levelName(ilevel),
+                   message);
+      return;
+    }
   }
+
+  fprintf(logfile,
+          "%ld %s: %.*s\n",
+          static_cast<long>(timer->millis().convert(millisecond)),
+          levelName(ilevel),
+          static_cast<int>(message.size()),
+          message.data());
 }
 
-void Logger::error(std::string_view message) const noexcept {
-  if (toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::error) && logfile && timer) {
-    fprintf(logfile,
-            "%ld ERROR: %s\n",
-            static_cast<long>(timer->millis().convert(millisecond)),
-            message.data());
+void Logger::writef(const LogLevel ilevel, const char *iformat, ...) const noexcept {
+  // Format into the stack so short messages do not allocate
+  char buffer[256];
+  va_list args;
+  va_start(args, iformat);
+  const int length = vsnprintf(buffer, sizeof(buffer), iformat, args);
+  va_end(args);
+
+  if (length < 0) {
+    return;
+  }
+
+  if (static_cast<std::size_t>(length) < sizeof(buffer)) {
+    write(ilevel, std::string_view(buffer, static_cast<std::size_t>(length)));
+  } else {
+    std::string message(static_cast<std::size_t>(length) + 1, '\0');
+    va_start(args, iformat);
+    vsnprintf(message.data(), message.size(), iformat, args);
+    va_end(args);
+    message.pop_back();
+    write(ilevel, message);
   }
 }
 
 void Logger::close() noexcept {
+  // Stopping the writer writes everything still queued
+  stopAsyncWriter();
   fclose(logfile);
   logfile = nullptr;
 }
@@ -0,0 +1,127 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/loopTimingStats.hpp"
+#include "okapi/api/util/logging.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace okapi {
+LoopTimingStats::LoopTimingStats(std::function<void(QTime)> ionMiss) : onMiss(std::move(ionMiss)) {
+}
+
+std::shared_ptr<LoopTimingStats> LoopTimingStats::withMissWarning(const std::string &iname) {
+  return std::make_shared<LoopTimingStats>([iname](const QTime ilateness) {
+    Logger::instance()->warn(
+      "%s: Missed a loop deadline by %f ms", iname, ilateness.convert(millisecond));
+  });
+}
+
+void LoopTimingStats::recordWakeup(const QTime ilateness) {
+  const double jitter = std::max(0.0, ilateness.convert(millisecond));
+  const auto bucket =
+    std::min(static_cast<std::size_t>(jitter), static_cast<std::size_t>(histogramBuckets - 1));
+
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  histogram[bucket]++;
+  if (wakeups == 0) {
+    minJitter = jitter;
+    maxJitter = jitter;
+  } else {
+    minJitter = std::min(minJitter, jitter);
+    maxJitter = std::max(maxJitter, jitter);
+  }
+
+  jitterSum += jitter;
+  wakeups++;
+}
+
+void LoopTimingStats::recordMiss(const QTime ilateness) {
+  std::function<void(QTime)> callback;
+  {
+    std::lock_guard<CrossplatformMutex> lock(mutex);
+    misses++;
+    callback = onMiss;
+  }
+
+  // Call the callback unlocked so it can read the stats
+  if (callback) {
+    callback(ilateness);
+  }
+}
+
+void LoopTimingStats::setMissCallback(std::function<void(QTime)> ionMiss) {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  onMiss = std::move(ionMiss);
+}
+
+void LoopTimingStats::reset() {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  histogram.fill(0);
+  wakeups = 0;
+  misses = 0;
+  minJitter = 0;
+  maxJitter = 0;
+  jitterSum = 0;
+}
+
+std::uint32_t LoopTimingStats::getWakeups() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  return wakeups;
+}
+
+std::uint32_t LoopTimingStats::getMisses() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  return misses;
+}
+
+QTime LoopTimingStats::getMinJitter() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  return minJitter * millisecond;
+}
+
+QTime LoopTimingStats::getMeanJitter() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  return wakeups == 0 ? 0_ms : (jitterSum / wakeups) * millisecond;
+}
+
+QTime LoopTimingStats::getMaxJitter() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  return maxJitter * millisecond;
+}
+
+QTime LoopTimingStats::getJitterPercentile(const double ifraction) const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  if (wakeups == 0) {
+    return 0_ms;
+  }
+
+  // The number of wakeups which must be at or under the result
+  const auto target = static_cast<std::uint32_t>(
+    std::ceil(std::clamp(ifraction, 0.0, 1.0) * static_cast<double>(wakeups)));
+
+  std::uint32_t count = 0;
+  for (std::size_t i = 0; i < histogramBuckets; i++) {
+    count += histogram[i];
+    if (count >= target && count > 0) {
+      // Bucket i holds jitter in [i, i + 1) ms, except the last bucket which has no upper bound
+      if (i == histogramBuckets - 1) {
+        return maxJitter * millisecond;
+      }
+
+      return std::min(static_cast<double>(i + 1), maxJitter) * millisecond;
+    }
+  }
+
+  return maxJitter * millisecond;
+}
+
+QTime LoopTimingStats::getP99Jitter() const {
+  return getJitterPercentile(0.99);
+}
+} // namespace okapi
@@ -0,0 +1,67 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/parallelFor.hpp"
+#include "okapi/api/coreProsAPI.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace okapi {
+namespace {
+struct ParallelForContext {
+  std::size_t count;
+  const std::function<void(std::size_t)> &body;
+  std::atomic_size_t next{0};
+};
+
+void work(void *context) {
+  auto *ctx = static_cast<ParallelForContext *>(context);
+  for (std::size_t i = ctx->next++; i < ctx->count; i = ctx->next++) {
+    ctx->body(i);
+  }
+}
+} // namespace
+
+std::size_t defaultThreadCount() {
+#ifdef THREADS_STD
+  return std::max(1U, std::thread::hardware_concurrency());
+#else
+  return 1;
+#endif
+}
+
+void parallelFor(const std::size_t icount,
+                 const std::size_t ithreads,
+                 const std::function<void(std::size_t)> &ibody) {
+  ParallelForContext context{icount, ibody};
+
+#ifdef THREADS_STD
+  const std::size_t threadCount = std::min(ithreads, icount);
+  std::vector<std::unique_ptr<CrossplatformThread>> threads;
+  for (std::size_t i = 1; i < threadCount; i++) {
+    threads.push_back(std::make_unique<CrossplatformThread>(work, &context));
+  }
+
+  work(&context);
+  // Destroying the threads joins them
+  threads.clear();
+#else
+  work(&context);
+#endif
+}
+
+void pathfinderParallelFor(const int icount,
+                           void (*ibody)(void *, int),
+                           void *icontext,
+                           void *iuser) {
+  parallelFor(static_cast<std::size_t>(icount),
+              *static_cast<const std::size_t *>(iuser),
+              [&](const std::size_t i) { ibody(icontext, static_cast<int>(i)); });
+}
+} // namespace okapi
@@ -0,0 +1,159 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/virtualClock.hpp"
+#include "okapi/api/control/util/settledUtil.hpp"
+#include <algorithm>
+
+namespace okapi {
+VirtualClock::VirtualClock(const std::size_t iparticipants) : participants(iparticipants) {
+}
+
+QTime VirtualClock::millis() const {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  return now * millisecond;
+}
+
+std::unique_ptr<AbstractTimer> VirtualClock::createTimer() {
+  return std::make_unique<VirtualTimer>(shared_from_this());
+}
+
+std::unique_ptr<AbstractRate> VirtualClock::createRate() {
+  return std::make_unique<VirtualRate>(shared_from_this());
+}
+
+TimeUtil VirtualClock::createTimeUtil(const double iatTargetError,
+                                      const double iatTargetDerivative,
+                                      const QTime iatTargetTime) {
+  const auto self = shared_from_this();
+  return TimeUtil(
+    Supplier<std::unique_ptr<AbstractTimer>>(
+      [self]() { return std::make_unique<VirtualTimer>(self); }),
+    Supplier<std::unique_ptr<AbstractRate>>(
+      [self]() { return std::make_unique<VirtualRate>(self); }),
+    Supplier<std::unique_ptr<SettledUtil>>([=]() {
+      return std::make_unique<SettledUtil>(
+        std::make_unique<VirtualTimer>(self), iatTargetError, iatTargetDerivative, iatTargetTime);
+    }));
+}
+
+CROSSPLATFORM_THREAD_ID_T VirtualClock::join() {
+  const auto self = CrossplatformThread::getCurrentId();
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  joinLocked(self);
+  return self;
+}
+
+void VirtualClock::leave(const CROSSPLATFORM_THREAD_ID_T ithread) {
+  std::lock_guard<CrossplatformMutex> lock(mutex);
+  leaveLocked(ithread);
+}
+
+void VirtualClock::sleepUntil(const std::uint32_t iwakeup) {
+  const auto self = CrossplatformThread::getCurrentId();
+
+  std::unique_lock<CrossplatformMutex> lock(mutex);
+  const bool wasJoined = joined.find(self) != joined.end();
+  if (!wasJoined) {
+    joinLocked(self);
+  }
+
+  sleepers[self] = Sleeper{iwakeup, sleeps++};
+  schedule();
+  turnChanged.wait(lock, [&]() { return woken.find(self) != woken.end(); });
+  woken.erase(self);
+
+  if (!wasJoined) {
+    leaveLocked(self);
+  }
+}
+
+void VirtualClock::joinLocked(const CROSSPLATFORM_THREAD_ID_T ithread) {
+  joined[ithread]++;
+  if (!started && joined.size() >= participants) {
+    started = true;
+  }
+}
+
+void VirtualClock::leaveLocked(const CROSSPLATFORM_THREAD_ID_T ithread) {
+  const auto entry = joined.find(ithread);
+  if (entry == joined.end()) {
+    return;
+  }
+
+  if (--entry->second == 0) {
+    joined.erase(entry);
+    // Every other thread might be waiting for this one
+    schedule();
+  }
+}
+
+void VirtualClock::schedule() {
+  // Sleepers have always joined, so every joined thread is sleeping when the counts match
+  if (!started || sleepers.empty() || sleepers.size() != joined.size()) {
+    return;
+  }
+
+  const auto next =
+    std::min_element(sleepers.begin(), sleepers.end(), [](const auto &a, const auto &b) {
+      return a.second.wakeup < b.second.wakeup ||
+             (a.second.wakeup == b.second.wakeup && a.second.order < b.second.order);
+    });
+
+  now = std::max(now, next->second.wakeup);
+  woken.insert(next->first);
+  sleepers.erase(next);
+  turnChanged.notifyAll();
+}
+
+VirtualTimer::VirtualTimer(std::shared_ptr<VirtualClock> iclock)
+  : AbstractTimer(iclock->millis()), clock(std::move(iclock)) {
+}
+
+QTime VirtualTimer::millis() const {
+  return clock->millis();
+}
+
+VirtualRate::VirtualRate(std::shared_ptr<VirtualClock> iclock) : clock(std::move(iclock)) {
+}
+
+VirtualRate::~VirtualRate() {
+  if (hasJoined) {
+    clock->leave(participant);
+  }
+}
+
+void VirtualRate::delay(const QFrequency ihz) {
+  delayUntil(1000 / ihz.convert(Hz));
+}
+
+void VirtualRate::delay(const int ihz) {
+  delayUntil(1000 / ihz);
+}
+
+void VirtualRate::delayUntil(const QTime itime) {
+  delayUntil(itime.convert(millisecond));
+}
+
+void VirtualRate::delayUntil(const uint32_t ims) {
+  const auto start = static_cast<std::uint32_t>(clock->millis().convert(millisecond));
+  if (lastTime == 0) {
+    // First call
+    lastTime = start;
+  }
+
+  if (!hasJoined) {
+    participant = clock->join();
+    hasJoined = true;
+  }
+
+  const std::uint32_t deadline = lastTime + ims;
+  clock->sleepUntil(deadline);
+  lastTime = deadline;
+  recordDelay(start, deadline, static_cast<std::uint32_t>(clock->millis().convert(millisecond)));
+}
+} // namespace okapi
@@ -29,6 +29,9 @@ void Rate::delayUntil(const uint32_t ims) {
     lastTime = pros::millis();
   }
 
+  const std::uint32_t start = pros::millis();
+  const std::uint32_t deadline = lastTime + ims;
   pros::Task::delay_until(&lastTime, ims);
+  recordDelay(start, deadline, pros::millis());
 }
 } // namespace okapi
@@ -2,22 +2,66 @@
 
 #include <stdlib.h>
 
+typedef struct {
+    Waypoint *path;
+    void (*fit)(Waypoint,Waypoint,Spline*);
+    int sample_count;
+    TrajectoryCandidate *cand;
+} PrepareContext;
+
+static void pathfinder_prepare_spline(void *context, int i) {
+    PrepareContext *ctx = (PrepareContext *)context;
+    TrajectoryCandidate *cand = ctx->cand;
+    int sample_count = ctx->sample_count;
+
+    Spline s;
+    ctx->fit(ctx->path[i], ctx->path[i+1], &s);
+    double dist = sample_count < 0
+        ? pf_spline_distance(&s, sample_count)
+        : pf_spline_distance_table(&s, sample_count, cand->taptr + i * pf_spline_table_length(sample_count));
+    cand->saptr[i] = s;
+    cand->laptr[i] = dist;
+}
+
 int pathfinder_prepare(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), int sample_count, double dt,
         double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand) {
+    return pathfinder_prepare_parallel(path, path_length, fit, sample_count, dt, max_velocity,
+        max_acceleration, max_jerk, cand, NULL, NULL);
+}
+
+int pathfinder_prepare_parallel(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), int sample_count, double dt,
+        double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        pf_parallel_for parallel_for, void *user) {
+    cand->saptr = NULL;
+    cand->laptr = NULL;
+    cand->taptr = NULL;
+    cand->length = -1;
     if (path_length < 2) return -1;
     
     cand->saptr = malloc((path_length - 1) * sizeof(Spline));
     cand->laptr = malloc((path_length - 1) * sizeof(double));
-    double totalLength = 0;
+    // Adaptive quadrature doesn't need a lookup table
+    int table_length = pf_spline_table_length(sample_count);
+    cand->taptr = table_length == 0 ? NULL : malloc((path_length - 1) * table_length * sizeof(double));
+    if (cand->saptr == NULL || cand->laptr == NULL || (table_length != 0 && cand->taptr == NULL)) {
+        pathfinder_candidate_free(cand);
+        return -1;
+    }
     
+    // Every spline writes only its own entries, so they can be measured in any order
+    PrepareContext ctx = {path, fit, sample_count, cand};
     int i;
+    if (parallel_for == NULL) {
+        for (i = 0; i < path_length-1; i++) {
+            pathfinder_prepare_spline(&ctx, i);
+        }
+    } else {
+        parallel_for(path_length - 1, pathfinder_prepare_spline, &ctx, user);
+    }
+
+    double totalLength = 0;
     for (i = 0; i < path_length-1; i++) {
-        Spline s;
-        fit(path[i], path[i+1], &s);
-        double dist = pf_spline_distance(&s, sample_count);
-        cand->saptr[i] = s;
-        cand->laptr[i] = dist;
-        totalLength += dist;
+        totalLength += cand->laptr[i];
     }
     
     TrajectoryConfig config = {dt, max_velocity, max_acceleration, max_jerk, 0, path[0].angle,
@@ -34,52 +78,94 @@ int pathfinder_prepare(Waypoint *path, int path_length, void (*fit)(Waypoint,Way
     return 0;
 }
 
-int pathfinder_generate(TrajectoryCandidate *c, Segment *segments) {
-    int trajectory_length = c->length;
-    int path_length = c->path_length;
-    double totalLength = c->totalLength;
+int pathfinder_generator_init(TrajectoryCandidate *c, TrajectoryGenerator *g) {
+    if (c->length < 0) return -1;
     
-    Spline *splines = (c->saptr);
-    double *splineLengths = (c->laptr);
+    TrajectoryInfo info = c->info;
+    if (pf_trajectory_filter_init(&g->filter, info.filter1, info.filter2, info.dt, info.u, info.v, info.impulse) < 0) {
+        return -1;
+    }
     
-    int trajectory_status = pf_trajectory_create(c->info, c->config, segments);
-    if (trajectory_status < 0) return trajectory_status;
+    g->candidate = c;
+    g->index = 0;
+    g->spline_i = 0;
+    g->table_cursor = 0;
+    g->spline_pos_initial = 0;
+    g->gauss_t = 0;
+    g->gauss_distance = 0;
+    g->tolerance = pf_spline_tolerance(c->config.sample_count);
+    return c->length;
+}
+
+int pathfinder_generator_next(TrajectoryGenerator *g, Segment *segment) {
+    TrajectoryCandidate *c = g->candidate;
+    if (g->index >= c->length) return 0;
     
-    int spline_i = 0;
-    double spline_pos_initial = 0, splines_complete = 0;
+    int path_length = c->path_length;
+    Spline *splines = (c->saptr);
+    double *splineLengths = (c->laptr);
+    double *splineTables = (c->taptr);
+    int sample_count = c->config.sample_count;
+    int table_length = pf_spline_table_length(sample_count);
     
-    int i;
-    for (i = 0; i < trajectory_length; ++i) {
-        double pos = segments[i].position;
+    pf_trajectory_filter_next(&g->filter, segment);
+    double pos = segment->position;
 
-        int found = 0;
-        while (!found) {
-            double pos_relative = pos - spline_pos_initial;
-            if (pos_relative <= splineLengths[spline_i]) {
-                Spline si = splines[spline_i];
-                double percentage = pf_spline_progress_for_distance(si, pos_relative, c->config.sample_count);
-                Coord coords = pf_spline_coords(si, percentage);
-                segments[i].heading = pf_spline_angle(si, percentage);
-                segments[i].x = coords.x;
-                segments[i].y = coords.y;
-                found = 1;
-            } else if (spline_i < path_length - 2) {
-                splines_complete += splineLengths[spline_i];
-                spline_pos_initial = splines_complete;
-                spline_i += 1;
-            } else {
-                Spline si = splines[path_length - 2];
-                segments[i].heading = pf_spline_angle(si, 1.0);
-                Coord coords = pf_spline_coords(si, 1.0);
-                segments[i].x = coords.x;
-                segments[i].y = coords.y;
-                found = 1;
-            }
+    int found = 0;
+    while (!found) {
+        double pos_relative = pos - g->spline_pos_initial;
+        if (pos_relative <= splineLengths[g->spline_i]) {
+            Spline si = splines[g->spline_i];
+            double percentage = sample_count < 0
+                ? pf_spline_progress_for_distance_gauss(si, pos_relative, g->tolerance, &g->gauss_t, &g->gauss_distance)
+                : pf_spline_progress_for_distance_table(si, splineTables + g->spline_i * table_length,
+                    pos_relative, sample_count, &g->table_cursor);
+            Coord coords = pf_spline_coords(si, percentage);
+            segment->heading = pf_spline_angle(si, percentage);
+            segment->x = coords.x;
+            segment->y = coords.y;
+            found = 1;
+        } else if (g->spline_i < path_length - 2) {
+            g->spline_pos_initial += splineLengths[g->spline_i];
+            g->spline_i += 1;
+            g->table_cursor = 0;
+            g->gauss_t = g->gauss_distance = 0;
+        } else {
+            Spline si = splines[path_length - 2];
+            segment->heading = pf_spline_angle(si, 1.0);
+            Coord coords = pf_spline_coords(si, 1.0);
+            segment->x = coords.x;
+            segment->y = coords.y;
+            found = 1;
         }
     }
     
+    g->index++;
+    return 1;
+}
+
+void pathfinder_generator_free(TrajectoryGenerator *g) {
+    pf_trajectory_filter_free(&g->filter);
+    pathfinder_candidate_free(g->candidate);
+}
+
+void pathfinder_candidate_free(TrajectoryCandidate *c) {
     free(c->saptr);
     free(c->laptr);
+    free(c->taptr);
+    c->saptr = NULL;
+    c->laptr = NULL;
+    c->taptr = NULL;
+}
+
+int pathfinder_generate(TrajectoryCandidate *c, Segment *segments) {
+    TrajectoryGenerator g;
+    int trajectory_length = pathfinder_generator_init(c, &g);
+    if (trajectory_length < 0) return trajectory_length;
+    
+    int i = 0;
+    while (pathfinder_generator_next(&g, &segments[i])) i++;
     
+    pathfinder_generator_free(&g);
     return trajectory_length;
 }
\ No newline at end of file
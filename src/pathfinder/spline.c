@@ -30,6 +30,8 @@ double pf_spline_angle(Spline s, double percentage) {
 }
 
 double pf_spline_distance(Spline *s, int sample_count) {
+    if (sample_count < 0) return pf_spline_distance_gauss(s, pf_spline_tolerance(sample_count));
+    
     double sample_count_d = (double) sample_count;
     
     double a = s->a; double b = s->b; double c = s->c; 
@@ -56,6 +58,11 @@ double pf_spline_distance(Spline *s, int sample_count) {
 }
 
 double pf_spline_progress_for_distance(Spline s, double distance, int sample_count) {
+    if (sample_count < 0) {
+        pf_spline_distance_gauss(&s, pf_spline_tolerance(sample_count));
+        return pf_spline_progress_for_distance_gauss(s, distance, pf_spline_tolerance(sample_count), NULL, NULL);
+    }
+    
     double sample_count_d = (double) sample_count;
     
     double a = s.a; double b = s.b; double c = s.c;
@@ -87,4 +94,178 @@ double pf_spline_progress_for_distance(Spline s, double distance, int sample_cou
             / (arc_length - last_arc_length) - 1) / sample_count_d;
     }
     return interpolated;
+}
+
+// Every stride-th partial sum is kept, so the table stays small however many samples are used
+static int pf_spline_table_stride(int sample_count) {
+    int stride = (sample_count + PATHFINDER_TABLE_CHECKPOINTS - 1) / PATHFINDER_TABLE_CHECKPOINTS;
+    return stride < 1 ? 1 : stride;
+}
+
+int pf_spline_table_length(int sample_count) {
+    if (sample_count < 0) return 0;
+    int stride = pf_spline_table_stride(sample_count);
+    return (sample_count + stride - 1) / stride + 1;
+}
+
+double pf_spline_distance_table(Spline *s, int sample_count, double *table) {
+    double sample_count_d = (double) sample_count;
+    int stride = pf_spline_table_stride(sample_count);
+    
+    double a = s->a; double b = s->b; double c = s->c; 
+    double d = s->d; double e = s->e; double knot = s->knot_distance;
+    
+    double arc_length = 0, t = 0, dydt = 0;
+    
+    double deriv0 = pf_spline_deriv_2(a, b, c, d, e, knot, 0);
+    
+    double integrand = 0;
+    double last_integrand = sqrt(1 + deriv0*deriv0) / sample_count_d;
+    
+    // Same accumulation as pf_spline_distance, but the partial sums at every checkpoint are kept
+    // so the progress lookups only need to integrate the spline from the nearest one.
+    int i;
+    for (i = 0; i <= sample_count; i = i + 1) {
+        t = i / sample_count_d;
+        dydt = pf_spline_deriv_2(a, b, c, d, e, knot, t);
+        integrand = sqrt(1 + dydt*dydt) / sample_count_d;
+        arc_length += (integrand + last_integrand) / 2;
+        if (i % stride == 0) table[i / stride] = arc_length;
+        last_integrand = integrand;
+    }
+    // The last sample is always a checkpoint
+    table[pf_spline_table_length(sample_count) - 1] = arc_length;
+    double al = knot * arc_length;
+    s->arc_length = al;
+    return al;
+}
+
+double pf_spline_progress_for_distance_table(Spline s, const double *table, double distance, int sample_count, int *cursor) {
+    double sample_count_d = (double) sample_count;
+    int stride = pf_spline_table_stride(sample_count);
+    int checkpoints = pf_spline_table_length(sample_count);
+    
+    double a = s.a; double b = s.b; double c = s.c;
+    double d = s.d; double e = s.e; double knot = s.knot_distance;
+    
+    distance /= knot;
+    
+    // Binary search for the first checkpoint whose arc length exceeds the distance. Lookups along
+    // a trajectory are monotonic, so the search never needs to look behind the cursor.
+    int lo = (cursor && *cursor > 0 && table[*cursor - 1] <= distance) ? *cursor : 0;
+    int hi = checkpoints;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (table[mid] > distance) hi = mid;
+        else lo = mid + 1;
+    }
+    if (cursor) *cursor = lo;
+    
+    if (lo >= checkpoints) return 1.0;
+    
+    // Integrate from the checkpoint before the one found, exactly as pf_spline_distance would
+    int i = lo > 0 ? (lo - 1) * stride : 0;
+    double arc_length = table[lo > 0 ? lo - 1 : 0];
+    double last_arc_length = lo > 0 ? arc_length : 0;
+    if (lo > 0) {
+        double dydt = pf_spline_deriv_2(a, b, c, d, e, knot, i / sample_count_d);
+        double last_integrand = sqrt(1 + dydt*dydt) / sample_count_d;
+        while (arc_length <= distance) {
+            i = i + 1;
+            dydt = pf_spline_deriv_2(a, b, c, d, e, knot, i / sample_count_d);
+            double integrand = sqrt(1 + dydt*dydt) / sample_count_d;
+            last_arc_length = arc_length;
+            arc_length += (integrand + last_integrand) / 2;
+            last_integrand = integrand;
+        }
+    }
+    
+    double interpolated = i / sample_count_d;
+    if (arc_length != last_arc_length) {
+        interpolated += ((distance - last_arc_length)
+            / (arc_length - last_arc_length) - 1) / sample_count_d;
+    }
+    return interpolated;
+}
+
+// ADAPTIVE GAUSS-LEGENDRE QUADRATURE //
+
+static const double pf_gl5_nodes[5] = {
+    0.0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640
+};
+static const double pf_gl5_weights[5] = {
+    0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891
+};
+
+#define PF_GAUSS_MAX_DEPTH 24
+#define PF_GAUSS_MAX_ITERATIONS 50
+
+double pf_spline_tolerance(int sample_count) {
+    return pow(10, sample_count);
+}
+
+// Integral of sqrt(1 + y'^2) over [from, to] in percentage space; to < from gives a negative result
+static double pf_spline_arc_gl5(const Spline *s, double from, double to) {
+    double half = (to - from) / 2, mid = (to + from) / 2, sum = 0;
+    int i;
+    for (i = 0; i < 5; i++) {
+        double dydt = pf_spline_deriv_2(s->a, s->b, s->c, s->d, s->e, s->knot_distance, mid + half * pf_gl5_nodes[i]);
+        sum += pf_gl5_weights[i] * sqrt(1 + dydt*dydt);
+    }
+    return half * sum;
+}
+
+static double pf_spline_arc_adaptive(const Spline *s, double from, double to, double whole, double tolerance, int depth) {
+    double mid = (from + to) / 2;
+    double left = pf_spline_arc_gl5(s, from, mid);
+    double right = pf_spline_arc_gl5(s, mid, to);
+    if (depth <= 0 || fabs(left + right - whole) <= tolerance) return left + right;
+    return pf_spline_arc_adaptive(s, from, mid, left, tolerance / 2, depth - 1)
+         + pf_spline_arc_adaptive(s, mid, to, right, tolerance / 2, depth - 1);
+}
+
+double pf_spline_arc_length_gauss(Spline *s, double from, double to, double tolerance) {
+    if (from == to) return 0;
+    double knot = s->knot_distance;
+    return knot * pf_spline_arc_adaptive(s, from, to, pf_spline_arc_gl5(s, from, to), tolerance / knot, PF_GAUSS_MAX_DEPTH);
+}
+
+double pf_spline_distance_gauss(Spline *s, double tolerance) {
+    double al = pf_spline_arc_length_gauss(s, 0, 1, tolerance);
+    s->arc_length = al;
+    return al;
+}
+
+double pf_spline_progress_for_distance_gauss(Spline s, double distance, double tolerance, double *last_t, double *last_distance) {
+    if (distance >= s.arc_length) return 1.0;
+    
+    // Start from the previous solution if there is one, since lookups along a trajectory are monotonic
+    double lo = 0, hi = 1, t = 0, covered = 0;
+    if (last_t && last_distance && *last_distance <= distance) {
+        lo = t = *last_t;
+        covered = *last_distance;
+    }
+    
+    // Newton's method on arc length, falling back to bisection when a step leaves the bracket
+    int i;
+    for (i = 0; i < PF_GAUSS_MAX_ITERATIONS; i++) {
+        double error = covered - distance;
+        if (fabs(error) <= tolerance) break;
+        
+        if (error > 0) hi = t;
+        else lo = t;
+        
+        double dydt = pf_spline_deriv_2(s.a, s.b, s.c, s.d, s.e, s.knot_distance, t);
+        double next = t - error / (s.knot_distance * sqrt(1 + dydt*dydt));
+        if (next <= lo || next >= hi) next = (lo + hi) / 2;
+        
+        covered += pf_spline_arc_length_gauss(&s, t, next, tolerance);
+        t = next;
+    }
+    
+    if (last_t && last_distance) {
+        *last_t = t;
+        *last_distance = covered;
+    }
+    return t;
 }
\ No newline at end of file
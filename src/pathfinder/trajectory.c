@@ -55,59 +55,88 @@ int pf_trajectory_create(TrajectoryInfo info, TrajectoryConfig c, Segment *seg)
     return 0;
 }
 
-int pf_trajectory_fromSecondOrderFilter(int filter_1_l, int filter_2_l, 
-        double dt, double u, double v, double impulse, int len, Segment *t) {
+int pf_trajectory_filter_init(SecondOrderFilter *f, int filter_1_l, int filter_2_l,
+        double dt, double u, double v, double impulse) {
     Segment last_section = {dt, 0, 0, 0, u, 0, 0};
     
-    if (len < 0) {
-        // Error
-        return -1;
-    }
-    
-    // double f1_buffer[len];
-    double *f1_buffer = malloc(len * sizeof(double));       // VS doesn't support VLAs
-    f1_buffer[0] = (u / v) * filter_1_l;
-    double f2;
+    // Only the last filter_2_l outputs of the first filter are ever summed, so they're kept in a
+    // ring buffer and the window sum is updated as it slides. Since the filter outputs are almost
+    // always whole numbers the running sum is exact in practice; otherwise it can drift from a
+    // recomputed sum by a few ulps of filter_1_l * filter_2_l over the trajectory.
+    f->f2_ring = malloc(MAX(filter_2_l, 1) * sizeof(double));       // VS doesn't support VLAs
+    if (f->f2_ring == NULL) return -1;
     
-    int i;
-    for (i = 0; i < len; i++) {
-        double input = MIN(impulse, 1);
-        if (input < 1) {
-            input -= 1;
-            impulse = 0;
-        } else {
-            impulse -= input;
-        }
-
-        double f1_last;
-        
-        if (i > 0) f1_last = f1_buffer[i - 1];
-        else f1_last = f1_buffer[0];
+    f->filter_1_l = filter_1_l;
+    f->filter_2_l = filter_2_l;
+    f->index = 0;
+    f->dt = dt;
+    f->v = v;
+    f->impulse = impulse;
+    f->f1_last = (u / v) * filter_1_l;
+    f->f2_sum = 0;
+    f->last = last_section;
+    return 0;
+}
 
-        f1_buffer[i] = MAX(0.0, MIN(filter_1_l, f1_last + input));
+void pf_trajectory_filter_next(SecondOrderFilter *f, Segment *seg) {
+    double input = MIN(f->impulse, 1);
+    if (input < 1) {
+        input -= 1;
+        f->impulse = 0;
+    } else {
+        f->impulse -= input;
+    }
+
+    double f1 = MAX(0.0, MIN(f->filter_1_l, f->f1_last + input));
+    f->f1_last = f1;
 
-        f2 = 0;
-        int j;
-        for (j = 0; j < filter_2_l; ++j) {
-            if (i - j < 0) break;
+    if (f->filter_2_l > 0) {
+        int slot = f->index % f->filter_2_l;
+        if (f->index >= f->filter_2_l) f->f2_sum -= f->f2_ring[slot];
+        f->f2_ring[slot] = f1;
+        f->f2_sum += f1;
+    }
+    double f2 = f->f2_sum / f->filter_1_l;
 
-            f2 += f1_buffer[i - j];
-        }
-        f2 = f2 / filter_1_l;
+    Segment last_section = f->last;
+    double dt = f->dt;
+    Segment t = last_section;
 
-        t[i].velocity = f2 / filter_2_l * v;
+    t.velocity = f2 / f->filter_2_l * f->v;
 
-        t[i].position = (last_section.velocity + t[i].velocity) / 2.0 * dt + last_section.position;
+    t.position = (last_section.velocity + t.velocity) / 2.0 * dt + last_section.position;
 
-        t[i].x = t[i].position;
-        t[i].y = 0;
+    t.x = t.position;
+    t.y = 0;
 
-        t[i].acceleration = (t[i].velocity - last_section.velocity) / dt;
-        t[i].jerk = (t[i].acceleration - last_section.acceleration) / dt;
-        t[i].dt = dt;
+    t.acceleration = (t.velocity - last_section.velocity) / dt;
+    t.jerk = (t.acceleration - last_section.acceleration) / dt;
+    t.dt = dt;
 
-        last_section = t[i];
+    f->last = t;
+    f->index++;
+    *seg = t;
+}
+
+void pf_trajectory_filter_free(SecondOrderFilter *f) {
+    free(f->f2_ring);
+    f->f2_ring = NULL;
+}
+
+int pf_trajectory_fromSecondOrderFilter(int filter_1_l, int filter_2_l, 
+        double dt, double u, double v, double impulse, int len, Segment *t) {
+    if (len < 0) {
+        // Error
+        return -1;
+    }
+    
+    SecondOrderFilter filter;
+    if (pf_trajectory_filter_init(&filter, filter_1_l, filter_2_l, dt, u, v, impulse) < 0) return -1;
+    
+    int i;
+    for (i = 0; i < len; i++) {
+        pf_trajectory_filter_next(&filter, &t[i]);
     }
-    free(f1_buffer);
+    pf_trajectory_filter_free(&filter);
     return 0;
 }
\ No newline at end of file
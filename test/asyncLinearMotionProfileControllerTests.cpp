@@ -6,7 +6,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include "okapi/api/control/async/asyncLinearMotionProfileController.hpp"
+#include "okapi/api/util/virtualClock.hpp"
 #include "test/tests/api/implMocks.hpp"
+#include <algorithm>
 #include <gtest/gtest.h>
 
 using namespace okapi;
@@ -23,13 +25,41 @@ class MockAsyncLinearMotionProfileController : public AsyncLinearMotionProfileCo
   bool executeSinglePathCalled{false};
 };
 
+class RecordingAsyncVelIntegratedController : public MockAsyncVelIntegratedController {
+  public:
+  void controllerSet(double ivalue) override {
+    MockAsyncVelIntegratedController::controllerSet(ivalue);
+    outputs.push_back(ivalue);
+  }
+
+  /**
+   * Returns the slowest output between first reaching the top speed and last leaving it.
+   */
+  double getSlowestCruiseOutput() const {
+    const double peak = *std::max_element(outputs.begin(), outputs.end());
+    const auto first = std::find_if(outputs.begin(), outputs.end(), [&](double output) {
+      return output > peak * 0.99;
+    });
+    const auto last = std::find_if(outputs.rbegin(), outputs.rend(), [&](double output) {
+      return output > peak * 0.99;
+    });
+    return *std::min_element(first, last.base());
+  }
+
+  std::vector<double> outputs;
+};
+
 class AsyncLinearMotionProfileControllerTest : public ::testing::Test {
   protected:
   void SetUp() override {
     output = new MockAsyncVelIntegratedController();
 
     controller = new MockAsyncLinearMotionProfileController(
-      createTimeUtil(), 1.0, 2.0, 10.0, std::shared_ptr<MockAsyncVelIntegratedController>(output));
+      clock->createTimeUtil(),
+      1.0,
+      2.0,
+      10.0,
+      std::shared_ptr<MockAsyncVelIntegratedController>(output));
     controller->startThread();
   }
 
@@ -37,6 +67,8 @@ class AsyncLinearMotionProfileControllerTest : public ::testing::Test {
     delete controller;
   }
 
+  // Paths are followed in simulated time so the tests do not wait for them in real time
+  std::shared_ptr<VirtualClock> clock{std::make_shared<VirtualClock>()};
   MockAsyncVelIntegratedController *output;
   MockAsyncLinearMotionProfileController *controller;
 };
@@ -79,6 +111,14 @@ TEST_F(AsyncLinearMotionProfileControllerTest, WrongPathNameDoesNotMoveAnything)
   EXPECT_EQ(output->maxControllerOutputSet, 0);
 }
 
+TEST_F(AsyncLinearMotionProfileControllerTest, WrongPathNameDoesNotReserveAHandle) {
+  controller->setTarget("A");
+  controller->waitUntilSettled();
+
+  EXPECT_EQ(controller->getTarget(), "A");
+  EXPECT_FALSE(controller->getPathHandle("A").isValid());
+}
+
 TEST_F(AsyncLinearMotionProfileControllerTest, TwoPathsOverwriteEachOther) {
   controller->generatePath({0, 3}, "A");
   controller->generatePath({0, 4}, "A");
@@ -92,6 +132,67 @@ TEST_F(AsyncLinearMotionProfileControllerTest, TwoPathsOverwriteEachOther) {
   EXPECT_GT(output->maxControllerOutputSet, 0);
 }
 
+TEST_F(AsyncLinearMotionProfileControllerTest, FollowPathByHandle) {
+  const PathHandle path = controller->generatePath({0, 3}, "A");
+  EXPECT_EQ(controller->getPathHandle("A"), path);
+
+  controller->setTarget(path);
+  EXPECT_EQ(controller->getTarget(), "A");
+  controller->waitUntilSettled();
+  EXPECT_EQ(output->lastControllerOutputSet, 0);
+  EXPECT_GT(output->maxControllerOutputSet, 0);
+}
+
+TEST_F(AsyncLinearMotionProfileControllerTest, QueuedPathsAreFollowedInOrder) {
+  auto recorder = std::make_shared<RecordingAsyncVelIntegratedController>();
+  MockAsyncLinearMotionProfileController queueController(
+    clock->createTimeUtil(), 1.0, 2.0, 10.0, recorder);
+  queueController.startThread();
+  queueController.generatePath({0, 1}, "A");
+  queueController.generatePath({1, 2}, "B");
+
+  EXPECT_TRUE(queueController.queuePath("A"));
+  EXPECT_TRUE(queueController.queuePath(queueController.getPathHandle("B")));
+  EXPECT_FALSE(queueController.isSettled());
+  queueController.waitUntilSettled();
+
+  EXPECT_EQ(queueController.getTarget(), "B");
+  EXPECT_EQ(recorder->lastControllerOutputSet, 0);
+  // Without blending the first path slows to a stop before the second path starts
+  EXPECT_LT(recorder->getSlowestCruiseOutput(), 0.1);
+}
+
+TEST_F(AsyncLinearMotionProfileControllerTest, BlendedPathsKeepTheirSpeed) {
+  auto recorder = std::make_shared<RecordingAsyncVelIntegratedController>();
+  MockAsyncLinearMotionProfileController queueController(
+    clock->createTimeUtil(), 1.0, 2.0, 10.0, recorder);
+  queueController.startThread();
+  queueController.generatePath({0, 1}, "A");
+  queueController.generatePath({1, 2}, "B");
+  queueController.setPathBlending(true);
+
+  queueController.queuePath("A");
+  queueController.queuePath("B");
+  queueController.waitUntilSettled();
+
+  EXPECT_EQ(queueController.getTarget(), "B");
+  EXPECT_EQ(recorder->lastControllerOutputSet, 0);
+  EXPECT_GT(recorder->getSlowestCruiseOutput(), 0.9);
+  EXPECT_LT(recorder->maxControllerOutputSet, 1.05);
+}
+
+TEST_F(AsyncLinearMotionProfileControllerTest, QueuedPathsAreDroppedWhenDisabled) {
+  controller->generatePath({0, 3}, "A");
+  controller->flipDisable(true);
+  controller->queuePath("A");
+  EXPECT_TRUE(controller->isSettled());
+
+  // reset() waits for the queue to be dropped
+  controller->reset();
+  controller->waitUntilSettled();
+  EXPECT_EQ(output->maxControllerOutputSet, 0);
+}
+
 TEST_F(AsyncLinearMotionProfileControllerTest, ZeroWaypointsDoesNothing) {
   controller->generatePath({}, "A");
   EXPECT_EQ(controller->getPaths().size(), 0);
@@ -142,7 +243,7 @@ TEST_F(AsyncLinearMotionProfileControllerTest, ResetStopsMotors) {
   controller->generatePath({0, 3}, "A");
   controller->setTarget("A");
 
-  auto rate = createTimeUtil().getRate();
+  auto rate = clock->createTimeUtil().getRate();
   while (!controller->executeSinglePathCalled) {
     rate->delayUntil(1_ms);
   }
@@ -161,7 +262,7 @@ TEST_F(AsyncLinearMotionProfileControllerTest, DisabledStopsMotors) {
   controller->generatePath({0, 3}, "A");
   controller->setTarget("A");
 
-  auto rate = createTimeUtil().getRate();
+  auto rate = clock->createTimeUtil().getRate();
   while (!controller->executeSinglePathCalled) {
     rate->delayUntil(1_ms);
   }
@@ -179,3 +280,48 @@ TEST_F(AsyncLinearMotionProfileControllerTest, DisabledStopsMotors) {
   EXPECT_TRUE(controller->isSettled());
   EXPECT_EQ(output->lastControllerOutputSet, 0);
 }
+
+TEST_F(AsyncLinearMotionProfileControllerTest, PathMemoryUsage) {
+  EXPECT_EQ(controller->getPathMemoryUsage("A"), 0);
+
+  controller->generatePath({0, 3}, "A");
+
+  // Only position and velocity are stored by default
+  const auto usage = controller->getPathMemoryUsage("A");
+  EXPECT_GT(usage, 0);
+  EXPECT_EQ(usage % (2 * sizeof(double)), 0);
+}
+
+TEST_F(AsyncLinearMotionProfileControllerTest, Float32PathsAreFollowed) {
+  auto floatOutput = std::make_shared<MockAsyncVelIntegratedController>();
+  AsyncLinearMotionProfileController floatController(
+    clock->createTimeUtil(),
+    1.0,
+    2.0,
+    10.0,
+    floatOutput,
+    {CompactTrajectory::mask(
+       {CompactTrajectory::Field::position, CompactTrajectory::Field::velocity}),
+     CompactTrajectory::Precision::float32});
+  floatController.startThread();
+
+  floatController.generatePath({0, 3}, "A");
+  controller->generatePath({0, 3}, "A");
+  EXPECT_EQ(floatController.getPathMemoryUsage("A") * 2, controller->getPathMemoryUsage("A"));
+
+  floatController.setTarget("A");
+  EXPECT_NEAR(floatController.getError(), 3, 0.1);
+  floatController.waitUntilSettled();
+
+  EXPECT_EQ(floatOutput->lastControllerOutputSet, 0);
+  EXPECT_GT(floatOutput->maxControllerOutputSet, 0);
+}
+
+TEST_F(AsyncLinearMotionProfileControllerTest, GeneratePathsSavesEveryPath) {
+  controller->generatePaths({{"A", {0, 3}}, {"B", {0, 1}}, {"Empty", {}}}, 4);
+  controller->generatePath({0, 3}, "A serial");
+
+  EXPECT_EQ(controller->getPaths(), (std::vector<std::string>{"A", "A serial", "B"}));
+  EXPECT_EQ(controller->getPathMemoryUsage("A"), controller->getPathMemoryUsage("A serial"));
+  EXPECT_LT(controller->getPathMemoryUsage("B"), controller->getPathMemoryUsage("A"));
+}
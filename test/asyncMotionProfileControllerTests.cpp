@@ -7,7 +7,11 @@
  */
 #include "okapi/api/control/async/asyncMotionProfileController.hpp"
 #include "test/tests/api/implMocks.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <gtest/gtest.h>
+#include <iostream>
 
 using namespace okapi;
 
@@ -15,13 +19,23 @@ class MockAsyncMotionProfileController : public AsyncMotionProfileController {
   public:
   using AsyncMotionProfileController::AsyncMotionProfileController;
   using AsyncMotionProfileController::convertLinearToRotational;
+  using AsyncMotionProfileController::getCacheKey;
+  using AsyncMotionProfileController::paths;
 
   void executeSinglePath(const TrajectoryPair &path, std::unique_ptr<AbstractRate> rate) override {
     executeSinglePathCalled = true;
+    executeSinglePathCount++;
     AsyncMotionProfileController::executeSinglePath(path, std::move(rate));
   }
 
+  void executeStream(TrajectoryStream &stream, std::unique_ptr<AbstractRate> rate) override {
+    executeStreamCalled = true;
+    AsyncMotionProfileController::executeStream(stream, std::move(rate));
+  }
+
   bool executeSinglePathCalled{false};
+  int executeSinglePathCount{0};
+  bool executeStreamCalled{false};
 };
 
 class AsyncMotionProfileControllerTest : public ::testing::Test {
@@ -85,6 +99,79 @@ TEST_F(AsyncMotionProfileControllerTest, FollowPathWithMoveTo) {
   EXPECT_GT(rightMotor->maxVelocity, 0);
 }
 
+TEST_F(AsyncMotionProfileControllerTest, MoveToStreamsPath) {
+  controller->moveTo({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}});
+
+  EXPECT_TRUE(controller->executeStreamCalled);
+  EXPECT_FALSE(controller->executeSinglePathCalled);
+  EXPECT_TRUE(controller->getPaths().empty());
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, MoveToWhileDisabledDoesNotMove) {
+  controller->flipDisable(true);
+  // Long enough to fill the stream, so moveTo() has to notice the controller is disabled
+  controller->moveTo({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}});
+
+  controller->flipDisable(false);
+  EXPECT_TRUE(controller->isSettled());
+  createTimeUtil().getRate()->delayUntil(50_ms);
+
+  EXPECT_FALSE(controller->executeStreamCalled);
+  EXPECT_EQ(leftMotor->maxVelocity, 0);
+  EXPECT_EQ(rightMotor->maxVelocity, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ImpossibleMoveToThrowsException) {
+  EXPECT_THROW(controller->moveTo({Point{0_m, 0_m, 0_deg},
+                                   Point{3_ft, 0_m, 0_deg},
+                                   Point{3_ft, 1_ft, 0_deg},
+                                   Point{2_ft, 1_ft, 0_deg},
+                                   Point{1_ft, 1_m, 0_deg},
+                                   Point{1_ft, 0_m, 0_deg}}),
+               std::runtime_error);
+  EXPECT_TRUE(controller->isSettled());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, SetFollowerGainsNeedsPositionAndHeading) {
+  EXPECT_THROW(controller->setFollowerGains({1, 0, 0, 1}), std::invalid_argument);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, OpenLoopErrorIsZero) {
+  controller->moveTo({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}});
+
+  EXPECT_EQ(controller->getError().x, 0_m);
+  EXPECT_EQ(controller->getError().theta, 0_deg);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ClosedLoopCorrectsForStuckWheels) {
+  controller->moveTo({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}});
+  const auto openLoopMaxVelocity = leftMotor->maxVelocity;
+  leftMotor->maxVelocity = 0;
+  rightMotor->maxVelocity = 0;
+
+  using Field = CompactTrajectory::Field;
+  MockAsyncMotionProfileController closedLoopController(
+    createTimeUtil(),
+    1.0,
+    2.0,
+    10.0,
+    std::make_shared<SkidSteerModel>(leftMotor, rightMotor, 100),
+    {4_in, 10.5_in},
+    AbstractMotor::gearset::green * (1.0 / 2),
+    {CompactTrajectory::mask({Field::position, Field::velocity, Field::heading})});
+  closedLoopController.startThread();
+  closedLoopController.setFollowerGains({1, 0, 0, 1});
+
+  // The encoders never change, so the robot falls further behind the whole way
+  closedLoopController.moveTo({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}});
+
+  EXPECT_GT(leftMotor->maxVelocity, openLoopMaxVelocity);
+  EXPECT_NEAR(closedLoopController.getError().x.convert(meter), (3_ft).convert(meter), 0.01);
+  EXPECT_NEAR(closedLoopController.getError().theta.convert(radian), 0, 1e-9);
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+}
+
 TEST_F(AsyncMotionProfileControllerTest, WrongPathNameDoesNotMoveAnything) {
   controller->setTarget("A");
   controller->waitUntilSettled();
@@ -93,6 +180,14 @@ TEST_F(AsyncMotionProfileControllerTest, WrongPathNameDoesNotMoveAnything) {
   EXPECT_EQ(rightMotor->maxVelocity, 0);
 }
 
+TEST_F(AsyncMotionProfileControllerTest, WrongPathNameDoesNotReserveAHandle) {
+  controller->setTarget("A");
+  controller->waitUntilSettled();
+
+  EXPECT_EQ(controller->getTarget(), "A");
+  EXPECT_FALSE(controller->getPathHandle("A").isValid());
+}
+
 TEST_F(AsyncMotionProfileControllerTest, TwoPathsOverwriteEachOther) {
   controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 45_deg}}, "A");
   controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 2_ft, 45_deg}}, "A");
@@ -148,6 +243,160 @@ TEST_F(AsyncMotionProfileControllerTest, ControllerSetChangesTarget) {
   EXPECT_EQ(controller->getTarget(), "A");
 }
 
+TEST_F(AsyncMotionProfileControllerTest, FollowPathByHandle) {
+  const PathHandle path =
+    controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A");
+
+  EXPECT_EQ(controller->getPathHandle("A"), path);
+  controller->setTarget(path);
+  EXPECT_EQ(controller->getTarget(), "A");
+  controller->waitUntilSettled();
+
+  EXPECT_TRUE(controller->executeSinglePathCalled);
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+  EXPECT_GT(leftMotor->maxVelocity, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, HandleStaysValidAfterRegeneratingAndRemoving) {
+  const PathHandle path =
+    controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A");
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}}, "A");
+  controller->removePath(path);
+  EXPECT_TRUE(controller->getPaths().empty());
+  EXPECT_EQ(controller->getPathHandle("A"), path);
+
+  EXPECT_EQ(
+    controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A"), path);
+  EXPECT_GT(controller->getPathMemoryUsage("A"), 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, UnknownPathNameHasNoHandle) {
+  // Looking up a name does not reserve a slot for it
+  EXPECT_FALSE(controller->getPathHandle("A").isValid());
+  EXPECT_TRUE(controller->getPaths().empty());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, UnnamedPathHandleIsStaleAfterRemoval) {
+  const PathHandle path =
+    controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}});
+  EXPECT_TRUE(path.isValid());
+  EXPECT_TRUE(controller->getPaths().empty());
+
+  controller->removePath(path);
+  const PathHandle reused =
+    controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}});
+  EXPECT_NE(reused, path);
+
+  // The stale handle does not follow the path which reused its slot
+  controller->setTarget(path);
+  controller->waitUntilSettled();
+  EXPECT_FALSE(controller->executeSinglePathCalled);
+  EXPECT_EQ(leftMotor->maxVelocity, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, QueuedPathsAreFollowedWithoutStopping) {
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}}, "A");
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}}, "B");
+  controller->setPathBlending(true);
+
+  EXPECT_TRUE(controller->queuePath("A"));
+  EXPECT_TRUE(controller->queuePath("B", true));
+  controller->waitUntilSettled();
+
+  // Both paths are followed in one call, so the chassis is only stopped once
+  EXPECT_EQ(controller->executeSinglePathCount, 1);
+  EXPECT_EQ(controller->getTarget(), "B");
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+  EXPECT_GT(leftMotor->maxVelocity, 0);
+}
+
+class VelocityRecordingMotor : public MockMotor {
+  public:
+  std::int32_t moveVelocity(const std::int16_t ivelocity) const override {
+    velocities.push_back(ivelocity);
+    return MockMotor::moveVelocity(ivelocity);
+  }
+
+  mutable std::vector<std::int16_t> velocities;
+};
+
+/**
+ * Follows two paths queued with blending on and returns whether the left side kept moving forward
+ * from when it started until it stopped.
+ */
+bool keepsMovingThroughTheSeam(const CompactTrajectory::Format &iformat,
+                               std::initializer_list<Point> ifirst,
+                               std::initializer_list<Point> isecond) {
+  auto left = std::make_shared<VelocityRecordingMotor>();
+  auto right = std::make_shared<VelocityRecordingMotor>();
+  MockAsyncMotionProfileController blended(createTimeUtil(),
+                                           1.0,
+                                           2.0,
+                                           10.0,
+                                           std::make_shared<SkidSteerModel>(left, right, 100),
+                                           {4_in, 10.5_in},
+                                           AbstractMotor::gearset::green * (1.0 / 2),
+                                           iformat);
+  blended.startThread();
+
+  blended.generatePath(ifirst, "A");
+  blended.generatePath(isecond, "B");
+  blended.setPathBlending(true);
+
+  EXPECT_TRUE(blended.queuePath("A"));
+  EXPECT_TRUE(blended.queuePath("B"));
+  blended.waitUntilSettled();
+
+  EXPECT_EQ(blended.executeSinglePathCount, 1);
+  EXPECT_EQ(blended.getTarget(), "B");
+
+  const auto &velocities = left->velocities;
+  const auto moving = [](const std::int16_t ivelocity) { return ivelocity > 0; };
+  const auto first = std::find_if(velocities.begin(), velocities.end(), moving);
+  const auto last = std::find_if(velocities.rbegin(), velocities.rend(), moving).base();
+  return first < last && std::all_of(first, last, moving);
+}
+
+const CompactTrajectory::Format headingFormat{
+  CompactTrajectory::mask({CompactTrajectory::Field::velocity, CompactTrajectory::Field::heading})};
+
+TEST_F(AsyncMotionProfileControllerTest, BlendedPathsDoNotStopAtTheSeam) {
+  EXPECT_TRUE(keepsMovingThroughTheSeam(headingFormat,
+                                        {Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}},
+                                        {Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}}));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, PathsWhichMeetAtAnAngleAreNotBlended) {
+  EXPECT_FALSE(keepsMovingThroughTheSeam(headingFormat,
+                                         {Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}},
+                                         {Point{0_m, 0_m, 90_deg}, Point{0_m, 2_ft, 90_deg}}));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, PathsWithoutHeadingsAreNotBlended) {
+  // The default format only stores velocity, so a turn at the seam cannot be ruled out
+  const CompactTrajectory::Format velocityOnly{
+    CompactTrajectory::mask({CompactTrajectory::Field::velocity})};
+  EXPECT_FALSE(keepsMovingThroughTheSeam(velocityOnly,
+                                         {Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}},
+                                         {Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}}));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, QueuedPathWhichDoesNotExistIsNotQueued) {
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{2_ft, 0_m, 0_deg}}, "A");
+
+  EXPECT_TRUE(controller->queuePath("A"));
+  EXPECT_FALSE(controller->queuePath("B"));
+  controller->waitUntilSettled();
+
+  EXPECT_EQ(controller->getTarget(), "A");
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, InvalidHandleIsNotQueued) {
+  EXPECT_FALSE(controller->queuePath(PathHandle()));
+  EXPECT_TRUE(controller->isSettled());
+}
+
 TEST_F(AsyncMotionProfileControllerTest, ResetStopsMotors) {
   controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 45_deg}}, "A");
   controller->setTarget("A");
@@ -218,3 +467,194 @@ TEST_F(AsyncMotionProfileControllerTest, FollowPathBackwards) {
   // still running
   controller->flipDisable(true);
 }
+
+TEST_F(AsyncMotionProfileControllerTest, PathMemoryUsage) {
+  EXPECT_EQ(controller->getPathMemoryUsage("A"), 0);
+
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A");
+
+  // Only left and right velocity are stored by default
+  const auto usage = controller->getPathMemoryUsage("A");
+  EXPECT_GT(usage, 0);
+  EXPECT_EQ(usage % (2 * sizeof(double)), 0);
+
+  controller->removePath("A");
+  EXPECT_EQ(controller->getPathMemoryUsage("A"), 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, CachedPathIsLoadedInsteadOfGenerated) {
+  auto cache = std::make_shared<TrajectoryCache>(::testing::TempDir());
+  controller->setCache(cache);
+
+  MockAsyncMotionProfileController other(createTimeUtil(),
+                                         1.5,
+                                         2.0,
+                                         10.0,
+                                         std::make_shared<SkidSteerModel>(
+                                           std::make_shared<MockMotor>(),
+                                           std::make_shared<MockMotor>(),
+                                           100),
+                                         {4_in, 10.5_in},
+                                         AbstractMotor::gearset::green * (1.0 / 2));
+  other.setCache(cache);
+
+  const std::vector<Waypoint> path{{0, 0, 0}, {(3_ft).convert(meter), 0, 0}};
+  const std::vector<Waypoint> shiftedPath{{0, 0, 0},
+                                          {(3_ft).convert(meter), (1_in).convert(meter), 0}};
+  const std::vector<std::uint64_t> keys{
+    controller->getCacheKey(path, PATHFINDER_SAMPLES_FAST),
+    controller->getCacheKey(shiftedPath, PATHFINDER_SAMPLES_FAST),
+    other.getCacheKey(path, PATHFINDER_SAMPLES_FAST),
+    controller->getCacheKey(path, PATHFINDER_SAMPLES_GAUSS)};
+  for (const auto key : keys) {
+    cache->invalidate(key);
+  }
+
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A");
+  EXPECT_EQ(cache->getHits(), 0);
+  EXPECT_EQ(cache->getMisses(), 1);
+
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "B");
+  EXPECT_EQ(cache->getHits(), 1);
+  EXPECT_EQ(controller->getPathMemoryUsage("B"), controller->getPathMemoryUsage("A"));
+
+  // Any change to the waypoints or limits makes a new path
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 1_in, 0_deg}}, "C");
+  EXPECT_EQ(cache->getMisses(), 2);
+
+  other.generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A");
+  EXPECT_EQ(cache->getHits(), 1);
+  EXPECT_EQ(cache->getMisses(), 3);
+
+  // So does measuring the splines differently
+  controller->setSampleCount(PATHFINDER_SAMPLES_GAUSS);
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "D");
+  EXPECT_EQ(cache->getHits(), 1);
+  EXPECT_EQ(cache->getMisses(), 4);
+
+  controller->executeSinglePathCalled = false;
+  controller->setTarget("B");
+  controller->waitUntilSettled();
+  EXPECT_TRUE(controller->executeSinglePathCalled);
+
+  for (const auto key : keys) {
+    cache->invalidate(key);
+  }
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ZeroSampleCountThrowsException) {
+  EXPECT_THROW(controller->setSampleCount(0), std::invalid_argument);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GeneratePathAsyncSavesPath) {
+  auto future =
+    controller->generatePathAsync({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A");
+  EXPECT_EQ(future.getPathId(), "A");
+
+  future.get();
+  EXPECT_EQ(future.getStatus(), PathFuture::Status::ready);
+  EXPECT_EQ(controller->getPaths(), std::vector<std::string>{"A"});
+  EXPECT_GT(controller->getPathMemoryUsage("A"), 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ImpossibleAsyncPathFails) {
+  auto future = controller->generatePathAsync({Point{0_m, 0_m, 0_deg},
+                                               Point{3_ft, 0_m, 0_deg},
+                                               Point{3_ft, 1_ft, 0_deg},
+                                               Point{2_ft, 1_ft, 0_deg},
+                                               Point{1_ft, 1_m, 0_deg},
+                                               Point{1_ft, 0_m, 0_deg}},
+                                              "A");
+
+  EXPECT_THROW(future.get(), std::runtime_error);
+  EXPECT_EQ(future.getStatus(), PathFuture::Status::failed);
+  EXPECT_TRUE(controller->getPaths().empty());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, SetTargetWaitsForAsyncPath) {
+  auto future =
+    controller->generatePathAsync({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A");
+  controller->setTarget("A");
+  EXPECT_FALSE(controller->isSettled());
+
+  controller->waitUntilSettled();
+  EXPECT_TRUE(future.isDone());
+  EXPECT_TRUE(controller->executeSinglePathCalled);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, AsyncPathsAreGeneratedInOrder) {
+  auto first =
+    controller->generatePathAsync({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A");
+  auto second =
+    controller->generatePathAsync({Point{0_m, 0_m, 0_deg}, Point{1_ft, 0_m, 0_deg}}, "B");
+
+  second.wait();
+  EXPECT_TRUE(first.isDone());
+  EXPECT_EQ(controller->getPaths(), (std::vector<std::string>{"A", "B"}));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, QueuedAsyncPathsAreGeneratedAfterMove) {
+  auto skidSteer = std::make_shared<SkidSteerModel>(leftMotor, rightMotor, 100);
+  AsyncMotionProfileController original(createTimeUtil(),
+                                        1.0,
+                                        2.0,
+                                        10.0,
+                                        skidSteer,
+                                        {4_in, 10.5_in},
+                                        AbstractMotor::gearset::green * (1.0 / 2));
+  std::vector<PathFuture> futures;
+  for (const std::string id : {"A", "B", "C"}) {
+    futures.push_back(
+      original.generatePathAsync({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, id));
+  }
+
+  // The paths are still being generated, so the moved controller has to finish them
+  AsyncMotionProfileController moved(std::move(original));
+  for (const auto &future : futures) {
+    future.get();
+  }
+
+  EXPECT_EQ(moved.getPaths(), (std::vector<std::string>{"A", "B", "C"}));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GeneratePathsMatchesGeneratePath) {
+  controller->generatePaths({{"A", {Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}},
+                             {"B", {Point{0_m, 0_m, 0_deg}, Point{2_ft, 1_ft, 45_deg}}},
+                             {"Empty", {}}},
+                            4);
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}, "A serial");
+  controller->generatePath({Point{0_m, 0_m, 0_deg}, Point{2_ft, 1_ft, 45_deg}}, "B serial");
+
+  EXPECT_EQ(controller->getPaths(),
+            (std::vector<std::string>{"A", "A serial", "B", "B serial"}));
+
+  for (const std::string id : {"A", "B"}) {
+    const auto &parallel = *controller->paths.get(controller->paths.find(id));
+    const auto &serial = *controller->paths.get(controller->paths.find(id + " serial"));
+    ASSERT_EQ(parallel.length, serial.length);
+    EXPECT_EQ(std::memcmp(parallel.left.getData(),
+                          serial.left.getData(),
+                          serial.left.getMemoryUsage()),
+              0);
+    EXPECT_EQ(std::memcmp(parallel.right.getData(),
+                          serial.right.getData(),
+                          serial.right.getMemoryUsage()),
+              0);
+  }
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GeneratePathsStopsAtImpossiblePath) {
+  EXPECT_THROW(controller->generatePaths({{"A", {Point{0_m, 0_m, 0_deg}, Point{3_ft, 0_m, 0_deg}}},
+                                          {"B",
+                                           {Point{0_m, 0_m, 0_deg},
+                                            Point{3_ft, 0_m, 0_deg},
+                                            Point{3_ft, 1_ft, 0_deg},
+                                            Point{2_ft, 1_ft, 0_deg},
+                                            Point{1_ft, 1_m, 0_deg},
+                                            Point{1_ft, 0_m, 0_deg}}},
+                                          {"C", {Point{0_m, 0_m, 0_deg}, Point{1_ft, 0_m, 0_deg}}}},
+                                         4),
+               std::runtime_error);
+
+  EXPECT_EQ(controller->getPaths(), std::vector<std::string>{"A"});
+}
@@ -0,0 +1,130 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/compactTrajectory.hpp"
+#include "okapi/api/util/mathUtil.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace okapi;
+
+class CompactTrajectoryTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    for (int i = 0; i < 10; i++) {
+      segments.push_back(
+        Segment{0.01, i + 0.1, i + 0.2, i + 0.3, i + 0.4, i + 0.5, i + 0.6, i + 0.7});
+    }
+  }
+
+  std::vector<Segment> segments;
+};
+
+TEST_F(CompactTrajectoryTest, AllFieldsRoundTrip) {
+  CompactTrajectory trajectory(segments.data(), segments.size(), {});
+
+  EXPECT_EQ(trajectory.size(), segments.size());
+  EXPECT_EQ(trajectory.getDt(), 0.01);
+  for (std::size_t i = 0; i < segments.size(); i++) {
+    const Segment segment = trajectory.getSegment(i);
+    EXPECT_EQ(segment.dt, segments[i].dt);
+    EXPECT_EQ(segment.x, segments[i].x);
+    EXPECT_EQ(segment.y, segments[i].y);
+    EXPECT_EQ(segment.position, segments[i].position);
+    EXPECT_EQ(segment.velocity, segments[i].velocity);
+    EXPECT_EQ(segment.acceleration, segments[i].acceleration);
+    EXPECT_EQ(segment.jerk, segments[i].jerk);
+    EXPECT_EQ(segment.heading, segments[i].heading);
+  }
+
+  EXPECT_EQ(trajectory.getMemoryUsage(), segments.size() * 7 * sizeof(double));
+}
+
+TEST_F(CompactTrajectoryTest, VelocityOnly) {
+  CompactTrajectory trajectory(segments.data(),
+                               segments.size(),
+                               {CompactTrajectory::mask({CompactTrajectory::Field::velocity})});
+
+  EXPECT_TRUE(trajectory.hasField(CompactTrajectory::Field::velocity));
+  EXPECT_FALSE(trajectory.hasField(CompactTrajectory::Field::position));
+  for (std::size_t i = 0; i < segments.size(); i++) {
+    EXPECT_EQ(trajectory.get(CompactTrajectory::Field::velocity, i), segments[i].velocity);
+    EXPECT_EQ(trajectory.get(CompactTrajectory::Field::position, i), 0);
+  }
+
+  EXPECT_EQ(trajectory.getMemoryUsage(), segments.size() * sizeof(double));
+}
+
+TEST_F(CompactTrajectoryTest, Float32) {
+  CompactTrajectory trajectory(
+    segments.data(),
+    segments.size(),
+    {CompactTrajectory::mask(
+       {CompactTrajectory::Field::position, CompactTrajectory::Field::heading}),
+     CompactTrajectory::Precision::float32});
+
+  for (std::size_t i = 0; i < segments.size(); i++) {
+    EXPECT_FLOAT_EQ(trajectory.get(CompactTrajectory::Field::position, i), segments[i].position);
+    EXPECT_FLOAT_EQ(trajectory.get(CompactTrajectory::Field::heading, i), segments[i].heading);
+  }
+
+  EXPECT_EQ(trajectory.getMemoryUsage(), segments.size() * 2 * sizeof(float));
+}
+
+TEST_F(CompactTrajectoryTest, MoveLeavesSourceEmpty) {
+  CompactTrajectory trajectory(segments.data(), segments.size(), {});
+  CompactTrajectory moved(std::move(trajectory));
+
+  EXPECT_EQ(moved.size(), segments.size());
+  EXPECT_EQ(moved.get(CompactTrajectory::Field::jerk, 3), segments[3].jerk);
+  EXPECT_EQ(trajectory.size(), 0);
+  EXPECT_EQ(trajectory.getMemoryUsage(), 0);
+}
+
+TEST_F(CompactTrajectoryTest, InterpolateBetweenSegments) {
+  CompactTrajectory trajectory(segments.data(), segments.size(), {});
+
+  EXPECT_DOUBLE_EQ(trajectory.interpolate(CompactTrajectory::Field::velocity, 2), 2.4);
+  EXPECT_DOUBLE_EQ(trajectory.interpolate(CompactTrajectory::Field::velocity, 2.25), 2.65);
+  EXPECT_DOUBLE_EQ(trajectory.interpolate(CompactTrajectory::Field::velocity, -1), 0.4);
+  EXPECT_DOUBLE_EQ(trajectory.interpolate(CompactTrajectory::Field::velocity, 100), 9.4);
+
+  CompactTrajectory velocityOnly(segments.data(),
+                                 segments.size(),
+                                 {CompactTrajectory::mask({CompactTrajectory::Field::velocity})});
+  EXPECT_EQ(velocityOnly.interpolate(CompactTrajectory::Field::position, 2.5), 0);
+}
+
+TEST_F(CompactTrajectoryTest, InterpolateHeadingAcrossZero) {
+  // Pathfinder headings wrap to [0, 2pi), so a path turning through zero jumps by almost 2pi
+  std::vector<Segment> turning{Segment{0.01, 0, 0, 0, 0, 0, 0, 6.2},
+                               Segment{0.01, 0, 0, 0, 0, 0, 0, 0.1},
+                               Segment{0.01, 0, 0, 0, 0, 0, 0, 6.2}};
+  CompactTrajectory trajectory(turning.data(), turning.size(), {});
+
+  const auto heading = CompactTrajectory::Field::heading;
+  const double step = 0.1 + 2 * pi - 6.2;
+  EXPECT_NEAR(trajectory.interpolate(heading, 0.5), 6.2 + step / 2, 1e-9);
+  EXPECT_NEAR(trajectory.interpolate(heading, 1.25), 0.1 - step / 4, 1e-9);
+}
+
+TEST_F(CompactTrajectoryTest, FindPeakVelocity) {
+  // Speed up, cruise, then slow down
+  const std::vector<double> velocities{0, 0.5, 1, 1, 0.9995, 1, 0.5, 0};
+  std::vector<Segment> profile;
+  for (const double velocity : velocities) {
+    profile.push_back(Segment{0.01, 0, 0, 0, velocity, 0, 0, 0});
+  }
+
+  CompactTrajectory trajectory(profile.data(), profile.size(), {});
+  EXPECT_EQ(trajectory.findPeak(CompactTrajectory::Field::velocity),
+            (std::pair<std::size_t, std::size_t>{2, 5}));
+
+  CompactTrajectory empty(0, 0.01, {});
+  EXPECT_EQ(empty.findPeak(CompactTrajectory::Field::velocity),
+            (std::pair<std::size_t, std::size_t>{0, 0}));
+}
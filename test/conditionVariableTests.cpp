@@ -0,0 +1,55 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/coreProsAPI.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(CrossplatformConditionVariableTest, NotifyWakesWaiter) {
+  CrossplatformMutex mutex;
+  CrossplatformConditionVariable condition;
+  bool ready = false;
+
+  std::thread notifier([&]() {
+    while (!condition.hasWaiters()) {
+      std::this_thread::yield();
+    }
+
+    std::lock_guard<CrossplatformMutex> lock(mutex);
+    ready = true;
+    condition.notifyAll();
+  });
+
+  std::unique_lock<CrossplatformMutex> lock(mutex);
+  condition.wait(lock, [&]() { return ready; });
+  EXPECT_TRUE(ready);
+  EXPECT_FALSE(condition.hasWaiters());
+
+  lock.unlock();
+  notifier.join();
+}
+
+TEST(CrossplatformConditionVariableTest, WaitReturnsImmediatelyIfAlreadyTrue) {
+  CrossplatformMutex mutex;
+  CrossplatformConditionVariable condition;
+
+  std::unique_lock<CrossplatformMutex> lock(mutex);
+  condition.wait(lock, []() { return true; });
+  EXPECT_TRUE(condition.waitFor(lock, 0, []() { return true; }));
+}
+
+TEST(CrossplatformConditionVariableTest, WaitForTimesOut) {
+  CrossplatformMutex mutex;
+  CrossplatformConditionVariable condition;
+
+  std::unique_lock<CrossplatformMutex> lock(mutex);
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(condition.waitFor(lock, 20, []() { return false; }));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+  EXPECT_FALSE(condition.hasWaiters());
+}
@@ -0,0 +1,160 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/chassis/controller/chassisControllerPid.hpp"
+#include "okapi/api/chassis/model/skidSteerModel.hpp"
+#include "okapi/api/control/async/asyncPosPidController.hpp"
+#include "okapi/api/control/util/controlLoopExecutor.hpp"
+#include "test/tests/api/implMocks.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace okapi;
+
+class ControlLoopExecutorTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    executor = std::make_shared<ControlLoopExecutor>(createTimeUtil(), 10_ms);
+  }
+
+  /**
+   * A TimeUtil whose timers always report a full sample time passed, so controllers step on every
+   * tick.
+   */
+  static TimeUtil createSteppingTimeUtil() {
+    return createTimeUtil(Supplier<std::unique_ptr<AbstractTimer>>(
+      []() { return std::make_unique<ConstantMockTimer>(10_ms); }));
+  }
+
+  std::shared_ptr<ControlLoopExecutor> executor;
+};
+
+TEST_F(ControlLoopExecutorTest, LoopsRunInTheOrderTheyWereAdded) {
+  std::vector<int> order;
+  executor->add(10_ms, [&]() { order.push_back(1); });
+  executor->add(10_ms, [&]() { order.push_back(2); });
+  executor->add(10_ms, [&]() { order.push_back(3); });
+
+  executor->tick();
+  executor->tick();
+
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3, 1, 2, 3}));
+}
+
+TEST_F(ControlLoopExecutorTest, LoopsRunAtTheirPeriods) {
+  int fast = 0, slow = 0;
+  executor->add(10_ms, [&]() { fast++; });
+  executor->add(30_ms, [&]() { slow++; });
+
+  for (int i = 0; i < 7; i++) {
+    executor->tick();
+  }
+
+  EXPECT_EQ(fast, 7);
+  // Ticks 0, 3, and 6
+  EXPECT_EQ(slow, 3);
+}
+
+TEST_F(ControlLoopExecutorTest, PeriodWhichIsNotAMultipleThrows) {
+  EXPECT_THROW(executor->add(15_ms, []() {}), std::invalid_argument);
+  EXPECT_THROW(executor->add(0_ms, []() {}), std::invalid_argument);
+  EXPECT_EQ(executor->size(), 0);
+
+  const auto id = executor->add(20_ms, []() {});
+  EXPECT_THROW(executor->setPeriod(id, 5_ms), std::invalid_argument);
+}
+
+TEST_F(ControlLoopExecutorTest, RemovedLoopDoesNotRun) {
+  int count = 0;
+  const auto id = executor->add(10_ms, [&]() { count++; });
+  executor->tick();
+  executor->remove(id);
+  executor->tick();
+
+  EXPECT_EQ(count, 1);
+  EXPECT_EQ(executor->size(), 0);
+}
+
+TEST_F(ControlLoopExecutorTest, AsyncWrapperStepsOnTheExecutor) {
+  auto input = std::make_shared<MockContinuousRotarySensor>();
+  auto output = std::make_shared<MockMotor>();
+  {
+    AsyncPosPIDController controller(input, output, createSteppingTimeUtil(), 0.1, 0, 0);
+    controller.runOn(executor);
+    controller.setTarget(100);
+
+    executor->tick();
+    EXPECT_NE(output->lastVelocity, 0);
+  }
+
+  // The controller unregisters itself when it is destroyed
+  EXPECT_EQ(executor->size(), 0);
+}
+
+TEST_F(ControlLoopExecutorTest, AsyncWrapperIsOnlySettledOnceAStepFindsItSettled) {
+  const TimeUtil timeUtil(
+    Supplier<std::unique_ptr<AbstractTimer>>(
+      []() { return std::make_unique<ConstantMockTimer>(10_ms); }),
+    Supplier<std::unique_ptr<AbstractRate>>([]() { return std::make_unique<MockRate>(); }),
+    Supplier<std::unique_ptr<SettledUtil>>([]() { return createSettledUtilPtr(5, 5, 0_ms); }));
+  AsyncPosPIDController controller(std::make_shared<MockContinuousRotarySensor>(),
+                                   std::make_shared<MockMotor>(),
+                                   timeUtil,
+                                   0.1,
+                                   0,
+                                   0);
+  controller.runOn(executor);
+
+  controller.setTarget(0);
+  EXPECT_FALSE(controller.isSettled());
+  executor->tick();
+  EXPECT_TRUE(controller.isSettled());
+
+  // A new target is not settled until the loop checks it
+  controller.setTarget(100);
+  EXPECT_FALSE(controller.isSettled());
+  executor->tick();
+  EXPECT_FALSE(controller.isSettled());
+}
+
+TEST_F(ControlLoopExecutorTest, AsyncWrapperKeepsItsSampleTimeWhenTheExecutorRejectsIt) {
+  auto pid = new IterativePosPIDController(0.1, 0, 0, 0, createSteppingTimeUtil());
+  AsyncWrapper<double, double> controller(std::make_shared<MockContinuousRotarySensor>(),
+                                          std::make_shared<MockMotor>(),
+                                          std::unique_ptr<IterativePosPIDController>(pid),
+                                          createTimeUtil().getRateSupplier());
+  controller.runOn(executor);
+
+  EXPECT_THROW(controller.setSampleTime(15_ms), std::invalid_argument);
+  EXPECT_EQ(pid->getSampleTime(), 10_ms);
+
+  controller.setSampleTime(20_ms);
+  EXPECT_EQ(pid->getSampleTime(), 20_ms);
+}
+
+TEST_F(ControlLoopExecutorTest, ChassisControllerPIDStepsOnTheExecutor) {
+  auto leftMotor = new MockMotor();
+  auto rightMotor = new MockMotor();
+  auto distanceController = new IterativePosPIDController(0.1, 0, 0, 0, createSteppingTimeUtil());
+
+  ChassisControllerPID controller(
+    createTimeUtil(),
+    std::make_shared<SkidSteerModel>(
+      std::unique_ptr<AbstractMotor>(leftMotor), std::unique_ptr<AbstractMotor>(rightMotor), 100),
+    std::unique_ptr<IterativePosPIDController>(distanceController),
+    std::make_unique<IterativePosPIDController>(0.1, 0, 0, 0, createSteppingTimeUtil()),
+    std::make_unique<IterativePosPIDController>(0.1, 0, 0, 0, createSteppingTimeUtil()),
+    AbstractMotor::gearset::red,
+    ChassisScales({2, 2}));
+  controller.runOn(executor);
+
+  controller.moveDistanceAsync(100);
+  executor->tick();
+
+  EXPECT_NE(distanceController->getOutput(), 0);
+  EXPECT_NE(leftMotor->lastVelocity, 0);
+}
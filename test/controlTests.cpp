@@ -6,6 +6,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include "okapi/api/control/util/flywheelSimulator.hpp"
+#include <cmath>
 #include <gtest/gtest.h>
 
 using namespace okapi;
@@ -20,3 +21,94 @@ TEST(FlywheelSimulatorTest, BasicTest) {
   EXPECT_NEAR(sim.getOmega(), 0.0020193, 0.000005);
   EXPECT_NEAR(sim.getAcceleration(), 20.193, 0.0005);
 }
+
+/**
+ * A link spinning freely against dynamic friction from rest, which has an exact solution.
+ */
+class FlywheelSimulatorIntegratorTest : public ::testing::Test {
+  protected:
+  static constexpr double torque = 0.3;
+  static constexpr double mu = 0.9;
+  static constexpr double inertia = 0.01;
+
+  static double exactOmega(const double itime) {
+    return torque / mu * (1 - std::exp(-mu / inertia * itime));
+  }
+
+  static double exactAngle(const double itime) {
+    return torque / mu * (itime - inertia / mu * (1 - std::exp(-mu / inertia * itime)));
+  }
+
+  static FlywheelSimulator makeSim(const FlywheelSimulator::Integrator iintegrator,
+                                   const double itimestep) {
+    FlywheelSimulator sim(0.01, 1, 0.1, mu, itimestep);
+    sim.setExternalTorqueFunction(nullptr);
+    sim.setIntegrator(iintegrator);
+    sim.setTorque(torque);
+    return sim;
+  }
+};
+
+TEST_F(FlywheelSimulatorIntegratorTest, RK4IsAccurateAtLargeTimesteps) {
+  auto rk4 = makeSim(FlywheelSimulator::Integrator::rk4, 0.005);
+  auto semiImplicit = makeSim(FlywheelSimulator::Integrator::semiImplicitEuler, 0.005);
+  rk4.simulateUntil(0.1);
+  semiImplicit.simulateUntil(0.1);
+
+  EXPECT_NEAR(rk4.getOmega(), exactOmega(0.1), 1e-4);
+  EXPECT_NEAR(rk4.getAngle(), exactAngle(0.1), 1e-4);
+  EXPECT_LT(std::fabs(rk4.getAngle() - exactAngle(0.1)),
+            std::fabs(semiImplicit.getAngle() - exactAngle(0.1)));
+}
+
+TEST_F(FlywheelSimulatorIntegratorTest, SemiImplicitEulerConvergesAsTimestepShrinks) {
+  auto coarse = makeSim(FlywheelSimulator::Integrator::semiImplicitEuler, 0.005);
+  auto fine = makeSim(FlywheelSimulator::Integrator::semiImplicitEuler, 0.0005);
+  coarse.simulateUntil(0.1);
+  fine.simulateUntil(0.1);
+
+  const double coarseError = std::fabs(coarse.getAngle() - exactAngle(0.1));
+  const double fineError = std::fabs(fine.getAngle() - exactAngle(0.1));
+  EXPECT_LT(fineError, coarseError / 5);
+  EXPECT_NEAR(fine.getOmega(), exactOmega(0.1), 1e-3);
+}
+
+TEST_F(FlywheelSimulatorIntegratorTest, StepNMatchesRepeatedSteps) {
+  for (const auto integrator : {FlywheelSimulator::Integrator::euler,
+                                FlywheelSimulator::Integrator::semiImplicitEuler,
+                                FlywheelSimulator::Integrator::rk4}) {
+    auto batch = makeSim(integrator, 0.001);
+    auto single = makeSim(integrator, 0.001);
+
+    batch.stepN(50);
+    for (int i = 0; i < 50; i++) {
+      single.step();
+    }
+
+    EXPECT_DOUBLE_EQ(batch.getAngle(), single.getAngle());
+    EXPECT_DOUBLE_EQ(batch.getOmega(), single.getOmega());
+    EXPECT_NEAR(batch.getTime(), single.getTime(), 1e-12);
+  }
+}
+
+TEST_F(FlywheelSimulatorIntegratorTest, SimulateUntilStopsAtTheTime) {
+  auto sim = makeSim(FlywheelSimulator::Integrator::rk4, 0.001);
+  sim.simulateUntil(0.25);
+  EXPECT_NEAR(sim.getTime(), 0.25, 1e-9);
+
+  const double angle = sim.getAngle();
+  sim.simulateUntil(0.1);
+  EXPECT_EQ(sim.getAngle(), angle);
+  EXPECT_NEAR(sim.getTime(), 0.25, 1e-9);
+}
+
+TEST_F(FlywheelSimulatorIntegratorTest, NoTorqueFunctionMatchesZeroTorque) {
+  auto none = makeSim(FlywheelSimulator::Integrator::rk4, 0.001);
+  auto zero = makeSim(FlywheelSimulator::Integrator::rk4, 0.001);
+  zero.setExternalTorqueFunction([](double, double, double) { return 0; });
+
+  none.stepN(100);
+  zero.stepN(100);
+  EXPECT_EQ(none.getAngle(), zero.getAngle());
+  EXPECT_EQ(none.getOmega(), zero.getOmega());
+}
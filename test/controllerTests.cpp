@@ -20,9 +20,12 @@
 #include "okapi/api/filter/passthroughFilter.hpp"
 #include "okapi/api/filter/velMath.hpp"
 #include "okapi/api/util/mathUtil.hpp"
+#include "okapi/api/util/virtualClock.hpp"
 #include "test/tests/api/implMocks.hpp"
+#include <cstdio>
 #include <gtest/gtest.h>
 #include <limits>
+#include <stdexcept>
 
 using namespace okapi;
 
@@ -120,15 +123,228 @@ TEST(PIDTunerTest, AutotuneShouldNotSegfault) {
   FlywheelSimulator simulator;
   simulator.setExternalTorqueFunction([](double, double, double) { return 0; });
 
-  auto system = std::make_shared<SimulatedSystem>(simulator);
+  // The system and the tuner run in simulated time
+  auto clock = std::make_shared<VirtualClock>(2);
+  auto system = std::make_shared<SimulatedSystem>(simulator, clock->createRate());
   system->startThread();
 
-  PIDTuner pidTuner(system, system, createTimeUtil(), 100_ms, 100, 0, 10, 0, 10, 0, 10);
-  pidTuner.autotune();
+  {
+    // The tuner's rate keeps this thread in the simulation until the tuner is destroyed
+    PIDTuner pidTuner(system, system, clock->createTimeUtil(), 100_ms, 100, 0, 10, 0, 10, 0, 10);
+    pidTuner.autotune();
+  }
 
   system->join(); // gtest will cause a SIGABRT if we don't join manually first
 }
 
+class FlywheelPlant : public PIDTuner::Plant {
+  public:
+  FlywheelPlant() {
+    simulator.setExternalTorqueFunction([](double, double, double) { return 0; });
+  }
+
+  double controllerGet() override {
+    return simulator.getAngle();
+  }
+
+  void controllerSet(double ivalue) override {
+    simulator.setTorque(ivalue);
+  }
+
+  void step() override {
+    simulator.step();
+  }
+
+  FlywheelSimulator simulator;
+};
+
+static PIDTuner::Output autotuneFlywheel(const std::size_t ithreads) {
+  auto unused = std::make_shared<MockMotor>();
+  PIDTuner pidTuner(
+    unused->getEncoder(), unused, createTimeUtil(), 1_s, 100, 0, 10, 0, 10, 0, 10, 3, 8);
+  pidTuner.setSeed(42);
+  return pidTuner.autotune(
+    Supplier<std::unique_ptr<PIDTuner::Plant>>([]() { return std::make_unique<FlywheelPlant>(); }),
+    ithreads);
+}
+
+TEST(PIDTunerTest, SimulatedAutotuneIsReproducible) {
+  const PIDTuner::Output serial = autotuneFlywheel(1);
+  const PIDTuner::Output parallel = autotuneFlywheel(4);
+
+  EXPECT_EQ(serial.kP, parallel.kP);
+  EXPECT_EQ(serial.kI, parallel.kI);
+  EXPECT_EQ(serial.kD, parallel.kD);
+  EXPECT_GE(serial.kP, 0);
+  EXPECT_LE(serial.kP, 10);
+}
+
+/**
+ * A motor turning a load. The speed lags the command with a 100 ms time constant.
+ */
+class MotorPlant : public PIDTuner::Plant {
+  public:
+  double controllerGet() override {
+    return position;
+  }
+
+  void controllerSet(double ivalue) override {
+    command = ivalue;
+  }
+
+  void step() override {
+    speed += (command * 1000 - speed) * 0.1;
+    position += speed * 0.01;
+  }
+
+  double command{0};
+  double speed{0};
+  double position{0};
+};
+
+class PIDTunerStrategyTest : public ::testing::Test {
+  protected:
+  void TearDown() override {
+    std::remove(filename.c_str());
+  }
+
+  std::unique_ptr<PIDTuner> makeTuner(const PIDTuner::Strategy istrategy) {
+    auto tuner = std::make_unique<PIDTuner>(
+      unused->getEncoder(), unused, createTimeUtil(), 3_s, 500, 0, 0.02, 0, 0.001, 0, 0.05);
+    tuner->setSeed(1);
+    tuner->setStrategy(istrategy);
+    return tuner;
+  }
+
+  static PIDTuner::Output autotune(PIDTuner &ituner) {
+    return ituner.autotune(Supplier<std::unique_ptr<PIDTuner::Plant>>(
+      []() { return std::make_unique<MotorPlant>(); }));
+  }
+
+  static double bestError(const PIDTuner &ituner) {
+    double best = std::numeric_limits<double>::max();
+    for (const auto &trial : ituner.getTrials()) {
+      best = std::min(best, trial.error);
+    }
+    return best;
+  }
+
+  const std::string filename{"pid_tuner_trials.txt"};
+  std::shared_ptr<MockMotor> unused{std::make_shared<MockMotor>()};
+};
+
+TEST_F(PIDTunerStrategyTest, TrustRegionNeedsFewerTests) {
+  auto swarm = makeTuner(PIDTuner::Strategy::particleSwarm);
+  autotune(*swarm);
+
+  auto trustRegion = makeTuner(PIDTuner::Strategy::trustRegion);
+  autotune(*trustRegion);
+
+  EXPECT_EQ(swarm->getTrials().size(), 80);
+  EXPECT_LT(trustRegion->getTrials().size(), swarm->getTrials().size());
+  EXPECT_LE(bestError(*trustRegion), bestError(*swarm));
+}
+
+TEST_F(PIDTunerStrategyTest, TrustRegionStartsFromLoadedTrials) {
+  auto first = makeTuner(PIDTuner::Strategy::trustRegion);
+  const PIDTuner::Output firstGains = autotune(*first);
+  ASSERT_TRUE(first->saveTrials(filename));
+
+  auto second = makeTuner(PIDTuner::Strategy::trustRegion);
+  ASSERT_TRUE(second->loadTrials(filename));
+  const std::size_t loaded = second->getTrials().size();
+  EXPECT_EQ(loaded, first->getTrials().size());
+  autotune(*second);
+
+  // The first new test is the best loaded gains
+  const PIDTuner::Trial resumed = second->getTrials().at(loaded);
+  EXPECT_DOUBLE_EQ(resumed.gains.kP, firstGains.kP);
+  EXPECT_DOUBLE_EQ(resumed.gains.kI, firstGains.kI);
+  EXPECT_DOUBLE_EQ(resumed.gains.kD, firstGains.kD);
+  EXPECT_LT(second->getTrials().size() - loaded, loaded);
+  EXPECT_LE(bestError(*second), bestError(*first));
+}
+
+TEST_F(PIDTunerStrategyTest, InvalidTrialsFileIsRejected) {
+  FILE *file = fopen(filename.c_str(), "w");
+  fprintf(file, "not trials\n");
+  fclose(file);
+
+  auto tuner = makeTuner(PIDTuner::Strategy::trustRegion);
+  EXPECT_FALSE(tuner->loadTrials(filename));
+  EXPECT_FALSE(tuner->loadTrials("missing_trials.txt"));
+  EXPECT_TRUE(tuner->getTrials().empty());
+}
+
+/**
+ * A system which never moves.
+ */
+class StuckPlant : public PIDTuner::Plant {
+  public:
+  double controllerGet() override {
+    return 0;
+  }
+
+  void controllerSet(double) override {
+  }
+
+  void step() override {
+  }
+};
+
+TEST_F(PIDTunerStrategyTest, RelayFindsUltimateGainAndPeriod) {
+  auto tuner = makeTuner(PIDTuner::Strategy::particleSwarm);
+  const auto supplier =
+    Supplier<std::unique_ptr<PIDTuner::Plant>>([]() { return std::make_unique<MotorPlant>(); });
+
+  const auto tl = tuner->relayAutotune(supplier, PIDTuner::RelayRule::tyreusLuyben, 0.1);
+  const auto zn = tuner->relayAutotune(supplier, PIDTuner::RelayRule::zieglerNichols, 0.1);
+  EXPECT_GT(tl.ultimateGain, 0);
+  EXPECT_GT(tl.ultimatePeriod, 0_ms);
+  EXPECT_DOUBLE_EQ(tl.ultimateGain, zn.ultimateGain);
+  EXPECT_EQ(tl.ultimatePeriod, zn.ultimatePeriod);
+
+  // Tyreus-Luyben is gentler than Ziegler-Nichols
+  EXPECT_DOUBLE_EQ(tl.gains.kP, tl.ultimateGain / 2.2);
+  EXPECT_DOUBLE_EQ(zn.gains.kP, zn.ultimateGain * 0.6);
+  EXPECT_LT(tl.gains.kP, zn.gains.kP);
+  EXPECT_LT(tl.gains.kI, zn.gains.kI);
+  EXPECT_GT(tl.gains.kD, 0);
+
+  // The gains should move the motor to the goal and hold it there
+  auto clock = std::make_shared<VirtualClock>();
+  auto rate = clock->createRate();
+  IterativePosPIDController controller(
+    tl.gains.kP, tl.gains.kI, tl.gains.kD, 0, clock->createTimeUtil());
+  controller.setTarget(500);
+  MotorPlant plant;
+  for (int i = 0; i < 200; i++) {
+    plant.controllerSet(controller.step(plant.controllerGet()));
+    plant.step();
+    rate->delayUntil(10_ms);
+  }
+
+  EXPECT_NEAR(plant.position, 500, 5);
+}
+
+TEST_F(PIDTunerStrategyTest, RelayWithoutOscillationFails) {
+  auto tuner = makeTuner(PIDTuner::Strategy::particleSwarm);
+  const auto result = tuner->relayAutotune(
+    Supplier<std::unique_ptr<PIDTuner::Plant>>([]() { return std::make_unique<StuckPlant>(); }));
+
+  EXPECT_EQ(result.ultimateGain, 0);
+  EXPECT_EQ(result.ultimatePeriod, 0_ms);
+  EXPECT_EQ(result.gains.kP, 0);
+  EXPECT_EQ(result.gains.kI, 0);
+  EXPECT_EQ(result.gains.kD, 0);
+}
+
+TEST_F(PIDTunerStrategyTest, RelayNeedsTwoCycles) {
+  auto tuner = makeTuner(PIDTuner::Strategy::particleSwarm);
+  EXPECT_THROW(tuner->relayAutotune(PIDTuner::RelayRule::tyreusLuyben, 1, 0, 1),
+               std::invalid_argument);
+}
+
 TEST(SettledUtilTest, MaxDoubleError) {
   MockRate rate;
   SettledUtil settledUtil(
@@ -0,0 +1,62 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/async/asyncMotionProfileController.hpp"
+#include "okapi/api/util/parallelFor.hpp"
+#include "test/tests/api/implMocks.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace okapi;
+
+/**
+ * Times AsyncMotionProfileController::generatePaths on the same batch of paths with 1 to N worker
+ * threads. N is the first argument, or at least 4 and at least the number of hardware threads.
+ * Each thread count is timed a few times and the fastest run is printed.
+ */
+int main(int argc, char **argv) {
+  const std::size_t maxThreads =
+    argc > 1 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[1])))
+             : std::max<std::size_t>(4, defaultThreadCount());
+  constexpr int runs = 3;
+
+  AsyncMotionProfileController controller(
+    createTimeUtil(),
+    1.0,
+    2.0,
+    10.0,
+    std::make_shared<SkidSteerModel>(
+      std::make_shared<MockMotor>(), std::make_shared<MockMotor>(), 100),
+    {4_in, 10.5_in},
+    AbstractMotor::gearset::green * (1.0 / 2));
+
+  std::cout << "Generating 8 paths, fastest of " << runs << " runs" << std::endl;
+  for (std::size_t threads = 1; threads <= maxThreads; threads++) {
+    auto fastest = std::chrono::steady_clock::duration::max();
+    for (int run = 0; run < runs; run++) {
+      const auto start = std::chrono::steady_clock::now();
+      controller.generatePaths({{"0", {Point{0_m, 0_m, 0_deg}, Point{4_ft, 0_m, 0_deg}}},
+                                {"1", {Point{0_m, 0_m, 0_deg}, Point{4_ft, 1_ft, 0_deg}}},
+                                {"2", {Point{0_m, 0_m, 0_deg}, Point{4_ft, 2_ft, 0_deg}}},
+                                {"3", {Point{0_m, 0_m, 0_deg}, Point{4_ft, 3_ft, 0_deg}}},
+                                {"4", {Point{0_m, 0_m, 0_deg}, Point{5_ft, 0_m, 0_deg}}},
+                                {"5", {Point{0_m, 0_m, 0_deg}, Point{5_ft, 1_ft, 0_deg}}},
+                                {"6", {Point{0_m, 0_m, 0_deg}, Point{5_ft, 2_ft, 0_deg}}},
+                                {"7", {Point{0_m, 0_m, 0_deg}, Point{5_ft, 3_ft, 0_deg}}}},
+                               threads);
+      fastest = std::min(fastest, std::chrono::steady_clock::now() - start);
+    }
+
+    std::cout << threads << " workers: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(fastest).count() << " ms"
+              << std::endl;
+  }
+
+  return 0;
+}
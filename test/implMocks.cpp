@@ -281,7 +281,15 @@ void MockRate::delayUntil(QTime itime) {
 }
 
 void MockRate::delayUntil(uint32_t ims) {
+  const std::uint32_t start = now();
   std::this_thread::sleep_for(std::chrono::milliseconds(ims));
+  recordDelay(start, start + ims, now());
+}
+
+std::uint32_t MockRate::now() {
+  return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      std::chrono::steady_clock::now().time_since_epoch())
+                                      .count());
 }
 
 std::unique_ptr<SettledUtil> createSettledUtilPtr(const double iatTargetError,
@@ -320,7 +328,9 @@ TimeUtil createTimeUtil(const Supplier<std::unique_ptr<SettledUtil>> &isettledUt
     isettledUtilSupplier);
 }
 
-SimulatedSystem::SimulatedSystem(FlywheelSimulator &isimulator) : simulator(isimulator) {
+SimulatedSystem::SimulatedSystem(FlywheelSimulator &isimulator,
+                                 std::unique_ptr<AbstractRate> irate)
+  : simulator(isimulator), rate(std::move(irate)) {
 }
 
 SimulatedSystem::~SimulatedSystem() {
@@ -338,7 +348,7 @@ void SimulatedSystem::controllerSet(double ivalue) {
 void SimulatedSystem::step() {
   while (!dtorCalled.load(std::memory_order_acquire)) {
     simulator.step();
-    rate.delayUntil(10_ms);
+    rate->delayUntil(10_ms);
   }
 }
 
@@ -5,9 +5,14 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
+#include "okapi/api/util/asyncLogWriter.hpp"
 #include "okapi/api/util/logging.hpp"
 #include "test/tests/api/implMocks.hpp"
+#include <algorithm>
+#include <atomic>
 #include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 
 using namespace okapi;
 
@@ -139,3 +144,141 @@ TEST_F(LoggerTest, DebugLevel) {
     free(line);
   }
 }
+
+TEST_F(LoggerTest, InfoLevelDoesNotLogDebug) {
+  Logger::initialize(std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::info);
+  EXPECT_TRUE(Logger::isEnabled(Logger::LogLevel::info));
+  EXPECT_FALSE(Logger::isEnabled(Logger::LogLevel::debug));
+
+  Logger::instance()->debug("MSG");
+  fflush(logFile);
+  EXPECT_EQ(logSize, 0);
+}
+
+TEST_F(LoggerTest, FormattedMessage) {
+  Logger::initialize(std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::info);
+  Logger::instance()->info("Set target to %f, path %s", 1.5, std::string("A"));
+
+  char *line = nullptr;
+  size_t len;
+
+  getline(&line, &len, logFile);
+  EXPECT_STREQ(line, "0 INFO: Set target to 1.500000, path A\n");
+
+  if (line) {
+    free(line);
+  }
+}
+
+TEST_F(LoggerTest, LongFormattedMessageIsNotTruncated) {
+  Logger::initialize(std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::info);
+  const std::string path(300, 'a');
+  Logger::instance()->info("Path %s", path);
+  fflush(logFile);
+
+  EXPECT_EQ(std::string(logBuffer), "0 INFO: Path " + path + "\n");
+}
+
+TEST_F(LoggerTest, DeferredArgumentIsOnlyCalledWhenLogged) {
+  Logger::initialize(std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::warn);
+  auto logger = Logger::instance();
+
+  int calls = 0;
+  auto name = [&]() {
+    calls++;
+    return std::string("A");
+  };
+
+  logger->info("Running with path: %s", name);
+  EXPECT_EQ(calls, 0);
+
+  logger->warn("Running with path: %s", name);
+  EXPECT_EQ(calls, 1);
+
+  char *line = nullptr;
+  size_t len;
+
+  getline(&line, &len, logFile);
+  EXPECT_STREQ(line, "0 WARN: Running with path: A\n");
+
+  if (line) {
+    free(line);
+  }
+}
+
+TEST_F(LoggerTest, AsyncWriterWritesEverythingOnClose) {
+  Logger::initialize(std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::info);
+  Logger::startAsyncWriter(std::make_unique<MockRate>());
+  auto logger = Logger::instance();
+
+  logger->error("MSG");
+  logger->info("Count %d", 2);
+  Logger::flush();
+
+  EXPECT_EQ(std::string(logBuffer), "0 ERROR: MSG\n0 INFO: Count 2\n");
+  EXPECT_EQ(Logger::getDroppedMessages(), 0);
+}
+
+TEST_F(LoggerTest, AsyncWriterCanBeStoppedWhileLogging) {
+  Logger::initialize(std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::info);
+  auto logger = Logger::instance();
+
+  std::atomic_bool done{false};
+  std::vector<std::thread> loggers;
+  for (int i = 0; i < 2; i++) {
+    loggers.emplace_back([&]() {
+      while (!done.load()) {
+        logger->info("MSG");
+      }
+    });
+  }
+
+  for (int i = 0; i < 50; i++) {
+    Logger::startAsyncWriter(std::make_unique<MockRate>());
+    Logger::stopAsyncWriter();
+  }
+
+  done.store(true);
+  for (auto &thread : loggers) {
+    thread.join();
+  }
+
+  Logger::flush();
+  EXPECT_GT(std::count(logBuffer, logBuffer + logSize, '\n'), 0);
+}
+
+TEST(AsyncLogWriterTest, FullQueueDropsRecords) {
+  char *buffer;
+  size_t size;
+  FILE *file = open_memstream(&buffer, &size);
+
+  {
+    // The writer task is not started, so nothing drains the queue until the writer is destroyed
+    AsyncLogWriter writer(file, std::make_unique<MockRate>());
+    for (std::size_t i = 0; i < AsyncLogWriter::queueLength + 3; i++) {
+      writer.push(static_cast<std::uint32_t>(i), "INFO", "MSG");
+    }
+
+    EXPECT_EQ(writer.getDropped(), 3);
+  }
+
+  fclose(file);
+  EXPECT_EQ(std::count(buffer, buffer + size, '\n'), AsyncLogWriter::queueLength);
+  free(buffer);
+}
+
+TEST(AsyncLogWriterTest, LongMessageIsTruncated) {
+  char *buffer;
+  size_t size;
+  FILE *file = open_memstream(&buffer, &size);
+
+  AsyncLogWriter writer(file, std::make_unique<MockRate>());
+  writer.push(5, "WARN", std::string(500, 'a'));
+  writer.flush();
+
+  EXPECT_EQ(std::string(buffer),
+            "5 WARN: " + std::string(AsyncLogWriter::maxMessageLength, 'a') + "\n");
+
+  fclose(file);
+  free(buffer);
+}
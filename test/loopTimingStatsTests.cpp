@@ -0,0 +1,124 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/abstractRate.hpp"
+#include "okapi/api/util/loopTimingStats.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace okapi;
+
+/**
+ * A rate on a simulated clock which wakes up a fixed time late, like a task which is not scheduled
+ * right away.
+ */
+class LateRate : public AbstractRate {
+  public:
+  void delay(QFrequency ihz) override {
+    delayUntil(1000 / ihz.convert(Hz));
+  }
+
+  void delay(int ihz) override {
+    delayUntil(1000 / ihz);
+  }
+
+  void delayUntil(QTime itime) override {
+    delayUntil(itime.convert(millisecond));
+  }
+
+  void delayUntil(std::uint32_t ims) override {
+    if (lastTime == 0) {
+      lastTime = now;
+    }
+
+    const std::uint32_t start = now;
+    lastTime += ims;
+    now = std::max(now, lastTime) + lateness;
+    recordDelay(start, lastTime, now);
+  }
+
+  std::uint32_t now{1000};
+  std::uint32_t lastTime{0};
+  std::uint32_t lateness{0};
+};
+
+TEST(LoopTimingStatsTest, EmptyStatsAreZero) {
+  LoopTimingStats stats;
+  EXPECT_EQ(stats.getWakeups(), 0);
+  EXPECT_EQ(stats.getMisses(), 0);
+  EXPECT_EQ(stats.getMinJitter(), 0_ms);
+  EXPECT_EQ(stats.getMeanJitter(), 0_ms);
+  EXPECT_EQ(stats.getMaxJitter(), 0_ms);
+  EXPECT_EQ(stats.getP99Jitter(), 0_ms);
+}
+
+TEST(LoopTimingStatsTest, JitterSummary) {
+  LoopTimingStats stats;
+  for (int i = 0; i < 99; i++) {
+    stats.recordWakeup(1_ms);
+  }
+  stats.recordWakeup(50_ms);
+
+  EXPECT_EQ(stats.getWakeups(), 100);
+  EXPECT_DOUBLE_EQ(stats.getMinJitter().convert(millisecond), 1);
+  EXPECT_DOUBLE_EQ(stats.getMeanJitter().convert(millisecond), 1.49);
+  EXPECT_DOUBLE_EQ(stats.getMaxJitter().convert(millisecond), 50);
+
+  // 99 of the wakeups were in the [1, 2) ms bucket
+  EXPECT_DOUBLE_EQ(stats.getP99Jitter().convert(millisecond), 2);
+  // Jitter past the end of the histogram reports the largest jitter
+  EXPECT_DOUBLE_EQ(stats.getJitterPercentile(1).convert(millisecond), 50);
+}
+
+TEST(LoopTimingStatsTest, MissCallsTheCallback) {
+  std::vector<double> misses;
+  LoopTimingStats stats([&](QTime ilateness) { misses.push_back(ilateness.convert(millisecond)); });
+  stats.recordMiss(3_ms);
+  stats.recordMiss(7_ms);
+
+  EXPECT_EQ(stats.getMisses(), 2);
+  EXPECT_EQ(misses, std::vector<double>({3, 7}));
+
+  stats.reset();
+  EXPECT_EQ(stats.getMisses(), 0);
+}
+
+TEST(LoopTimingStatsTest, RateRecordsWakeupJitter) {
+  auto stats = std::make_shared<LoopTimingStats>();
+  LateRate rate;
+  rate.trackDeadlines(stats);
+  EXPECT_EQ(rate.getTimingStats(), stats);
+
+  rate.lateness = 2;
+  for (int i = 0; i < 5; i++) {
+    rate.delayUntil(10_ms);
+  }
+
+  EXPECT_EQ(stats->getWakeups(), 5);
+  EXPECT_EQ(stats->getMisses(), 0);
+  EXPECT_DOUBLE_EQ(stats->getMaxJitter().convert(millisecond), 2);
+}
+
+TEST(LoopTimingStatsTest, RateRecordsOverrunAsMiss) {
+  auto stats = std::make_shared<LoopTimingStats>();
+  LateRate rate;
+  rate.trackDeadlines(stats);
+
+  rate.delayUntil(10_ms);
+  // The loop body runs for longer than the period
+  rate.now += 15;
+  rate.delayUntil(10_ms);
+
+  EXPECT_EQ(stats->getMisses(), 1);
+  EXPECT_DOUBLE_EQ(stats->getMaxJitter().convert(millisecond), 5);
+}
+
+TEST(LoopTimingStatsTest, RateWithoutStatsDoesNotRecord) {
+  LateRate rate;
+  rate.delayUntil(10_ms);
+  EXPECT_EQ(rate.getTimingStats(), nullptr);
+}
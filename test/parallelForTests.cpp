@@ -0,0 +1,42 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/parallelFor.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace okapi;
+
+TEST(ParallelForTest, EveryIndexIsCalledOnce) {
+  for (std::size_t threads = 1; threads <= 4; threads++) {
+    std::vector<std::atomic_int> calls(100);
+    parallelFor(calls.size(), threads, [&](const std::size_t i) { calls[i]++; });
+
+    for (const auto &count : calls) {
+      EXPECT_EQ(count.load(), 1);
+    }
+  }
+}
+
+TEST(ParallelForTest, MoreThreadsThanIndices) {
+  std::vector<std::atomic_int> calls(2);
+  parallelFor(calls.size(), 8, [&](const std::size_t i) { calls[i]++; });
+
+  EXPECT_EQ(calls[0].load(), 1);
+  EXPECT_EQ(calls[1].load(), 1);
+}
+
+TEST(ParallelForTest, NoIndices) {
+  bool called = false;
+  parallelFor(0, 4, [&](std::size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(ParallelForTest, DefaultThreadCountIsPositive) {
+  EXPECT_GE(defaultThreadCount(), 1);
+}
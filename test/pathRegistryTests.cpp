@@ -0,0 +1,88 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/pathRegistry.hpp"
+#include <gtest/gtest.h>
+
+using namespace okapi;
+
+TEST(PathRegistryTest, DefaultHandleIsInvalid) {
+  PathRegistry<int> registry;
+  EXPECT_FALSE(PathHandle().isValid());
+  EXPECT_EQ(registry.get(PathHandle()), nullptr);
+  EXPECT_FALSE(registry.set(PathHandle(), std::make_shared<int>(1)));
+}
+
+TEST(PathRegistryTest, NameIsInternedOnce) {
+  PathRegistry<int> registry;
+  const PathHandle a = registry.intern("A");
+  EXPECT_TRUE(a.isValid());
+  EXPECT_EQ(registry.intern("A"), a);
+  EXPECT_EQ(registry.find("A"), a);
+  EXPECT_NE(registry.intern("B"), a);
+  EXPECT_EQ(registry.getName(a), "A");
+}
+
+TEST(PathRegistryTest, FindUnknownNameIsInvalid) {
+  PathRegistry<int> registry;
+  EXPECT_FALSE(registry.find("A").isValid());
+
+  // Finding does not reserve a slot
+  EXPECT_FALSE(registry.find("A").isValid());
+}
+
+TEST(PathRegistryTest, SetAndGetPath) {
+  PathRegistry<int> registry;
+  const PathHandle a = registry.intern("A");
+  EXPECT_EQ(registry.get(a), nullptr);
+
+  EXPECT_TRUE(registry.set(a, std::make_shared<int>(1)));
+  EXPECT_EQ(*registry.get(a), 1);
+
+  EXPECT_TRUE(registry.set(a, std::make_shared<int>(2)));
+  EXPECT_EQ(*registry.get(a), 2);
+}
+
+TEST(PathRegistryTest, NamedHandleStaysValidAfterRemove) {
+  PathRegistry<int> registry;
+  const PathHandle a = registry.intern("A");
+  registry.set(a, std::make_shared<int>(1));
+
+  const auto held = registry.get(a);
+  registry.remove(a);
+  EXPECT_EQ(registry.get(a), nullptr);
+  EXPECT_EQ(*held, 1);
+
+  EXPECT_TRUE(registry.set(a, std::make_shared<int>(2)));
+  EXPECT_EQ(registry.intern("A"), a);
+  EXPECT_EQ(*registry.get(a), 2);
+}
+
+TEST(PathRegistryTest, UnnamedHandleIsStaleAfterRemove) {
+  PathRegistry<int> registry;
+  const PathHandle first = registry.create();
+  registry.set(first, std::make_shared<int>(1));
+  registry.remove(first);
+
+  // The slot is reused, but the old handle does not refer to the new path
+  const PathHandle second = registry.create();
+  EXPECT_NE(second, first);
+  registry.set(second, std::make_shared<int>(2));
+  EXPECT_EQ(registry.get(first), nullptr);
+  EXPECT_FALSE(registry.set(first, std::make_shared<int>(3)));
+  EXPECT_EQ(*registry.get(second), 2);
+}
+
+TEST(PathRegistryTest, GetNamesOnlyListsSavedPaths) {
+  PathRegistry<int> registry;
+  registry.set(registry.intern("B"), std::make_shared<int>(1));
+  registry.set(registry.intern("A"), std::make_shared<int>(2));
+  registry.intern("C");
+  registry.set(registry.create(), std::make_shared<int>(3));
+
+  EXPECT_EQ(registry.getNames(), (std::vector<std::string>{"A", "B"}));
+}
@@ -0,0 +1,329 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/parallelFor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+extern "C" {
+#include "okapi/pathfinder/include/pathfinder.h"
+}
+
+class PathfinderSplineTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    pf_fit_hermite_cubic(Waypoint{0, 0, 0}, Waypoint{1, 0.5, d2r(45)}, &spline);
+  }
+
+  Spline spline;
+};
+
+TEST_F(PathfinderSplineTest, TableDistanceMatchesIntegratedDistance) {
+  Spline copy = spline;
+  std::vector<double> table(pf_spline_table_length(PATHFINDER_SAMPLES_FAST));
+
+  EXPECT_EQ(pf_spline_distance_table(&spline, PATHFINDER_SAMPLES_FAST, table.data()),
+            pf_spline_distance(&copy, PATHFINDER_SAMPLES_FAST));
+}
+
+TEST_F(PathfinderSplineTest, TableProgressMatchesIntegratedProgress) {
+  std::vector<double> table(pf_spline_table_length(PATHFINDER_SAMPLES_FAST));
+  const double length = pf_spline_distance_table(&spline, PATHFINDER_SAMPLES_FAST, table.data());
+
+  int cursor = 0;
+  for (int i = 0; i <= 200; i++) {
+    const double distance = length * 1.01 * i / 200;
+    EXPECT_EQ(pf_spline_progress_for_distance_table(
+                spline, table.data(), distance, PATHFINDER_SAMPLES_FAST, &cursor),
+              pf_spline_progress_for_distance(spline, distance, PATHFINDER_SAMPLES_FAST));
+  }
+}
+
+TEST_F(PathfinderSplineTest, TableProgressWorksWithoutCursor) {
+  std::vector<double> table(pf_spline_table_length(PATHFINDER_SAMPLES_FAST));
+  const double length = pf_spline_distance_table(&spline, PATHFINDER_SAMPLES_FAST, table.data());
+
+  EXPECT_EQ(
+    pf_spline_progress_for_distance_table(
+      spline, table.data(), length / 3, PATHFINDER_SAMPLES_FAST, nullptr),
+    pf_spline_progress_for_distance(spline, length / 3, PATHFINDER_SAMPLES_FAST));
+}
+
+TEST_F(PathfinderSplineTest, TableWithManySamplesMatchesIntegratedProgress) {
+  // The table keeps a bounded number of checkpoints however many samples are used
+  const int length = pf_spline_table_length(PATHFINDER_SAMPLES_HIGH);
+  EXPECT_LE(length, PATHFINDER_TABLE_CHECKPOINTS + 1);
+
+  std::vector<double> table(length);
+  Spline copy = spline;
+  const double distance = pf_spline_distance_table(&spline, PATHFINDER_SAMPLES_HIGH, table.data());
+  EXPECT_EQ(distance, pf_spline_distance(&copy, PATHFINDER_SAMPLES_HIGH));
+
+  int cursor = 0;
+  for (int i = 0; i <= 50; i++) {
+    const double target = distance * 1.01 * i / 50;
+    EXPECT_EQ(pf_spline_progress_for_distance_table(
+                spline, table.data(), target, PATHFINDER_SAMPLES_HIGH, &cursor),
+              pf_spline_progress_for_distance(spline, target, PATHFINDER_SAMPLES_HIGH));
+  }
+}
+
+TEST_F(PathfinderSplineTest, GaussDistanceMatchesTrapezoidDistance) {
+  Spline gauss = spline;
+  Spline trapezoid = spline;
+
+  // The trapezoid rule carries an error of about one sample width
+  EXPECT_NEAR(pf_spline_distance(&gauss, PATHFINDER_SAMPLES_GAUSS),
+              pf_spline_distance(&trapezoid, PATHFINDER_SAMPLES_HIGH),
+              1e-4);
+  EXPECT_EQ(gauss.arc_length, pf_spline_distance_gauss(&gauss, 1e-9));
+}
+
+TEST_F(PathfinderSplineTest, GaussProgressMatchesTrapezoidProgress) {
+  Spline gauss = spline;
+  const double length = pf_spline_distance(&gauss, PATHFINDER_SAMPLES_GAUSS);
+
+  double lastT = 0;
+  double lastDistance = 0;
+  for (int i = 0; i <= 50; i++) {
+    const double distance = length * i / 50;
+    const double progress =
+      pf_spline_progress_for_distance_gauss(gauss, distance, 1e-9, &lastT, &lastDistance);
+
+    EXPECT_NEAR(progress,
+                pf_spline_progress_for_distance(spline, distance, PATHFINDER_SAMPLES_HIGH),
+                1e-4);
+    EXPECT_NEAR(pf_spline_arc_length_gauss(&gauss, 0, progress, 1e-9), distance, 1e-8);
+  }
+}
+
+TEST_F(PathfinderSplineTest, GaussProgressIsSelectableWithSampleCount) {
+  Spline gauss = spline;
+  const double length = pf_spline_distance(&gauss, PATHFINDER_SAMPLES_GAUSS);
+
+  EXPECT_EQ(pf_spline_progress_for_distance(spline, length / 2, PATHFINDER_SAMPLES_GAUSS),
+            pf_spline_progress_for_distance_gauss(gauss, length / 2, 1e-9, nullptr, nullptr));
+}
+
+TEST(PathfinderGenerateTest, GaussTrajectoryMatchesTrapezoidTrajectory) {
+  Waypoint points[] = {{0, 0, 0}, {1, 0.5, d2r(45)}, {2, 0, 0}};
+
+  TrajectoryCandidate gaussCandidate;
+  pathfinder_prepare(
+    points, 3, FIT_HERMITE_CUBIC, PATHFINDER_SAMPLES_GAUSS, 0.001, 1, 2, 10, &gaussCandidate);
+  TrajectoryCandidate trapezoidCandidate;
+  pathfinder_prepare(
+    points, 3, FIT_HERMITE_CUBIC, PATHFINDER_SAMPLES_HIGH, 0.001, 1, 2, 10, &trapezoidCandidate);
+
+  ASSERT_EQ(gaussCandidate.length, trapezoidCandidate.length);
+
+  std::vector<Segment> gauss(gaussCandidate.length);
+  std::vector<Segment> trapezoid(trapezoidCandidate.length);
+  pathfinder_generate(&gaussCandidate, gauss.data());
+  pathfinder_generate(&trapezoidCandidate, trapezoid.data());
+
+  for (std::size_t i = 0; i < gauss.size(); i++) {
+    EXPECT_NEAR(gauss[i].x, trapezoid[i].x, 1e-3);
+    EXPECT_NEAR(gauss[i].y, trapezoid[i].y, 1e-3);
+    // Headings near zero can wrap to either side of TAU
+    EXPECT_NEAR(std::remainder(gauss[i].heading - trapezoid[i].heading, TAU), 0, 1e-3);
+  }
+}
+
+class PathfinderPrepareTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    for (int i = 0; i < 20; i++) {
+      points.push_back(Waypoint{i * 0.5, (i % 2) * 0.25, d2r(i % 3 * 15)});
+    }
+
+    pathfinder_prepare(points.data(),
+                       static_cast<int>(points.size()),
+                       FIT_HERMITE_CUBIC,
+                       PATHFINDER_SAMPLES_FAST,
+                       0.001,
+                       1,
+                       2,
+                       10,
+                       &serial);
+  }
+
+  void TearDown() override {
+    pathfinder_candidate_free(&serial);
+  }
+
+  void expectCandidatesEqual(const TrajectoryCandidate &expected,
+                             const TrajectoryCandidate &actual) {
+    const int splines = static_cast<int>(points.size()) - 1;
+    EXPECT_EQ(expected.length, actual.length);
+    EXPECT_EQ(expected.totalLength, actual.totalLength);
+    EXPECT_EQ(memcmp(expected.saptr, actual.saptr, splines * sizeof(Spline)), 0);
+    EXPECT_EQ(memcmp(expected.laptr, actual.laptr, splines * sizeof(double)), 0);
+    EXPECT_EQ(memcmp(expected.taptr,
+                     actual.taptr,
+                     splines * (PATHFINDER_SAMPLES_FAST + 1) * sizeof(double)),
+              0);
+  }
+
+  std::vector<Waypoint> points;
+  TrajectoryCandidate serial;
+};
+
+// Measures the splines last to first to make sure the order does not matter
+static void reversedParallelFor(int count, void (*body)(void *, int), void *context, void *) {
+  for (int i = count - 1; i >= 0; i--) {
+    body(context, i);
+  }
+}
+
+TEST_F(PathfinderPrepareTest, ParallelPrepareInAnyOrderMatchesSerialPrepare) {
+  TrajectoryCandidate parallel;
+  pathfinder_prepare_parallel(points.data(),
+                              static_cast<int>(points.size()),
+                              FIT_HERMITE_CUBIC,
+                              PATHFINDER_SAMPLES_FAST,
+                              0.001,
+                              1,
+                              2,
+                              10,
+                              &parallel,
+                              reversedParallelFor,
+                              nullptr);
+
+  expectCandidatesEqual(serial, parallel);
+  pathfinder_candidate_free(&parallel);
+}
+
+TEST_F(PathfinderPrepareTest, ParallelPrepareWithThreadsMatchesSerialPrepare) {
+  std::size_t threads = 4;
+  TrajectoryCandidate parallel;
+  pathfinder_prepare_parallel(points.data(),
+                              static_cast<int>(points.size()),
+                              FIT_HERMITE_CUBIC,
+                              PATHFINDER_SAMPLES_FAST,
+                              0.001,
+                              1,
+                              2,
+                              10,
+                              &parallel,
+                              okapi::pathfinderParallelFor,
+                              &threads);
+
+  expectCandidatesEqual(serial, parallel);
+  pathfinder_candidate_free(&parallel);
+}
+
+TEST(PathfinderTrajectoryTest, SecondOrderFilterMatchesWindowedSum) {
+  TrajectoryConfig config{0.001, 1.3, 2.7, 9.1, 0, 0, 2.2, 0, 0, PATHFINDER_SAMPLES_FAST};
+  TrajectoryInfo info = pf_trajectory_prepare(config);
+
+  std::vector<Segment> trajectory(info.length);
+  ASSERT_EQ(pf_trajectory_fromSecondOrderFilter(info.filter1,
+                                                info.filter2,
+                                                info.dt,
+                                                info.u,
+                                                info.v,
+                                                info.impulse,
+                                                info.length,
+                                                trajectory.data()),
+            0);
+
+  // Reference implementation which sums the whole window for every sample
+  std::vector<double> f1(info.length);
+  double impulse = info.impulse;
+  for (int i = 0; i < info.length; i++) {
+    double input = std::min(impulse, 1.0);
+    if (input < 1) {
+      input -= 1;
+      impulse = 0;
+    } else {
+      impulse -= input;
+    }
+
+    f1[i] = std::max(0.0, std::min<double>(info.filter1, (i > 0 ? f1[i - 1] : 0) + input));
+
+    double f2 = 0;
+    for (int j = 0; j < info.filter2 && i - j >= 0; j++) {
+      f2 += f1[i - j];
+    }
+
+    EXPECT_NEAR(trajectory[i].velocity, f2 / info.filter1 / info.filter2 * info.v, 1e-12);
+  }
+}
+
+class PathfinderModifierTest : public ::testing::Test {
+  protected:
+  void prepare(TrajectoryCandidate *candidate) {
+    Waypoint points[] = {{0, 0, 0}, {1, 0.5, d2r(45)}, {2, 0, 0}};
+    pathfinder_prepare(
+      points, 3, FIT_HERMITE_CUBIC, PATHFINDER_SAMPLES_FAST, 0.001, 1, 2, 10, candidate);
+  }
+
+  void expectSegmentsEqual(const std::vector<Segment> &expected,
+                           const std::vector<Segment> &actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    EXPECT_EQ(memcmp(expected.data(), actual.data(), expected.size() * sizeof(Segment)), 0);
+  }
+};
+
+TEST_F(PathfinderModifierTest, GenerateTankMatchesGenerateThenModify) {
+  TrajectoryCandidate candidate;
+  prepare(&candidate);
+  std::vector<Segment> center(candidate.length);
+  std::vector<Segment> left(candidate.length);
+  std::vector<Segment> right(candidate.length);
+  pathfinder_generate(&candidate, center.data());
+  pathfinder_modify_tank(center.data(), candidate.length, left.data(), right.data(), 0.3);
+
+  TrajectoryCandidate fusedCandidate;
+  prepare(&fusedCandidate);
+  std::vector<Segment> fusedLeft(fusedCandidate.length);
+  std::vector<Segment> fusedRight(fusedCandidate.length);
+  EXPECT_EQ(
+    pathfinder_generate_tank(&fusedCandidate, fusedLeft.data(), fusedRight.data(), 0.3),
+    candidate.length);
+
+  expectSegmentsEqual(left, fusedLeft);
+  expectSegmentsEqual(right, fusedRight);
+}
+
+TEST_F(PathfinderModifierTest, GenerateSwerveMatchesGenerateThenModify) {
+  TrajectoryCandidate candidate;
+  prepare(&candidate);
+  std::vector<Segment> center(candidate.length);
+  std::vector<std::vector<Segment>> wheels(4, std::vector<Segment>(candidate.length));
+  pathfinder_generate(&candidate, center.data());
+  pathfinder_modify_swerve(center.data(),
+                           candidate.length,
+                           wheels[0].data(),
+                           wheels[1].data(),
+                           wheels[2].data(),
+                           wheels[3].data(),
+                           0.3,
+                           0.4,
+                           SWERVE_DEFAULT);
+
+  TrajectoryCandidate fusedCandidate;
+  prepare(&fusedCandidate);
+  std::vector<std::vector<Segment>> fusedWheels(4, std::vector<Segment>(fusedCandidate.length));
+  EXPECT_EQ(pathfinder_generate_swerve(&fusedCandidate,
+                                       fusedWheels[0].data(),
+                                       fusedWheels[1].data(),
+                                       fusedWheels[2].data(),
+                                       fusedWheels[3].data(),
+                                       0.3,
+                                       0.4,
+                                       SWERVE_DEFAULT),
+            candidate.length);
+
+  for (std::size_t i = 0; i < wheels.size(); i++) {
+    expectSegmentsEqual(wheels[i], fusedWheels[i]);
+  }
+}
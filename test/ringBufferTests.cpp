@@ -0,0 +1,138 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/mpscRingBuffer.hpp"
+#include "okapi/api/util/ringBuffer.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace okapi;
+
+TEST(RingBufferTest, PopFromEmptyBufferFails) {
+  RingBuffer<int, 4> buffer;
+  int value = 0;
+  EXPECT_FALSE(buffer.pop(value));
+  EXPECT_EQ(buffer.size(), 0);
+}
+
+TEST(RingBufferTest, ElementsArePoppedInOrder) {
+  RingBuffer<int, 4> buffer;
+  EXPECT_TRUE(buffer.push(1));
+  EXPECT_TRUE(buffer.push(2));
+  EXPECT_EQ(buffer.size(), 2);
+
+  int value = 0;
+  EXPECT_TRUE(buffer.pop(value));
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(buffer.pop(value));
+  EXPECT_EQ(value, 2);
+  EXPECT_FALSE(buffer.pop(value));
+}
+
+TEST(RingBufferTest, PushToFullBufferFails) {
+  RingBuffer<int, 4> buffer;
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(buffer.push(i));
+  }
+
+  EXPECT_FALSE(buffer.push(4));
+  EXPECT_EQ(buffer.size(), buffer.capacity());
+
+  // Popping makes room again, wrapping around the end of the storage
+  int value = 0;
+  EXPECT_TRUE(buffer.pop(value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(buffer.push(4));
+
+  for (int i = 1; i <= 4; i++) {
+    EXPECT_TRUE(buffer.pop(value));
+    EXPECT_EQ(value, i);
+  }
+}
+
+TEST(RingBufferTest, ProducerAndConsumerThreads) {
+  constexpr int count = 100000;
+  RingBuffer<int, 16> buffer;
+
+  std::thread producer([&]() {
+    for (int i = 0; i < count; i++) {
+      while (!buffer.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  while (expected < count) {
+    int value;
+    if (buffer.pop(value)) {
+      EXPECT_EQ(value, expected);
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  producer.join();
+  EXPECT_EQ(buffer.size(), 0);
+}
+
+TEST(MpscRingBufferTest, PushToFullBufferFails) {
+  MpscRingBuffer<int, 4> buffer;
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(buffer.push(i));
+  }
+
+  EXPECT_FALSE(buffer.push(4));
+  EXPECT_EQ(buffer.size(), buffer.capacity());
+
+  int value = 0;
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(buffer.pop(value));
+    EXPECT_EQ(value, i);
+  }
+
+  EXPECT_FALSE(buffer.pop(value));
+}
+
+TEST(MpscRingBufferTest, ManyProducerThreads) {
+  constexpr int producers = 4;
+  constexpr int count = 20000;
+  MpscRingBuffer<int, 16> buffer;
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p]() {
+      for (int i = 0; i < count; i++) {
+        while (!buffer.push(p * count + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Each producer's elements must come out in the order that producer pushed them
+  std::vector<int> next(producers, 0);
+  for (int popped = 0; popped < producers * count;) {
+    int value;
+    if (buffer.pop(value)) {
+      const int p = value / count;
+      EXPECT_EQ(value % count, next[p]);
+      next[p]++;
+      popped++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(buffer.size(), 0);
+}
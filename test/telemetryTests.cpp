@@ -0,0 +1,110 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/iterative/iterativePosPidController.hpp"
+#include "okapi/api/control/util/telemetryFile.hpp"
+#include "okapi/api/control/util/telemetryRecorder.hpp"
+#include "test/tests/api/implMocks.hpp"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace okapi;
+
+class TelemetryTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    recorder = std::make_unique<TelemetryRecorder>(std::make_unique<ConstantMockTimer>(10_ms), 4);
+  }
+
+  void TearDown() override {
+    std::remove(filename.c_str());
+    std::remove(csvFilename.c_str());
+  }
+
+  const std::string filename{"telemetry_test.bin"};
+  const std::string csvFilename{"telemetry_test.csv"};
+  std::unique_ptr<TelemetryRecorder> recorder;
+};
+
+TEST_F(TelemetryTest, OldestSamplesAreOverwritten) {
+  for (int i = 0; i < 6; i++) {
+    recorder->record(i, 0, 0, 0, 0, 0, 0);
+  }
+
+  const auto samples = recorder->getSamples();
+  ASSERT_EQ(samples.size(), 4);
+  EXPECT_EQ(recorder->getOverwritten(), 2);
+  for (std::size_t i = 0; i < samples.size(); i++) {
+    EXPECT_FLOAT_EQ(samples[i].target, i + 2);
+  }
+
+  recorder->clear();
+  EXPECT_EQ(recorder->size(), 0);
+  EXPECT_EQ(recorder->getOverwritten(), 0);
+}
+
+TEST_F(TelemetryTest, DumpRoundTrips) {
+  recorder->record(1, 2, 3, 4, 5, 6, 7);
+  recorder->record(-1, -2, -3, -4, -5, -6, -7);
+  ASSERT_TRUE(recorder->dump(filename));
+
+  std::vector<TelemetrySample> samples;
+  ASSERT_TRUE(TelemetryFile::read(filename, samples));
+  ASSERT_EQ(samples.size(), 2);
+  EXPECT_EQ(samples[0].time, 0);
+  EXPECT_FLOAT_EQ(samples[0].target, 1);
+  EXPECT_FLOAT_EQ(samples[0].output, 7);
+  EXPECT_FLOAT_EQ(samples[1].reading, -2);
+  EXPECT_FLOAT_EQ(samples[1].derivative, -6);
+}
+
+TEST_F(TelemetryTest, DecodesToCsv) {
+  recorder->record(1, 0.5, 0.5, 0.25, 0, 0, 0.25);
+  ASSERT_TRUE(recorder->dump(filename));
+  ASSERT_TRUE(TelemetryFile::toCsv(filename, csvFilename));
+
+  std::ifstream csv(csvFilename);
+  std::stringstream contents;
+  contents << csv.rdbuf();
+  EXPECT_EQ(contents.str(),
+            "time_ms,target,reading,error,proportional,integral,derivative,output\n"
+            "0,1,0.5,0.5,0.25,0,0,0.25\n");
+}
+
+TEST_F(TelemetryTest, InvalidFileIsRejected) {
+  std::ofstream(filename) << "not telemetry";
+
+  std::vector<TelemetrySample> samples;
+  EXPECT_FALSE(TelemetryFile::read(filename, samples));
+  EXPECT_FALSE(TelemetryFile::read("missing_telemetry.bin", samples));
+  EXPECT_FALSE(TelemetryFile::toCsv(filename, csvFilename));
+}
+
+TEST_F(TelemetryTest, PIDControllerRecordsEachStep) {
+  auto pidRecorder =
+    std::make_shared<TelemetryRecorder>(std::make_unique<ConstantMockTimer>(10_ms));
+  IterativePosPIDController controller(0.1, 0, 0, 0, createConstantTimeUtil(10_ms));
+  controller.setTelemetryRecorder(pidRecorder);
+  controller.setTarget(1);
+  controller.step(0);
+  controller.step(0.5);
+
+  const auto samples = pidRecorder->getSamples();
+  ASSERT_EQ(samples.size(), 2);
+  EXPECT_FLOAT_EQ(samples[1].target, 1);
+  EXPECT_FLOAT_EQ(samples[1].reading, 0.5);
+  EXPECT_FLOAT_EQ(samples[1].error, 0.5);
+  EXPECT_FLOAT_EQ(samples[1].proportional, 0.05);
+  EXPECT_FLOAT_EQ(samples[1].output, 0.05);
+
+  controller.setTelemetryRecorder(nullptr);
+  controller.step(0.5);
+  EXPECT_EQ(pidRecorder->size(), 2);
+}
@@ -0,0 +1,139 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryCache.hpp"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace okapi;
+
+class TrajectoryCacheTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    for (int i = 0; i < 10; i++) {
+      segments.push_back(
+        Segment{0.01, i + 0.1, i + 0.2, i + 0.3, i + 0.4, i + 0.5, i + 0.6, i + 0.7});
+    }
+
+    key = TrajectoryCache::KeyBuilder().add("TrajectoryCacheTest").add(1.0).get();
+  }
+
+  void TearDown() override {
+    cache.invalidate(key);
+  }
+
+  TrajectoryCache cache{::testing::TempDir()};
+  std::vector<Segment> segments;
+  std::uint64_t key;
+};
+
+TEST_F(TrajectoryCacheTest, KeyChangesWithEveryParameter) {
+  const auto base = TrajectoryCache::KeyBuilder().add(1.0).add(2.0).get();
+
+  EXPECT_EQ(TrajectoryCache::KeyBuilder().add(1.0).add(2.0).get(), base);
+  EXPECT_NE(TrajectoryCache::KeyBuilder().add(1.0).add(2.0000001).get(), base);
+  EXPECT_NE(TrajectoryCache::KeyBuilder().add(2.0).add(1.0).get(), base);
+  EXPECT_NE(TrajectoryCache::KeyBuilder().add(1.0).get(), base);
+  EXPECT_NE(TrajectoryCache::KeyBuilder().add(1.0).add(2.0).add(std::int64_t{0}).get(), base);
+}
+
+TEST_F(TrajectoryCacheTest, MissWhenNothingIsStored) {
+  std::vector<CompactTrajectory> trajectories;
+
+  EXPECT_FALSE(cache.load(key, {}, trajectories));
+  EXPECT_TRUE(trajectories.empty());
+  EXPECT_EQ(cache.getHits(), 0);
+  EXPECT_EQ(cache.getMisses(), 1);
+}
+
+TEST_F(TrajectoryCacheTest, StoredTrajectoriesAreLoaded) {
+  const CompactTrajectory left(segments.data(), segments.size(), {});
+  const CompactTrajectory right(segments.data(), 5, {});
+  ASSERT_TRUE(cache.store(key, {&left, &right}));
+
+  std::vector<CompactTrajectory> trajectories;
+  ASSERT_TRUE(cache.load(key, {}, trajectories));
+  EXPECT_EQ(cache.getHits(), 1);
+  EXPECT_EQ(cache.getMisses(), 0);
+
+  ASSERT_EQ(trajectories.size(), 2);
+  ASSERT_EQ(trajectories[0].size(), segments.size());
+  ASSERT_EQ(trajectories[1].size(), 5);
+  for (std::size_t i = 0; i < segments.size(); i++) {
+    const Segment segment = trajectories[0].getSegment(i);
+    EXPECT_EQ(segment.dt, segments[i].dt);
+    EXPECT_EQ(segment.x, segments[i].x);
+    EXPECT_EQ(segment.position, segments[i].position);
+    EXPECT_EQ(segment.velocity, segments[i].velocity);
+    EXPECT_EQ(segment.heading, segments[i].heading);
+  }
+}
+
+TEST_F(TrajectoryCacheTest, LoadsIntoRequestedFormat) {
+  const CompactTrajectory trajectory(segments.data(), segments.size(), {});
+  ASSERT_TRUE(cache.store(key, {&trajectory}));
+
+  std::vector<CompactTrajectory> trajectories;
+  ASSERT_TRUE(cache.load(
+    key, {CompactTrajectory::mask({CompactTrajectory::Field::velocity})}, trajectories));
+
+  ASSERT_EQ(trajectories.size(), 1);
+  EXPECT_FALSE(trajectories[0].hasField(CompactTrajectory::Field::position));
+  EXPECT_EQ(trajectories[0].get(CompactTrajectory::Field::velocity, 3), segments[3].velocity);
+}
+
+TEST_F(TrajectoryCacheTest, TruncatedFileIsAMiss) {
+  const CompactTrajectory trajectory(segments.data(), segments.size(), {});
+  ASSERT_TRUE(cache.store(key, {&trajectory}));
+
+  // Cut the file off in the middle of the segments
+  FILE *file = std::fopen(cache.getFilename(key).c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  std::vector<char> contents(100);
+  contents.resize(std::fread(contents.data(), 1, contents.size(), file));
+  std::fclose(file);
+
+  file = std::fopen(cache.getFilename(key).c_str(), "wb");
+  std::fwrite(contents.data(), 1, contents.size(), file);
+  std::fclose(file);
+
+  std::vector<CompactTrajectory> trajectories;
+  EXPECT_FALSE(cache.load(key, {}, trajectories));
+  EXPECT_EQ(cache.getMisses(), 1);
+}
+
+TEST_F(TrajectoryCacheTest, FileForADifferentKeyIsAMiss) {
+  const CompactTrajectory trajectory(segments.data(), segments.size(), {});
+  ASSERT_TRUE(cache.store(key, {&trajectory}));
+
+  const auto otherKey = TrajectoryCache::KeyBuilder().add("other").get();
+  std::rename(cache.getFilename(key).c_str(), cache.getFilename(otherKey).c_str());
+
+  std::vector<CompactTrajectory> trajectories;
+  EXPECT_FALSE(cache.load(otherKey, {}, trajectories));
+  cache.invalidate(otherKey);
+}
+
+TEST_F(TrajectoryCacheTest, FileIsOnlyVerifiedTheFirstTimeItIsLoaded) {
+  const CompactTrajectory trajectory(segments.data(), segments.size(), {});
+  ASSERT_TRUE(TrajectoryCache(::testing::TempDir()).store(key, {&trajectory}));
+
+  // Corrupt a byte of the data after this cache has verified the file
+  std::vector<CompactTrajectory> trajectories;
+  ASSERT_TRUE(cache.load(key, {}, trajectories));
+  FILE *file = std::fopen(cache.getFilename(key).c_str(), "r+b");
+  ASSERT_NE(file, nullptr);
+  std::fseek(file, 64 + 10, SEEK_SET);
+  std::fputc(0xFF, file);
+  std::fclose(file);
+
+  EXPECT_TRUE(cache.load(key, {}, trajectories));
+
+  // Another cache has not verified the file yet, so it finds the corruption
+  EXPECT_FALSE(TrajectoryCache(::testing::TempDir()).load(key, {}, trajectories));
+}
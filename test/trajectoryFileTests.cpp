@@ -0,0 +1,183 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryFile.hpp"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace okapi;
+
+class TrajectoryFileTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    for (int i = 0; i < 11; i++) {
+      segments.push_back(
+        Segment{0.01, i + 0.1, i + 0.2, i + 0.3, i + 0.4, i + 0.5, i + 0.6, i + 0.7});
+    }
+  }
+
+  void TearDown() override {
+    std::remove(filename.c_str());
+    std::remove(legacyFilename.c_str());
+  }
+
+  void expectSegmentsEqual(const CompactTrajectory &trajectory) {
+    ASSERT_EQ(trajectory.size(), segments.size());
+    EXPECT_EQ(trajectory.getDt(), segments[0].dt);
+    for (std::size_t i = 0; i < segments.size(); i++) {
+      const Segment segment = trajectory.getSegment(i);
+      EXPECT_EQ(segment.x, segments[i].x);
+      EXPECT_EQ(segment.y, segments[i].y);
+      EXPECT_EQ(segment.position, segments[i].position);
+      EXPECT_EQ(segment.velocity, segments[i].velocity);
+      EXPECT_EQ(segment.acceleration, segments[i].acceleration);
+      EXPECT_EQ(segment.jerk, segments[i].jerk);
+      EXPECT_EQ(segment.heading, segments[i].heading);
+    }
+  }
+
+  std::string filename{::testing::TempDir() + "/trajectoryFileTest.oktj"};
+  std::string legacyFilename{::testing::TempDir() + "/trajectoryFileTest.bin"};
+  std::vector<Segment> segments;
+};
+
+TEST_F(TrajectoryFileTest, MissingFileIsNotLoaded) {
+  std::vector<CompactTrajectory> trajectories;
+  EXPECT_FALSE(TrajectoryFile::read(filename, trajectories));
+}
+
+TEST_F(TrajectoryFileTest, TrajectoriesRoundTrip) {
+  const CompactTrajectory full(segments.data(), segments.size(), {});
+  const CompactTrajectory velocity(
+    segments.data(),
+    segments.size(),
+    {CompactTrajectory::mask({CompactTrajectory::Field::velocity}),
+     CompactTrajectory::Precision::float32});
+  ASSERT_TRUE(TrajectoryFile::write(filename, {&full, &velocity}, 42));
+
+  std::vector<CompactTrajectory> trajectories;
+  std::uint64_t id = 0;
+  ASSERT_TRUE(TrajectoryFile::read(filename, trajectories, &id));
+  EXPECT_EQ(id, 42);
+  ASSERT_EQ(trajectories.size(), 2);
+
+  expectSegmentsEqual(trajectories[0]);
+
+  EXPECT_EQ(trajectories[1].getFormat().fields, velocity.getFormat().fields);
+  EXPECT_EQ(trajectories[1].getFormat().precision, CompactTrajectory::Precision::float32);
+  for (std::size_t i = 0; i < segments.size(); i++) {
+    EXPECT_EQ(trajectories[1].get(CompactTrajectory::Field::velocity, i),
+              static_cast<float>(segments[i].velocity));
+  }
+}
+
+TEST_F(TrajectoryFileTest, TrajectoriesAreUsedInPlace) {
+  const CompactTrajectory first(segments.data(), segments.size(), {});
+  const CompactTrajectory second(segments.data(), segments.size(), {});
+  ASSERT_TRUE(TrajectoryFile::write(filename, {&first, &second}));
+
+  std::vector<CompactTrajectory> trajectories;
+  ASSERT_TRUE(TrajectoryFile::read(filename, trajectories));
+  ASSERT_EQ(trajectories.size(), 2);
+
+  // Both trajectories point into the same aligned buffer, one header after the other's data
+  const auto firstData = reinterpret_cast<std::uintptr_t>(trajectories[0].getData());
+  const auto secondData = reinterpret_cast<std::uintptr_t>(trajectories[1].getData());
+  EXPECT_EQ(firstData % TrajectoryFile::alignment, 0);
+  EXPECT_EQ(secondData % TrajectoryFile::alignment, 0);
+  EXPECT_EQ(secondData - firstData,
+            (first.getMemoryUsage() + TrajectoryFile::alignment - 1) / TrajectoryFile::alignment *
+                TrajectoryFile::alignment +
+              TrajectoryFile::headerSize);
+
+  // The data outlives the vector it was loaded into
+  CompactTrajectory kept(std::move(trajectories[1]));
+  trajectories.clear();
+  expectSegmentsEqual(kept);
+}
+
+TEST_F(TrajectoryFileTest, HeaderIsLittleEndian) {
+  const CompactTrajectory trajectory(segments.data(), segments.size(), {});
+  ASSERT_TRUE(TrajectoryFile::write(filename, {&trajectory}));
+
+  FILE *file = std::fopen(filename.c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  std::uint8_t header[TrajectoryFile::headerSize];
+  ASSERT_EQ(std::fread(header, 1, sizeof(header), file), sizeof(header));
+  std::fclose(file);
+
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(header), 4), "OKTJ");
+  EXPECT_EQ(header[4], TrajectoryFile::version);
+  EXPECT_EQ(header[5], 0);
+  EXPECT_EQ(header[8], segments.size());
+  EXPECT_EQ(header[9], 0);
+  EXPECT_EQ(header[12], CompactTrajectory::allFields);
+}
+
+TEST_F(TrajectoryFileTest, CorruptedDataIsNotLoaded) {
+  const CompactTrajectory trajectory(segments.data(), segments.size(), {});
+  ASSERT_TRUE(TrajectoryFile::write(filename, {&trajectory}));
+
+  FILE *file = std::fopen(filename.c_str(), "r+b");
+  ASSERT_NE(file, nullptr);
+  std::fseek(file, TrajectoryFile::headerSize + 10, SEEK_SET);
+  std::fputc(0xFF, file);
+  std::fclose(file);
+
+  std::vector<CompactTrajectory> trajectories;
+  EXPECT_FALSE(TrajectoryFile::read(filename, trajectories));
+}
+
+TEST_F(TrajectoryFileTest, CorruptedDataIsLoadedWithoutVerifying) {
+  const CompactTrajectory trajectory(segments.data(), segments.size(), {});
+  ASSERT_TRUE(TrajectoryFile::write(filename, {&trajectory}));
+
+  FILE *file = std::fopen(filename.c_str(), "r+b");
+  ASSERT_NE(file, nullptr);
+  std::fseek(file, TrajectoryFile::headerSize + 10, SEEK_SET);
+  std::fputc(0xFF, file);
+  std::fclose(file);
+
+  std::vector<CompactTrajectory> trajectories;
+  EXPECT_TRUE(TrajectoryFile::read(filename, trajectories, nullptr, false));
+  EXPECT_EQ(trajectories.size(), 1);
+}
+
+TEST_F(TrajectoryFileTest, ConvertLegacyFile) {
+  FILE *file = std::fopen(legacyFilename.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  pathfinder_serialize(file, segments.data(), static_cast<int>(segments.size()));
+  pathfinder_serialize(file, segments.data(), static_cast<int>(segments.size()));
+  std::fclose(file);
+
+  ASSERT_TRUE(TrajectoryFile::convertLegacy(legacyFilename, filename));
+
+  std::vector<CompactTrajectory> trajectories;
+  ASSERT_TRUE(TrajectoryFile::read(filename, trajectories));
+  ASSERT_EQ(trajectories.size(), 2);
+  expectSegmentsEqual(trajectories[0]);
+  expectSegmentsEqual(trajectories[1]);
+}
+
+TEST_F(TrajectoryFileTest, TruncatedLegacyFileIsNotConverted) {
+  FILE *file = std::fopen(legacyFilename.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  pathfinder_serialize(file, segments.data(), static_cast<int>(segments.size()));
+  std::fclose(file);
+
+  // Drop the last segment
+  file = std::fopen(legacyFilename.c_str(), "rb");
+  std::vector<char> contents(4 + 64 * (segments.size() - 1));
+  ASSERT_EQ(std::fread(contents.data(), 1, contents.size(), file), contents.size());
+  std::fclose(file);
+  file = std::fopen(legacyFilename.c_str(), "wb");
+  std::fwrite(contents.data(), 1, contents.size(), file);
+  std::fclose(file);
+
+  EXPECT_FALSE(TrajectoryFile::convertLegacy(legacyFilename, filename));
+}
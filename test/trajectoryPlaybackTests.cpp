@@ -0,0 +1,176 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryPlayback.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace okapi;
+
+/**
+ * A timer and rate which share a simulated clock. The rate advances the clock like
+ * pros::Task::delay_until(), so waits are measured from the previous deadline.
+ */
+class SimulatedClockTimer : public AbstractTimer {
+  public:
+  explicit SimulatedClockTimer(const std::uint32_t &inow)
+    : AbstractTimer(inow * millisecond), now(inow) {
+  }
+
+  QTime millis() const override {
+    return now * millisecond;
+  }
+
+  const std::uint32_t &now;
+};
+
+class SimulatedClockRate : public AbstractRate {
+  public:
+  explicit SimulatedClockRate(std::uint32_t &inow) : now(inow) {
+  }
+
+  void delay(QFrequency ihz) override {
+    delayUntil(1000 / ihz.convert(Hz));
+  }
+
+  void delay(int ihz) override {
+    delayUntil(1000 / ihz);
+  }
+
+  void delayUntil(QTime itime) override {
+    delayUntil(itime.convert(millisecond));
+  }
+
+  void delayUntil(std::uint32_t ims) override {
+    if (lastTime == 0) {
+      lastTime = now;
+    }
+
+    lastTime += ims;
+    now = std::max(now, lastTime);
+  }
+
+  std::uint32_t &now;
+  std::uint32_t lastTime{0};
+};
+
+class TrajectoryPlaybackTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    playback = std::make_unique<TrajectoryPlayback>(std::make_unique<SimulatedClockTimer>(now),
+                                                    std::make_unique<SimulatedClockRate>(now),
+                                                    10_ms);
+  }
+
+  void assertIndicesEqual(const std::vector<double> &iactual,
+                          const std::vector<double> &iexpected) {
+    ASSERT_EQ(iactual.size(), iexpected.size());
+    for (std::size_t i = 0; i < iactual.size(); i++) {
+      // Converting through QTime is not exact
+      EXPECT_NEAR(iactual[i], iexpected[i], 1e-9);
+    }
+  }
+
+  std::uint32_t now{1000};
+  std::unique_ptr<TrajectoryPlayback> playback;
+};
+
+TEST_F(TrajectoryPlaybackTest, SamplesOncePerPeriod) {
+  std::vector<double> indices;
+  playback->play(101, 1_ms, [&](double index) {
+    indices.push_back(index);
+    return true;
+  });
+
+  assertIndicesEqual(indices, {0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100});
+  EXPECT_EQ(playback->getTicks(), 11);
+  EXPECT_EQ(playback->getSkippedTicks(), 0);
+}
+
+TEST_F(TrajectoryPlaybackTest, LastSegmentIsAlwaysSampled) {
+  std::vector<double> indices;
+  playback->play(95, 1_ms, [&](double index) {
+    indices.push_back(index);
+    return true;
+  });
+
+  assertIndicesEqual(indices, {0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 94});
+}
+
+TEST_F(TrajectoryPlaybackTest, ZeroPeriodSamplesEverySegment) {
+  TrajectoryPlayback everySegment(std::make_unique<SimulatedClockTimer>(now),
+                                  std::make_unique<SimulatedClockRate>(now),
+                                  0_ms);
+  std::vector<double> indices;
+  everySegment.play(5, 2_ms, [&](double index) {
+    indices.push_back(index);
+    return true;
+  });
+
+  assertIndicesEqual(indices, {0, 1, 2, 3, 4});
+  EXPECT_EQ(everySegment.getSkippedTicks(), 0);
+}
+
+TEST_F(TrajectoryPlaybackTest, OverrunSkipsAheadWithoutDrifting) {
+  std::vector<double> indices;
+  playback->play(101, 1_ms, [&](double index) {
+    indices.push_back(index);
+    if (indices.size() == 2) {
+      // Overrun the tick at 10 ms so the ticks at 20 ms and 30 ms are missed
+      now += 25;
+    }
+    return true;
+  });
+
+  assertIndicesEqual(indices, {0, 10, 40, 50, 60, 70, 80, 90, 100});
+  EXPECT_EQ(playback->getSkippedTicks(), 2);
+}
+
+TEST_F(TrajectoryPlaybackTest, OverrunIsRecordedAsADeadlineMiss) {
+  auto stats = std::make_shared<LoopTimingStats>();
+  auto rate = std::make_unique<SimulatedClockRate>(now);
+  rate->trackDeadlines(stats);
+  playback = std::make_unique<TrajectoryPlayback>(
+    std::make_unique<SimulatedClockTimer>(now), std::move(rate), 10_ms);
+
+  int ticks = 0;
+  playback->play(101, 1_ms, [&](double) {
+    if (++ticks == 2) {
+      now += 25;
+    }
+    return true;
+  });
+
+  EXPECT_EQ(stats->getMisses(), 1);
+}
+
+TEST_F(TrajectoryPlaybackTest, StopsWhenSampleReturnsFalse) {
+  playback->play(101, 1_ms, [&](double index) { return index < 30; });
+
+  EXPECT_EQ(playback->getTicks(), 4);
+}
+
+TEST_F(TrajectoryPlaybackTest, IndexScalesWithDt) {
+  std::vector<double> indices;
+  playback->play(5, 20_ms, [&](double index) {
+    indices.push_back(index);
+    return true;
+  });
+
+  assertIndicesEqual(indices, {0, 0.5, 1, 1.5, 2, 2.5, 3, 3.5, 4});
+}
+
+TEST_F(TrajectoryPlaybackTest, EmptyTrajectoryIsNotSampled) {
+  bool called = false;
+  playback->play(0, 1_ms, [&](double) {
+    called = true;
+    return true;
+  });
+
+  EXPECT_FALSE(called);
+  EXPECT_EQ(playback->getTicks(), 0);
+}
@@ -0,0 +1,124 @@
+/**
+ * @author Ryan Benasutti, WPI
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/settledUtil.hpp"
+#include "okapi/api/util/virtualClock.hpp"
+#include <chrono>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace okapi;
+
+using Events = std::vector<std::pair<std::string, double>>;
+
+/**
+ * Runs two tasks with different periods until 15 ms of simulated time and returns when each one
+ * woke up.
+ */
+static Events runTwoTasks() {
+  auto clock = std::make_shared<VirtualClock>(2);
+  const QTime start = clock->millis();
+  CrossplatformMutex mutex;
+  Events events;
+
+  const auto task = [&](const std::string &iname, const std::uint32_t iperiod) {
+    auto rate = clock->createRate();
+    while (true) {
+      rate->delayUntil(iperiod);
+
+      std::lock_guard<CrossplatformMutex> lock(mutex);
+      // Converting through QTime is not exact
+      const double now = std::round((clock->millis() - start).convert(millisecond));
+      events.emplace_back(iname, now);
+      if (now >= 15) {
+        return;
+      }
+    }
+  };
+
+  std::thread a(task, "A", 3);
+  std::thread b(task, "B", 5);
+  a.join();
+  b.join();
+  return events;
+}
+
+TEST(VirtualClockTest, DelayAdvancesSimulatedTime) {
+  auto clock = std::make_shared<VirtualClock>();
+  auto timer = clock->createTimer();
+  auto rate = clock->createRate();
+  const QTime start = timer->millis();
+
+  const auto realStart = std::chrono::steady_clock::now();
+  rate->delayUntil(5_s);
+  EXPECT_EQ(timer->millis() - start, 5_s);
+  EXPECT_LT(std::chrono::steady_clock::now() - realStart, std::chrono::seconds(1));
+}
+
+TEST(VirtualClockTest, DelaysAreMeasuredFromThePreviousDeadline) {
+  auto clock = std::make_shared<VirtualClock>();
+  auto rate = clock->createRate();
+  const QTime start = clock->millis();
+  for (int i = 0; i < 3; i++) {
+    rate->delayUntil(10_ms);
+  }
+
+  EXPECT_EQ(clock->millis() - start, 30_ms);
+}
+
+TEST(VirtualClockTest, TasksTakeTurnsInWakeupOrder) {
+  const Events expected{
+    {"A", 3}, {"B", 5}, {"A", 6}, {"A", 9}, {"B", 10}, {"A", 12}, {"B", 15}, {"A", 15}};
+
+  EXPECT_EQ(runTwoTasks(), expected);
+  EXPECT_EQ(runTwoTasks(), expected);
+}
+
+TEST(VirtualClockTest, DestroyingARateLeavesTheClock) {
+  auto clock = std::make_shared<VirtualClock>();
+  const QTime start = clock->millis();
+  {
+    auto rate = clock->createRate();
+    rate->delayUntil(10_ms);
+  }
+
+  // This thread left with its rate, so the other thread does not wait for it
+  std::thread other([&]() { clock->createRate()->delayUntil(20_ms); });
+  other.join();
+
+  EXPECT_EQ(clock->millis() - start, 30_ms);
+}
+
+TEST(VirtualClockTest, TimeWaitsForJoinedThreads) {
+  auto clock = std::make_shared<VirtualClock>();
+  const QTime start = clock->millis();
+  const auto self = clock->join();
+
+  std::thread other([&]() { clock->createRate()->delayUntil(10_ms); });
+
+  // However long this thread takes, time does not pass until it waits or leaves
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(clock->millis(), start);
+
+  clock->leave(self);
+  other.join();
+  EXPECT_EQ(std::round((clock->millis() - start).convert(millisecond)), 10);
+}
+
+TEST(VirtualClockTest, SettledUtilUsesSimulatedTime) {
+  auto clock = std::make_shared<VirtualClock>();
+  auto settledUtil = clock->createTimeUtil(50, 5, 250_ms).getSettledUtil();
+  auto rate = clock->createRate();
+
+  EXPECT_FALSE(settledUtil->isSettled(0));
+  rate->delayUntil(300_ms);
+  EXPECT_TRUE(settledUtil->isSettled(0));
+}